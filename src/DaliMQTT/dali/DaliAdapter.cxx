@@ -451,6 +451,33 @@ namespace daliMQTT
         return std::nullopt;
     }
 
+    std::optional<bool> DaliAdapter::hasGearWithoutShortAddress() {
+        int16_t result;
+        {
+            std::lock_guard lock(bus_mutex);
+            result = m_dali_impl.cmd(DALI_COMMAND_QUERY_MISSING_SHORT_ADDRESS, 0x7F);
+        }
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_DALI2MQTT_DALI_INTER_FRAME_DELAY_MS));
+
+        if (result >= 0 || result == -DALI_RESULT_COLLISION || result == -DALI_RESULT_INVALID_REPLY) return true;
+        if (result == -DALI_RESULT_NO_REPLY) return false;
+        return std::nullopt;
+    }
+
+    std::optional<uint8_t> DaliAdapter::getDimmingCurve(const uint8_t shortAddress) {
+        std::lock_guard lock(bus_mutex);
+        m_dali_impl.cmd(DALI_SPECIAL_COMMAND_ENABLE_DEVICE_TYPE_X | 0x0100, 6, false);
+
+        const int16_t result = m_dali_impl.cmd(DALI_QUERY_DIMMING_CURVE, shortAddress);
+
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_DALI2MQTT_DALI_INTER_FRAME_DELAY_MS));
+
+        if (result >= 0) {
+            return static_cast<uint8_t>(result);
+        }
+        return std::nullopt;
+    }
+
     std::optional<uint8_t> DaliAdapter::readMemoryLocation(const uint8_t shortAddress, const uint8_t bank, const uint8_t offset) {
         std::lock_guard lock(bus_mutex);
 
@@ -506,6 +533,30 @@ namespace daliMQTT
         return DaliRGB{ *r, *g, *b };
     }
 
+    std::optional<DaliSceneColor> DaliAdapter::getDT8SceneColor(const uint8_t shortAddress, const uint8_t scene, const bool read_tc, const bool read_rgb) {
+        std::lock_guard lock(bus_mutex);
+        if (!sendQuery(DALI_ADDRESS_TYPE_SHORT, shortAddress, DALI_COMMAND_QUERY_SCENE_LEVEL_0 + (scene & 0x0F))) {
+            return std::nullopt;
+        }
+
+        DaliSceneColor result{.known = true};
+        if (read_tc) {
+            const auto msb = queryDT8Value(shortAddress, DALI_DT8_REPORT_COLOUR_SELECTOR_OFFSET | 0x00);
+            const auto lsb = queryDT8Value(shortAddress, DALI_DT8_REPORT_COLOUR_SELECTOR_OFFSET | 0x01);
+            if (!msb || !lsb) return std::nullopt;
+            const uint16_t mireds = (static_cast<uint16_t>(*msb) << 8) | *lsb;
+            if (mireds != 0xFFFF) result.tc = mireds; // MASK: scene does not store a Tc
+        }
+        if (read_rgb) {
+            const auto r = queryDT8Value(shortAddress, DALI_DT8_REPORT_COLOUR_SELECTOR_OFFSET | 0x00);
+            const auto g = queryDT8Value(shortAddress, DALI_DT8_REPORT_COLOUR_SELECTOR_OFFSET | 0x01);
+            const auto b = queryDT8Value(shortAddress, DALI_DT8_REPORT_COLOUR_SELECTOR_OFFSET | 0x02);
+            if (!r || !g || !b) return std::nullopt;
+            if (*r != 0xFF || *g != 0xFF || *b != 0xFF) result.rgb = DaliRGB{ *r, *g, *b };
+        }
+        return result;
+    }
+
     bool DaliAdapter::isInitialized() const {
         return m_initialized;
     }
@@ -41,6 +41,12 @@ namespace daliMQTT
          */
         [[nodiscard]] std::optional<uint8_t> sendRaw(uint32_t data, uint8_t bits = 16, bool reply = true);
 
+        /**
+         * @brief Holds the bus for a sequence of frames.
+         * Other tasks wait until the returned lock is released; this task may keep sending meanwhile.
+         */
+        [[nodiscard]] std::unique_lock<std::recursive_mutex> reserveBus() { return std::unique_lock(bus_mutex); }
+
         /**
          * @brief Sets DT8 Color Temperature (Tc).
          */
@@ -94,8 +100,18 @@ namespace daliMQTT
          */
         [[nodiscard]] std::optional<std::bitset<16>> getDeviceGroups(uint8_t shortAddress);
 
+        /**
+         * @brief Broadcast QUERY MISSING SHORT ADDRESS.
+         * Several answers collide, so any backward frame, valid or not, counts as a yes.
+         * @return std::nullopt if the query could not be sent.
+         */
+        [[nodiscard]] std::optional<bool> hasGearWithoutShortAddress();
+
         [[nodiscard]] std::optional<uint8_t> getDT8Features(uint8_t shortAddress);
 
+        /** DT6 QUERY DIMMING CURVE: 0 standard (logarithmic), 1 linear. */
+        [[nodiscard]] std::optional<uint8_t> getDimmingCurve(uint8_t shortAddress);
+
         std::optional<uint8_t> getDeviceType(uint8_t shortAddress);
 
         std::optional<std::string> getGTIN(uint8_t shortAddress);
@@ -117,6 +133,13 @@ namespace daliMQTT
          */
         [[nodiscard]] std::optional<DaliRGB> getDT8RGB(uint8_t shortAddress);
 
+        /**
+         * @brief Reads the colour stored with a scene.
+         * QUERY SCENE LEVEL loads the scene colour into the report colour registers,
+         * which are then read back with QUERY COLOUR VALUE.
+         */
+        [[nodiscard]] std::optional<DaliSceneColor> getDT8SceneColor(uint8_t shortAddress, uint8_t scene, bool read_tc, bool read_rgb);
+
         /**
          * @brief Gets the long address of a device by short address.
          */
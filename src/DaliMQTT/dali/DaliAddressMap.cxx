@@ -63,6 +63,14 @@ namespace daliMQTT
                 dev.max_level = record.max_level;
                 dev.power_on_level = record.power_on_level;
                 dev.system_failure_level = record.system_failure_restore_level;
+                if ((record.fade_time_rate & 0x0F) != 0) { // fade rate 0 is invalid, marks unknown
+                    dev.fade_time = record.fade_time_rate >> 4;
+                    dev.fade_rate = record.fade_time_rate & 0x0F;
+                }
+                dev.extended_fade_time = record.extended_fade_time;
+                if (record.dimming_curve == static_cast<uint8_t>(DimmingCurve::Linear)) {
+                    dev.dimming_curve = DimmingCurve::Linear;
+                }
                 if (dev.device_type.has_value() || !dev.gtin.empty()) {
                     dev.static_data_loaded = true;
                 }
@@ -71,11 +79,102 @@ namespace daliMQTT
             }
             short_to_long[record.short_address] = record.long_address;
         }
-        
+        loadSceneTables(nvs_handle.get(), devices);
+
         ESP_LOGI(TAG, "Successfully loaded %zu DALI address mappings from NVS.", devices.size());
         return true;
     }
 
+    void DaliAddressMap::loadSceneTables(const nvs_handle_t handle, std::map<DaliLongAddress_t, DaliDevice>& devices) {
+        size_t required_size = 0;
+        esp_err_t err = nvs_get_blob(handle, SCENES_KEY, nullptr, &required_size);
+        if (err != ESP_OK || required_size == 0) {
+            ESP_LOGI(TAG, "No DALI scene tables found in NVS, they will be read from the bus.");
+            return;
+        }
+        if (required_size < sizeof(SceneBlobHeader) ||
+            (required_size - sizeof(SceneBlobHeader)) % sizeof(SceneTableMapping) != 0) {
+            ESP_LOGW(TAG, "Scene tables blob has an unknown layout, they will be read from the bus.");
+            return;
+        }
+
+        std::vector<uint8_t> blob(required_size);
+        err = nvs_get_blob(handle, SCENES_KEY, blob.data(), &required_size);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Error reading scene tables blob: %s", esp_err_to_name(err));
+            return;
+        }
+
+        SceneBlobHeader header{};
+        std::memcpy(&header, blob.data(), sizeof(header));
+        if (header.version != SCENES_BLOB_VERSION ||
+            required_size != sizeof(SceneBlobHeader) + header.count * sizeof(SceneTableMapping)) {
+            ESP_LOGW(TAG, "Scene tables blob version %u not supported, they will be read from the bus.", header.version);
+            return;
+        }
+        std::vector<SceneTableMapping> tables(header.count);
+        std::memcpy(tables.data(), blob.data() + sizeof(SceneBlobHeader), header.count * sizeof(SceneTableMapping));
+
+        for (const auto& record : tables) {
+            const auto it = devices.find(record.long_address);
+            if (it == devices.end()) continue;
+            auto* gear = std::get_if<ControlGear>(&it->second);
+            if (!gear) continue;
+
+            std::array<uint8_t, 16> levels{};
+            std::copy(std::begin(record.levels), std::end(record.levels), levels.begin());
+            gear->scene_levels = levels;
+            if (!gear->color.has_value()) continue;
+            for (uint8_t scene = 0; scene < 16; ++scene) {
+                auto& color = gear->color->scene_colors[scene];
+                const uint16_t bit = 1u << scene;
+                color.known = (record.color_known & bit) != 0;
+                if (record.has_tc & bit) color.tc = record.tc[scene];
+                if (record.has_rgb & bit) color.rgb = DaliRGB{record.rgb[scene][0], record.rgb[scene][1], record.rgb[scene][2]};
+            }
+        }
+    }
+
+    esp_err_t DaliAddressMap::saveSceneTables(const nvs_handle_t handle, const std::map<DaliLongAddress_t, DaliDevice>& devices) {
+        std::vector<SceneTableMapping> tables;
+        for (const auto& device_var : devices | std::views::values) {
+            const auto* gear = std::get_if<ControlGear>(&device_var);
+            if (!gear || !gear->scene_levels.has_value()) continue;
+
+            SceneTableMapping record{};
+            record.long_address = gear->long_address;
+            std::ranges::copy(*gear->scene_levels, record.levels);
+            if (gear->color.has_value()) {
+                for (uint8_t scene = 0; scene < 16; ++scene) {
+                    const auto& color = gear->color->scene_colors[scene];
+                    const uint16_t bit = 1u << scene;
+                    if (color.known) record.color_known |= bit;
+                    if (color.tc) {
+                        record.has_tc |= bit;
+                        record.tc[scene] = *color.tc;
+                    }
+                    if (color.rgb) {
+                        record.has_rgb |= bit;
+                        record.rgb[scene][0] = color.rgb->r;
+                        record.rgb[scene][1] = color.rgb->g;
+                        record.rgb[scene][2] = color.rgb->b;
+                    }
+                }
+            }
+            tables.push_back(record);
+        }
+
+        if (tables.empty()) {
+            const esp_err_t err = nvs_erase_key(handle, SCENES_KEY);
+            return err == ESP_ERR_NVS_NOT_FOUND ? ESP_OK : err;
+        }
+        const SceneBlobHeader header{SCENES_BLOB_VERSION, static_cast<uint16_t>(tables.size())};
+        std::vector<uint8_t> blob(sizeof(SceneBlobHeader) + tables.size() * sizeof(SceneTableMapping));
+        std::memcpy(blob.data(), &header, sizeof(header));
+        std::memcpy(blob.data() + sizeof(SceneBlobHeader), tables.data(), tables.size() * sizeof(SceneTableMapping));
+        return nvs_set_blob(handle, SCENES_KEY, blob.data(), blob.size());
+    }
+
     esp_err_t DaliAddressMap::save(const std::map<DaliLongAddress_t, DaliDevice>& devices) {
         NvsHandle nvs_handle(NVS_NAMESPACE, NVS_READWRITE);
         if (!nvs_handle) {
@@ -112,6 +211,11 @@ namespace daliMQTT
                 record.max_level = gear->max_level;
                 record.power_on_level = gear->power_on_level;
                 record.system_failure_restore_level = gear->system_failure_level;
+                if (gear->fade_time.has_value() && gear->fade_rate.has_value()) {
+                    record.fade_time_rate = static_cast<uint8_t>((*gear->fade_time << 4) | (*gear->fade_rate & 0x0F));
+                }
+                record.extended_fade_time = gear->extended_fade_time;
+                record.dimming_curve = static_cast<uint8_t>(gear->dimming_curve);
             }
             mappings.push_back(record);
         }
@@ -122,6 +226,11 @@ namespace daliMQTT
             ESP_LOGE(TAG, "Failed to save address map blob: %s", esp_err_to_name(err));
             return err;
         }
+
+        err = saveSceneTables(nvs_handle.get(), devices);
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to save scene tables blob: %s", esp_err_to_name(err));
+        }
         
         err = nvs_commit(nvs_handle.get());
         if (err != ESP_OK) {
@@ -17,9 +17,22 @@ namespace daliMQTT {
             uint8_t power_on_level;
             uint8_t system_failure_restore_level;
             bool supports_tc;
-            uint8_t _padding;
-            uint8_t _padding_2;
+            uint8_t fade_time_rate;             // High nibble fade time, low nibble fade rate, 0 = unknown
+            uint8_t extended_fade_time;
+            uint8_t dimming_curve;              // DimmingCurve; formerly padding, 0 on older records
     };
+    static_assert(sizeof(AddressMapping) == 32, "AddressMapping layout is persisted in NVS");
+
+    struct SceneTableMapping {
+            DaliLongAddress_t long_address;
+            uint8_t levels[16];                 // 255 = not part of scene
+            uint16_t color_known;               // Bit per scene: colour below is valid
+            uint16_t has_tc;                    // Bit per scene: Tc stored with the scene
+            uint16_t has_rgb;                   // Bit per scene: RGB stored with the scene
+            uint16_t tc[16];
+            uint8_t rgb[16][3];
+    };
+    static_assert(sizeof(SceneTableMapping) == 108, "SceneTableMapping layout is persisted in NVS");
 
     class DaliAddressMap {
         public:
@@ -30,8 +43,19 @@ namespace daliMQTT {
             static esp_err_t save(const std::map<DaliLongAddress_t, DaliDevice>& devices);
 
         private:
+            static void loadSceneTables(nvs_handle_t handle, std::map<DaliLongAddress_t, DaliDevice>& devices);
+            static esp_err_t saveSceneTables(nvs_handle_t handle, const std::map<DaliLongAddress_t, DaliDevice>& devices);
+
             static constexpr char  NVS_NAMESPACE[] = "dali_state";
             static constexpr char  MAP_KEY[] = "DALIAddrMap";
+            static constexpr char  SCENES_KEY[] = "DALIScenes";
+
+            // Precedes the SceneTableMapping records in the scenes blob
+            struct SceneBlobHeader {
+                    uint16_t version;
+                    uint16_t count;
+            };
+            static constexpr uint16_t SCENES_BLOB_VERSION = 1;
         };
     };
 
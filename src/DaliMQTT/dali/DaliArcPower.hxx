@@ -0,0 +1,141 @@
+#ifndef DALIMQTT_DALIARCPOWER_HXX
+#define DALIMQTT_DALIARCPOWER_HXX
+
+namespace daliMQTT {
+
+    namespace detail {
+        inline constexpr double LN2 = 0.69314718055994531;
+        inline constexpr double LN10 = 2.30258509299404568;
+
+        // std::exp and std::log are not constexpr before C++26
+
+        constexpr double constexprExp(double x) {
+            int halvings = 0;
+            while (x > 0.5 || x < -0.5) {
+                x /= 2;
+                ++halvings;
+            }
+            double term = 1.0;
+            double sum = 1.0;
+            for (int i = 1; i < 20; ++i) {
+                term *= x / i;
+                sum += term;
+            }
+            while (halvings-- > 0) sum *= sum;
+            return sum;
+        }
+
+        constexpr double constexprLn(double x) {
+            int exponent = 0;
+            while (x > 2.0) { x /= 2; ++exponent; }
+            while (x < 0.5) { x *= 2; --exponent; }
+            const double y = (x - 1) / (x + 1);
+            double term = y;
+            double sum = 0.0;
+            for (int i = 1; i < 80; i += 2) {
+                sum += term / i;
+                term *= y * y;
+            }
+            return 2 * sum + exponent * LN2;
+        }
+
+        constexpr uint8_t roundLevel(const double value) {
+            if (value <= 0.0) return 0;
+            if (value >= 254.0) return 254;
+            return static_cast<uint8_t>(value + 0.5);
+        }
+
+        // Output of standard-curve level 1..254 in percent
+        constexpr double outputPercent(const int level) {
+            return constexprExp(LN10 * ((level - 1) * 3.0 / 253.0 - 1.0));
+        }
+
+        inline constexpr std::array<uint16_t, 255> OUTPUT_BASIS_POINTS = [] {
+            std::array<uint16_t, 255> table{};
+            for (int level = 1; level < 255; ++level) {
+                table[level] = static_cast<uint16_t>(outputPercent(level) * 100.0 + 0.5);
+            }
+            return table;
+        }();
+
+        inline constexpr std::array<uint8_t, 255> LOG_TO_LINEAR = [] {
+            std::array<uint8_t, 255> table{};
+            for (int level = 1; level < 255; ++level) {
+                const uint8_t linear = roundLevel(outputPercent(level) * 254.0 / 100.0);
+                table[level] = linear == 0 ? 1 : linear;
+            }
+            return table;
+        }();
+
+        inline constexpr std::array<uint8_t, 255> LINEAR_TO_LOG = [] {
+            std::array<uint8_t, 255> table{};
+            for (int linear = 1; linear < 255; ++linear) {
+                const double percent = linear * 100.0 / 254.0;
+                const double level = 1.0 + 253.0 / 3.0 * (constexprLn(percent) / LN10 + 1.0);
+                table[linear] = std::max<uint8_t>(roundLevel(level), 1);
+            }
+            return table;
+        }();
+
+        // 506 / sqrt(2^X) steps/s, times 200 ms; the slowest rates still move one step
+        inline constexpr std::array<uint8_t, 16> UP_DOWN_STEPS = [] {
+            std::array<uint8_t, 16> table{};
+            for (int rate = 1; rate < 16; ++rate) {
+                const double steps = 101.2 * constexprExp(-rate * LN2 / 2);
+                table[rate] = std::max<uint8_t>(roundLevel(steps), 1);
+            }
+            return table;
+        }();
+
+        static_assert(OUTPUT_BASIS_POINTS[1] == 10 && OUTPUT_BASIS_POINTS[254] == 10000);
+        static_assert(UP_DOWN_STEPS[1] == 72 && UP_DOWN_STEPS[7] == 9 && UP_DOWN_STEPS[15] == 1);
+    }
+
+    /** Answer of QUERY DIMMING CURVE (DT6). */
+    enum class DimmingCurve : uint8_t {
+        Logarithmic = 0,    // IEC 62386-102 standard curve
+        Linear = 1,
+    };
+
+    /**
+     * @brief Arc power level conversions, as tables generated at compile time.
+     *
+     * On the standard curve level n (1..254) gives 10^((n - 1) / (253 / 3) - 1) % of full light output,
+     * so 1 is 0.1 % and each step is about 2.8 % brighter than the one below. On the linear DT6 curve
+     * level n gives n / 254. "Linear level" below means the level with the same output on that curve,
+     * which is also what a brightness slider expects.
+     */
+    class DaliArcPower {
+    public:
+        /** Light output of a standard-curve level, in 0.01 % (0..10000). */
+        static constexpr uint16_t outputBasisPoints(const uint8_t level) {
+            return level == 255 ? detail::OUTPUT_BASIS_POINTS[254] : detail::OUTPUT_BASIS_POINTS[level];
+        }
+
+        /** Standard-curve level to the linear level with the same output. A lit lamp stays at 1 or above. */
+        static constexpr uint8_t logToLinear(const uint8_t level) {
+            return level == 255 ? 254 : detail::LOG_TO_LINEAR[level];
+        }
+
+        /** Linear level to the standard-curve level with the closest output. */
+        static constexpr uint8_t linearToLog(const uint8_t linear) {
+            return linear == 255 ? 254 : detail::LINEAR_TO_LOG[linear];
+        }
+
+        /** Converts a level between curves; the same level is returned when the curves match. */
+        static constexpr uint8_t convert(const uint8_t level, const DimmingCurve from, const DimmingCurve to) {
+            if (from == to) return level;
+            return from == DimmingCurve::Logarithmic ? logToLinear(level) : linearToLog(level);
+        }
+
+        /** Arc power steps covered by one 200 ms UP/DOWN fade at fade rate code 1..15, 0 otherwise. */
+        static constexpr uint8_t stepsPerUpDown(const uint8_t fade_rate) {
+            return fade_rate < detail::UP_DOWN_STEPS.size() ? detail::UP_DOWN_STEPS[fade_rate] : 0;
+        }
+
+        /** Fade rate after RESET, used when the gear's own rate is unknown. */
+        static constexpr uint8_t DEFAULT_FADE_RATE = 7;
+    };
+}
+
+#endif //DALIMQTT_DALIARCPOWER_HXX
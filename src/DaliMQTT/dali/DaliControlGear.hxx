@@ -2,6 +2,7 @@
 #define DALIMQTT_DALICONTROLGEAR_HXX
 #include "dali/DaliDeviceIdentity.hxx"
 #include "dali/DaliDT8.hxx"
+#include "dali/DaliArcPower.hxx"
 
 namespace daliMQTT {
     struct ControlGear : DeviceIdentity {
@@ -12,12 +13,18 @@ namespace daliMQTT {
         uint8_t max_level{254};
         uint8_t power_on_level{254};            // Level after power cycle
         uint8_t system_failure_level{254};
+        std::optional<uint8_t> fade_time;       // Fade time code 0..15
+        std::optional<uint8_t> fade_rate;       // Fade rate code 1..15
+        uint8_t extended_fade_time{0};          // Extended fade time (used when fade time is 0)
+        std::optional<std::array<uint8_t, 16>> scene_levels; // Scene table, 255 = not part of scene
 
         std::optional<uint8_t> device_type;     // Device Type
+        DimmingCurve dimming_curve{DimmingCurve::Logarithmic}; // DT6 gear may run the linear curve
         std::optional<ColorFeatures> color;     // DT8 Fields
 
         bool static_data_loaded{false};         // Static data load flag
         bool initial_sync_needed{true};         // First sync flag
+        bool state_restored{false};             // Runtime state seeded from the NVS journal
     };
 }
 #endif //DALIMQTT_DALICONTROLGEAR_HXX
\ No newline at end of file
@@ -15,6 +15,13 @@ namespace daliMQTT {
         Rgb     // RGB / RGBW
     };
 
+    /** Colour stored with a scene; neither value set means the scene keeps the colour unchanged. */
+    struct DaliSceneColor {
+        bool known{false};
+        std::optional<uint16_t> tc;
+        std::optional<DaliRGB> rgb;
+    };
+
     struct ColorFeatures {
         DaliColorMode active_mode{DaliColorMode::Tc};
 
@@ -27,6 +34,8 @@ namespace daliMQTT {
         bool supports_rgb{false};
         bool supports_tc{false};
 
+        std::array<DaliSceneColor, 16> scene_colors{};
+
         int64_t last_poll_ts{0};
     };
 }
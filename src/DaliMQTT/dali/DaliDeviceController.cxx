@@ -3,9 +3,13 @@
 #include <utils/StringUtils.hxx>
 #include "system/ConfigManager.hxx"
 #include "dali/DaliAddressMap.hxx"
+#include "dali/DaliStateJournal.hxx"
 #include "dali/DaliAdapter.hxx"
 #include "mqtt/MQTTClient.hxx"
+#include "mqtt/MQTTPublishCoalescer.hxx"
 #include "utils/DaliLongAddrConversions.hxx"
+#include "utils/JsonWriter.hxx"
+#include "mqtt/MQTTPayloadFormats.hxx"
 #include <esp_timer.h>
 
 namespace daliMQTT
@@ -25,7 +29,14 @@ namespace daliMQTT
         } else {
             ESP_LOGI(TAG, "Successfully loaded and validated cached DALI address map.");
         }
+        rebuildTopics();
 
+        #ifdef CONFIG_DALI2MQTT_DALI_STATE_JOURNAL_ENABLED
+        {
+            std::lock_guard<std::mutex> lock(m_devices_mutex);
+            DaliStateJournal::Instance().load(m_devices);
+        }
+        #endif
     }
 
     void DaliDeviceController::start() {
@@ -46,50 +57,71 @@ namespace daliMQTT
     }
 
     void DaliDeviceController::publishState(const DaliLongAddress_t long_addr, const ControlGear& device) const {
-        auto const& mqtt = MQTTClient::Instance();
-        const auto config = ConfigManager::Instance().getConfig();
-
-        const auto addr_str = utils::longAddressToString(long_addr);
-        const std::string state_topic = utils::stringFormat("%s/light/%s/state", config.mqtt_base_topic.c_str(), addr_str.data());
         if (device.current_level == 255) return;
+        const auto topics = getDeviceTopics(long_addr);
+        if (!topics) return;
 
-        cJSON* root = cJSON_CreateObject();
-        cJSON_AddStringToObject(root, "state", (device.current_level > 0 ? "ON" : "OFF"));
-        cJSON_AddNumberToObject(root, "brightness", device.current_level);
-        cJSON_AddNumberToObject(root, "status_byte", device.status_byte);
+        utils::StaticPayloadWriter<STATE_PAYLOAD_BUFFER_SIZE> writer(STATE_PAYLOAD_FORMAT);
+        writer.beginObject()
+            .add("state", device.current_level > 0 ? "ON" : "OFF")
+            .add("brightness", levelToBrightness(device.current_level, device.dimming_curve))
+            .add("status_byte", device.status_byte);
 
         if (device.color.has_value()) {
             const auto& c = device.color.value();
             if (c.current_tc.has_value()) {
-                cJSON_AddNumberToObject(root, "color_temp", c.current_tc.value());
+                writer.add("color_temp", c.current_tc.value());
             }
             if (c.current_rgb.has_value()) {
-                cJSON* color = cJSON_CreateObject();
-                cJSON_AddNumberToObject(color, "r", c.current_rgb->r);
-                cJSON_AddNumberToObject(color, "g", c.current_rgb->g);
-                cJSON_AddNumberToObject(color, "b", c.current_rgb->b);
-                cJSON_AddItemToObject(root, "color", color);
+                writer.beginObject("color")
+                    .add("r", c.current_rgb->r)
+                    .add("g", c.current_rgb->g)
+                    .add("b", c.current_rgb->b)
+                    .endObject();
             }
         }
+        writer.endObject();
 
-        char* payload = cJSON_PrintUnformatted(root);
-        if (payload) {
-            ESP_LOGD(TAG, "Publishing to %s: %s", state_topic.c_str(), payload);
-            mqtt.publish(state_topic, payload, 0, true);
-            free(payload);
+        if (!writer.ok()) {
+            ESP_LOGE(TAG, "State payload for %s does not fit the buffer", utils::longAddressToString(long_addr).data());
+            return;
         }
-        cJSON_Delete(root);
+        ESP_LOGD(TAG, "Publishing to %s (%zu bytes)", topics->state.c_str(), writer.view().size());
+        MQTTPublishCoalescer::Instance().submit(topics->state, writer.view(), 0, true);
+        MQTTBusSnapshot::Instance().markDirty();
     }
 
     void DaliDeviceController::publishAvailability(const DaliLongAddress_t long_addr, const bool is_available) {
-        auto const& mqtt = MQTTClient::Instance();
-        const auto config = ConfigManager::Instance().getConfig();
+        const auto topics = Instance().getDeviceTopics(long_addr);
+        if (!topics) return;
 
-        const auto addr_str = utils::longAddressToString(long_addr);
-        const std::string status_topic = utils::stringFormat("%s/light/%s/status", config.mqtt_base_topic.c_str(), addr_str.data());
-        const std::string payload = is_available ? CONFIG_DALI2MQTT_MQTT_PAYLOAD_ONLINE : CONFIG_DALI2MQTT_MQTT_PAYLOAD_OFFLINE;
-        ESP_LOGD(TAG, "Publishing AVAILABILITY to %s: %s", status_topic.c_str(), payload.c_str());
-        mqtt.publish(status_topic, payload, 1, true);
+        const char* payload = is_available ? CONFIG_DALI2MQTT_MQTT_PAYLOAD_ONLINE : CONFIG_DALI2MQTT_MQTT_PAYLOAD_OFFLINE;
+        ESP_LOGD(TAG, "Publishing AVAILABILITY to %s: %s", topics->status.c_str(), payload);
+        MQTTClient::Instance().publish(topics->status, payload, 1, true);
+        MQTTBusSnapshot::Instance().markDirty();
+    }
+
+    std::shared_ptr<const DeviceTopics> DaliDeviceController::getDeviceTopics(const DaliLongAddress_t longAddress) const {
+        std::lock_guard<std::mutex> lock(m_topics_mutex);
+        if (const auto it = m_device_topics.find(longAddress); it != m_device_topics.end()) {
+            return it->second;
+        }
+        return nullptr;
+    }
+
+    void DaliDeviceController::rebuildTopics() {
+        const std::string base_topic = ConfigManager::Instance().getMqttBaseTopic();
+        std::map<DaliLongAddress_t, std::shared_ptr<const DeviceTopics>> topics;
+        {
+            std::lock_guard<std::mutex> lock(m_devices_mutex);
+            for (const auto& long_addr : m_devices | std::views::keys) {
+                topics.emplace(long_addr, makeDeviceTopics(base_topic, long_addr));
+            }
+        }
+        std::lock_guard<std::mutex> lock(m_topics_mutex);
+        m_device_topics = std::move(topics);
+        m_topic_base = base_topic;
+        MQTTBusSnapshot::Instance().reset();
     }
 
     void DaliDeviceController::updateDeviceState(const DaliLongAddress_t longAddr, const DaliPublishState& state) {
@@ -137,56 +169,73 @@ namespace daliMQTT
                     }
                 }
 
+                if (state_changed) {
+                    m_last_state_change_ts = esp_timer_get_time() / 1000;
+                    if (m_state_dirty.empty()) m_first_state_change_ts = m_last_state_change_ts;
+                    m_state_dirty.insert(longAddr);
+                }
+
                 if (state_changed || gear->initial_sync_needed) {
                     ESP_LOGD(TAG, "State update for %s", utils::longAddressToString(longAddr).data());
                     publishState(longAddr, *gear);
                     gear->initial_sync_needed = false;
+                    gear->state_restored = false;
                 }
             }
         }
     }
 
     void DaliDeviceController::publishAttributes(const DaliLongAddress_t long_addr) const {
-        auto const& mqtt = MQTTClient::Instance();
-        const auto config = ConfigManager::Instance().getConfig();
-        const auto addr_str = utils::longAddressToString(long_addr);
+        const auto topics = getDeviceTopics(long_addr);
+        if (!topics) return;
 
-        ControlGear dev_copy;
+        utils::StaticJsonWriter<ATTRIBUTES_JSON_BUFFER_SIZE> json;
         {
             std::lock_guard<std::mutex> lock(m_devices_mutex);
-            if (!Instance().m_devices.contains(long_addr)) return;
-            if (const auto* gear = std::get_if<ControlGear>(&Instance().m_devices.at(long_addr))) {
-                dev_copy = *gear;
-            } else {
-                return;
+            const auto it = m_devices.find(long_addr);
+            if (it == m_devices.end()) return;
+            const auto* gear = std::get_if<ControlGear>(&it->second);
+            if (!gear) return;
+
+            json.beginObject();
+            if (gear->device_type.has_value()) {
+                json.add("device_type", gear->device_type.value());
             }
-        }
-        const std::string attr_topic = utils::stringFormat("%s/light/%s/attributes", config.mqtt_base_topic.c_str(), addr_str.data());
-
-        cJSON* root = cJSON_CreateObject();
-
-        if (dev_copy.device_type.has_value()) {
-            cJSON_AddNumberToObject(root, "device_type", dev_copy.device_type.value());
+            if (!gear->gtin.empty()) {
+                json.add("gtin", gear->gtin);
+            }
+            json.add("dev_min_level", gear->min_level)
+                .add("dev_max_level", gear->max_level)
+                .add("dev_power_on_level", gear->power_on_level)
+                .add("dev_system_failure_level", gear->system_failure_level);
+            if (gear->fade_time.has_value() && gear->fade_rate.has_value()) {
+                json.add("dev_fade_time", *gear->fade_time)
+                    .add("dev_fade_rate", *gear->fade_rate);
+            }
+            json.add("short_address", gear->short_address);
+            json.endObject();
         }
 
-        if (!dev_copy.gtin.empty()) {
-            cJSON_AddStringToObject(root, "gtin", dev_copy.gtin.c_str());
+        const auto addr_str = utils::longAddressToString(long_addr);
+        if (!json.ok()) {
+            ESP_LOGE(TAG, "Attributes payload for %s does not fit the buffer", addr_str.data());
+            return;
         }
+        MQTTClient::Instance().publish(topics->attributes, json.view(), 1, true);
 
-        cJSON_AddNumberToObject(root, "dev_min_level", dev_copy.min_level);
-        cJSON_AddNumberToObject(root, "dev_max_level", dev_copy.max_level);
-        cJSON_AddNumberToObject(root, "dev_power_on_level", dev_copy.power_on_level);
-        cJSON_AddNumberToObject(root, "dev_system_failure_level", dev_copy.system_failure_level);
-        cJSON_AddNumberToObject(root, "short_address", dev_copy.short_address);
+        ESP_LOGI(TAG, "Published extended attributes for %s", addr_str.data());
+    }
 
-        char* json_str = cJSON_PrintUnformatted(root);
-        if (json_str) {
-            mqtt.publish(attr_topic, json_str, 1, true);
-            free(json_str);
+    DimmingCurve DaliDeviceController::getDimmingCurve(const uint8_t shortAddress) const {
+        std::lock_guard<std::mutex> lock(m_devices_mutex);
+        if (const auto it = m_short_to_long_map.find(shortAddress); it != m_short_to_long_map.end()) {
+            if (const auto dev = m_devices.find(it->second); dev != m_devices.end()) {
+                if (const auto* gear = std::get_if<ControlGear>(&dev->second)) {
+                    return gear->dimming_curve;
+                }
+            }
         }
-        cJSON_Delete(root);
-
-        ESP_LOGI(TAG, "Published extended attributes for %s", addr_str.data());
+        return DimmingCurve::Logarithmic;
     }
 
     std::optional<uint8_t> DaliDeviceController::getLastLevel(const DaliLongAddress_t longAddress) const {
@@ -286,7 +335,7 @@ namespace daliMQTT
                             }
 
                             if (len > 0 && len < sizeof(payload_buffer)) {
-                                mqtt.publish(cached_topic, std::string(payload_buffer, len), 0, false);
+                                mqtt.publish(cached_topic, std::string_view(payload_buffer, len), 0, false);
                             }
                         }
                     }
@@ -305,12 +354,15 @@ namespace daliMQTT
         self->requestBroadcastSync(200, 150);
 
         ESP_LOGI(TAG, "Dali Adaptive Sync Task Started.");
-        const auto config = ConfigManager::Instance().getConfig();
+        const auto config = ConfigManager::Instance().getSnapshot();
 
-        const uint32_t safe_cycle_time = std::max<uint32_t>(1000, config.dali_poll_interval_ms);
+        const uint32_t safe_cycle_time = std::max<uint32_t>(1000, config->dali_poll_interval_ms);
         const uint32_t calc_delay_ms = safe_cycle_time >> 6;
-        const TickType_t rr_delay_ticks = pdMS_TO_TICKS(std::max<uint32_t>(20, calc_delay_ms));
+        const uint32_t rr_delay_ms = std::max<uint32_t>(20, calc_delay_ms);
         constexpr TickType_t priority_delay_ticks = pdMS_TO_TICKS(10);
+        // Short idle tick so deferred (end-of-fade) polls and fade publishing are not held up by the round-robin delay
+        constexpr TickType_t idle_tick = pdMS_TO_TICKS(50);
+        int64_t next_rr_ts = 0;
 
         while (true) {
             uint8_t priority_addr = 255;
@@ -330,6 +382,22 @@ namespace daliMQTT
                 }
             }
 
+            DaliGroupManagement::Instance().flushPendingSaveIfDue(now);
+
+            #ifdef CONFIG_DALI2MQTT_DALI_STATE_JOURNAL_ENABLED
+            // A bus that never goes quiet is still persisted after the maximum latency
+            bool journal_due;
+            {
+                std::lock_guard<std::mutex> lock(self->m_devices_mutex);
+                journal_due = !self->m_state_dirty.empty() &&
+                    ((now - self->m_last_state_change_ts) > CONFIG_DALI2MQTT_DALI_STATE_JOURNAL_DEBOUNCE_MS ||
+                     (now - self->m_first_state_change_ts) > CONFIG_DALI2MQTT_DALI_STATE_JOURNAL_MAX_LATENCY_MS);
+            }
+            if (journal_due) self->flushStateJournal();
+            #endif
+
+            self->processFadeTransitions(now);
+
             // Check Deferred Requests
             {
                 std::lock_guard<std::mutex> lock(self->m_queue_mutex);
@@ -359,8 +427,11 @@ namespace daliMQTT
             }
 
             if (has_priority) {
-                self->pollSingleDevice(priority_addr);
+                self->pollSingleDevice(priority_addr, true);
                 vTaskDelay(priority_delay_ticks);
+            } else if (now < next_rr_ts) {
+                const TickType_t remaining = pdMS_TO_TICKS(next_rr_ts - now);
+                vTaskDelay(std::clamp<TickType_t>(remaining, 1, idle_tick));
             } else {
                 // Round Robin Logic
                 self->pollSingleDevice(self->m_round_robin_index);
@@ -370,49 +441,147 @@ namespace daliMQTT
                     self->m_round_robin_index = 0;
 
                     // Sync Group states from device info
-                    auto all_assignments = DaliGroupManagement::Instance().getAllAssignments();
-                    std::map<DaliLongAddress_t, DaliDevice> devices_snapshot;
-                    {
-                        std::lock_guard<std::mutex> lock(self->m_devices_mutex);
-                        devices_snapshot = self->m_devices;
+                    self->syncGroupStatesFromDevices();
+                }
+                // The gap counts from the end of the poll, like a plain delay, but is waited in idle ticks
+                next_rr_ts = esp_timer_get_time() / 1000 + rr_delay_ms;
+                vTaskDelay(std::min(idle_tick, pdMS_TO_TICKS(rr_delay_ms)));
+            }
+        }
+    }
+
+    void DaliDeviceController::processFadeTransitions(const int64_t now_ms) {
+        std::vector<std::pair<DaliLongAddress_t, uint8_t>> updates;
+        {
+            std::lock_guard<std::mutex> lock(m_devices_mutex);
+            if (m_fade_transitions.empty()) return;
+            if ((now_ms - m_last_fade_publish_ts) < CONFIG_DALI2MQTT_DALI_FADE_PUBLISH_INTERVAL_MS) return;
+            m_last_fade_publish_ts = now_ms;
+
+            for (auto it = m_fade_transitions.begin(); it != m_fade_transitions.end();) {
+                const auto& fade = it->second;
+                if (now_ms >= fade.end_ts) {
+                    updates.emplace_back(it->first, fade.target_level);
+                    it = m_fade_transitions.erase(it);
+                    continue;
+                }
+                // DALI fades are linear in arc power steps
+                const int64_t elapsed = now_ms - fade.start_ts;
+                const int64_t duration = std::max<int64_t>(1, fade.end_ts - fade.start_ts);
+                const int delta = static_cast<int>(fade.target_level) - static_cast<int>(fade.start_level);
+                const auto level = static_cast<uint8_t>(fade.start_level + (delta * elapsed) / duration);
+                updates.emplace_back(it->first, level);
+                ++it;
+            }
+        }
+
+        for (const auto& [long_addr, level] : updates) {
+            updateDeviceState(long_addr, {.level = level});
+        }
+    }
+
+    void DaliDeviceController::flushStateJournal() {
+        std::vector<RuntimeStateRecord> changed;
+        std::vector<RuntimeStateRecord> all;
+        {
+            std::lock_guard<std::mutex> lock(m_devices_mutex);
+            all.reserve(m_devices.size());
+            for (const auto& [long_addr, dev_var] : m_devices) {
+                if (const auto* gear = std::get_if<ControlGear>(&dev_var)) {
+                    // Never journal a state that was neither polled nor restored.
+                    if (gear->initial_sync_needed && !gear->state_restored) continue;
+                    auto record = DaliStateJournal::makeRecord(*gear);
+                    if (m_state_dirty.contains(long_addr)) {
+                        changed.push_back(record);
                     }
-                    std::map<uint8_t, DaliPublishState> group_sync_states;
-                    for (const auto& [long_addr, groups] : all_assignments) {
-                        if (!devices_snapshot.contains(long_addr)) continue;
-
-                        if (const auto* gear = std::get_if<ControlGear>(&devices_snapshot.at(long_addr))) {
-                            if (!gear->available) continue;
-
-                            for (uint8_t group = 0; group < 16; ++group) {
-                                if (groups.test(group)) {
-                                    if (!group_sync_states.contains(group)) {
-                                        group_sync_states[group] = DaliPublishState{ .level = 0 };
-                                    }
-                                    auto& g_state = group_sync_states[group];
-                                    if (gear->current_level > g_state.level.value_or(0)) {
-                                        g_state.level = gear->current_level;
-                                    }
-                                    if (gear->color.has_value())
-                                    {
-                                        if (gear->color->supports_rgb && gear->color->current_rgb.has_value()) {
-                                            g_state.rgb = gear->color->current_rgb;
-                                        }
-                                        if (gear->color->supports_tc && gear->color->current_tc.has_value()) {
-                                            g_state.color_temp = gear->color->current_tc;
-                                        }
-                                    }
-                                }
+                    all.push_back(record);
+                }
+            }
+            m_state_dirty.clear();
+        }
+        DaliStateJournal::Instance().commit(changed, all);
+    }
+
+    void DaliDeviceController::syncGroupStatesFromDevices(const bool force_publish) const {
+        auto all_assignments = DaliGroupManagement::Instance().getAllAssignments();
+        std::map<DaliLongAddress_t, DaliDevice> devices_snapshot;
+        {
+            std::lock_guard<std::mutex> lock(m_devices_mutex);
+            devices_snapshot = m_devices;
+        }
+        std::map<uint8_t, DaliPublishState> group_sync_states;
+        for (const auto& [long_addr, groups] : all_assignments) {
+            if (!devices_snapshot.contains(long_addr)) continue;
+
+            if (const auto* gear = std::get_if<ControlGear>(&devices_snapshot.at(long_addr))) {
+                if (!gear->available && !gear->state_restored) continue;
+
+                for (uint8_t group = 0; group < 16; ++group) {
+                    if (groups.test(group)) {
+                        if (!group_sync_states.contains(group)) {
+                            group_sync_states[group] = DaliPublishState{ .level = 0 };
+                        }
+                        auto& g_state = group_sync_states[group];
+                        if (gear->current_level > g_state.level.value_or(0)) {
+                            g_state.level = gear->current_level;
+                        }
+                        if (gear->color.has_value())
+                        {
+                            if (gear->color->supports_rgb && gear->color->current_rgb.has_value()) {
+                                g_state.rgb = gear->color->current_rgb;
+                            }
+                            if (gear->color->supports_tc && gear->color->current_tc.has_value()) {
+                                g_state.color_temp = gear->color->current_tc;
                             }
                         }
                     }
+                }
+            }
+        }
+
+        for(const auto& [group_id, state] : group_sync_states) {
+            DaliGroupManagement::Instance().updateGroupState(group_id, state, force_publish);
+        }
+    }
+
+    void DaliDeviceController::collectBusSnapshot(BusSnapshotEntries& entries) const {
+        entries.fill(BusSnapshotEntry{});
+        std::lock_guard<std::mutex> lock(m_devices_mutex);
+        for (const auto& dev_var : m_devices | std::views::values) {
+            const auto* gear = std::get_if<ControlGear>(&dev_var);
+            if (!gear || !gear->is_assigned()) continue;
+            // Same rule as publishAllStates(): never report a level we have not seen
+            if (gear->initial_sync_needed && !gear->state_restored) continue;
+
+            auto& entry = entries[gear->short_address];
+            entry.present = true;
+            entry.available = gear->available;
+            entry.level = gear->current_level;
+            entry.status_byte = gear->status_byte;
+            if (gear->color.has_value()) {
+                entry.color_temp = gear->color->current_tc;
+                entry.rgb = gear->color->current_rgb;
+            }
+        }
+    }
 
-                    for(const auto& [group_id, state] : group_sync_states) {
-                        DaliGroupManagement::Instance().updateGroupState(group_id, state);
+    void DaliDeviceController::publishAllStates() const {
+        std::vector<ControlGear> known_gear;
+        {
+            std::lock_guard<std::mutex> lock(m_devices_mutex);
+            for (const auto& dev_var : m_devices | std::views::values) {
+                if (const auto* gear = std::get_if<ControlGear>(&dev_var)) {
+                    if (!gear->initial_sync_needed || gear->state_restored) {
+                        known_gear.push_back(*gear);
                     }
                 }
-                vTaskDelay(rr_delay_ticks);
             }
         }
+        ESP_LOGI(TAG, "Publishing cached state of %zu devices.", known_gear.size());
+        for (const auto& gear : known_gear) {
+            publishState(gear.long_address, gear);
+        }
+        syncGroupStatesFromDevices(true);
     }
 
     void DaliDeviceController::requestDeviceSync(uint8_t shortAddress, uint32_t delay_ms) {
@@ -438,7 +607,7 @@ namespace daliMQTT
         const uint8_t event_byte = data & 0xFF;
 
         bool is_event_scheme = (addr_byte & 0x01) == 0x01;
-        std::string addr_type_str = "unknown";
+        const char* addr_type_str = "unknown";
         uint8_t address = 0;
 
         if (is_event_scheme) {
@@ -462,49 +631,55 @@ namespace daliMQTT
              // 24-bit Command
              return;
         }
-        std::string topic_addr_type = addr_type_str;
-        std::string topic_addr_val = std::to_string(address);
 
-        if (addr_type_str == "short") {
-            auto long_addr_opt = getLongAddress(address, true);
-            if (long_addr_opt.has_value()) {
-                topic_addr_type = "long";
-                auto la_str = utils::longAddressToString(long_addr_opt.value());
-                topic_addr_val = std::string(la_str.data());
+        std::shared_ptr<const DeviceTopics> device_topics;
+        std::optional<DaliLongAddrStr> long_addr_str;
+        if (std::string_view(addr_type_str) == "short") {
+            if (const auto long_addr_opt = getLongAddress(address, true)) {
+                device_topics = getDeviceTopics(*long_addr_opt);
+                long_addr_str = utils::longAddressToString(*long_addr_opt);
             }
         }
-        cJSON* root = cJSON_CreateObject();
-        cJSON_AddStringToObject(root, "type", "event");
-        cJSON_AddStringToObject(root, "address_type", addr_type_str.c_str());
-        cJSON_AddNumberToObject(root, "address", address);
-        cJSON_AddNumberToObject(root, "instance", instance_byte);
-        cJSON_AddNumberToObject(root, "event_code", event_byte);
+
+        utils::StaticPayloadWriter<EVENT_PAYLOAD_BUFFER_SIZE> writer(EVENT_PAYLOAD_FORMAT);
+        writer.beginObject()
+            .add("type", "event")
+            .add("address_type", addr_type_str)
+            .add("address", address)
+            .add("instance", instance_byte)
+            .add("event_code", event_byte);
 
         #ifdef CONFIG_DALI2MQTT_SNIFFER_DEBUG_PUBLISH_MQTT
             char hex_buf[10];
             snprintf(hex_buf, sizeof(hex_buf), "%06lX", data);
-            cJSON_AddStringToObject(root, "raw_hex", hex_buf);
+            writer.add("raw_hex", hex_buf);
         #endif
 
-        if (topic_addr_type == "long") {
-            cJSON_AddStringToObject(root, "long_addr", topic_addr_val.c_str());
+        if (long_addr_str.has_value()) {
+            writer.add("long_addr", long_addr_str->data());
         }
-        char* json_payload = cJSON_PrintUnformatted(root);
-        cJSON_Delete(root);
+        writer.endObject();
+        if (!writer.ok()) return;
 
-        if (json_payload) {
-            auto const& mqtt = MQTTClient::Instance();
-            const auto config = ConfigManager::Instance().getConfig();
+        auto const& mqtt = MQTTClient::Instance();
+        // Button presses are worthless once late, do not queue them for offline subscribers
+        constexpr PublishProperties event_properties{.message_expiry_s = TRANSIENT_MESSAGE_EXPIRY_S};
+        if (device_topics) {
+            mqtt.publish(device_topics->event, writer.view(), 0, false, event_properties);
+            ESP_LOGD(TAG, "Input Device Event Published: %s (%zu bytes)", device_topics->event.c_str(), writer.view().size());
+            return;
+        }
 
-            std::string topic = utils::stringFormat("%s/event/%s/%s", // base/event/{address_type}/{address_str}
-                config.mqtt_base_topic.c_str(),
-                topic_addr_type.c_str(),
-                topic_addr_val.c_str()
-            );
-            mqtt.publish(topic, json_payload, 0, false);
-            ESP_LOGD(TAG, "Input Device Event Published: %s -> %s", topic.c_str(), json_payload);
-            free(json_payload);
+        // base/event/{address_type}/{address}
+        char topic[TOPIC_BUFFER_SIZE];
+        int len;
+        {
+            std::lock_guard<std::mutex> lock(m_topics_mutex);
+            len = snprintf(topic, sizeof(topic), "%s/event/%s/%u", m_topic_base.c_str(), addr_type_str, address);
         }
+        if (len <= 0 || len >= static_cast<int>(sizeof(topic))) return;
+        mqtt.publish(topic, writer.view(), 0, false, event_properties);
+        ESP_LOGD(TAG, "Input Device Event Published: %s (%zu bytes)", topic, writer.view().size());
     }
 
     void DaliDeviceController::requestBroadcastSync(const uint32_t base_delay_ms, const uint32_t stagger_ms) {
@@ -520,20 +695,16 @@ namespace daliMQTT
         }
     }
 
-    std::optional<uint8_t> DaliDeviceController::pollAvailabilityAndLevel(const uint8_t shortAddr, const DaliLongAddress_t longAddr) {
+    std::optional<uint8_t> DaliDeviceController::pollAvailabilityAndStatus(const uint8_t shortAddr, const DaliLongAddress_t longAddr) {
         auto& dali = DaliAdapter::Instance();
-        const auto level_opt = dali.sendQuery(DALI_ADDRESS_TYPE_SHORT, shortAddr, DALI_COMMAND_QUERY_ACTUAL_LEVEL);
-        const bool is_responding = level_opt.has_value();
-
-        bool previously_available = false;
-        uint8_t cached_level = 0;
+        const auto status_opt = dali.getDeviceStatus(shortAddr);
+        const bool is_responding = status_opt.has_value();
 
         {
             std::lock_guard<std::mutex> lock(m_devices_mutex);
             if (m_devices.contains(longAddr)) {
                 auto& dev_var = m_devices[longAddr];
                 auto& id = getIdentity(dev_var);
-                previously_available = id.available;
 
                 if (id.available != is_responding) {
                     id.available = is_responding;
@@ -541,17 +712,12 @@ namespace daliMQTT
                         publishAvailability(longAddr, is_responding);
                     }
                 }
-
-                if (const auto* gear = std::get_if<ControlGear>(&dev_var)) {
-                    cached_level = gear->current_level;
-                }
             } else {
                 return std::nullopt; // dev removed from map during query
             }
         }
 
-        if (!is_responding) return std::nullopt;
-        return (level_opt.value() == 255) ? cached_level : level_opt.value();
+        return status_opt;
     }
 
     void DaliDeviceController::checkDT8Features(const uint8_t shortAddr, const DaliLongAddress_t longAddr) {
@@ -594,7 +760,7 @@ namespace daliMQTT
         }
     }
 
-    DaliDeviceController::ColorPollResult DaliDeviceController::pollColorDataCyclic(const uint8_t shortAddr, const DaliLongAddress_t longAddr, const uint8_t current_level) {
+    DaliDeviceController::ColorPollResult DaliDeviceController::pollColorDataCyclic(const uint8_t shortAddr, const DaliLongAddress_t longAddr, const uint8_t current_level, const bool force) {
         ColorPollResult result;
         if (current_level == 0) return result;
 
@@ -610,7 +776,7 @@ namespace daliMQTT
                 if (auto* g = std::get_if<ControlGear>(&m_devices[longAddr])) {
                     if (g->color.has_value()) {
                         if ((g->color->supports_tc || g->color->supports_rgb) &&
-                            (now_sec - g->color->last_poll_ts) > COLOR_POLL_INTERVAL_SEC) {
+                            (force || (now_sec - g->color->last_poll_ts) > COLOR_POLL_INTERVAL_SEC)) {
                             should_poll = true;
                             supports_tc = g->color->supports_tc;
                             supports_rgb = g->color->supports_rgb;
@@ -680,24 +846,34 @@ namespace daliMQTT
 
     void DaliDeviceController::initialStaticDataFetch(const uint8_t shortAddr, const DaliLongAddress_t longAddr) {
         bool needs_load = false;
+        bool needs_fade = false;
         {
             std::lock_guard<std::mutex> lock(m_devices_mutex);
             if (m_devices.contains(longAddr)) {
                 if (const auto* g = std::get_if<ControlGear>(&m_devices[longAddr])) {
                     if (!g->static_data_loaded) needs_load = true;
+                    if (!g->fade_rate.has_value() && !m_fade_checked.test(shortAddr)) needs_fade = true;
                 }
             }
+            if (!needs_load && !needs_fade) return;
+            m_fade_checked.set(shortAddr);
         }
 
-        if (!needs_load) return;
-
         auto& dali = DaliAdapter::Instance();
-        const auto min_opt = dali.sendQuery(DALI_ADDRESS_TYPE_SHORT, shortAddr, DALI_COMMAND_QUERY_MIN_LEVEL);
-        const auto max_opt = dali.sendQuery(DALI_ADDRESS_TYPE_SHORT, shortAddr, DALI_COMMAND_QUERY_MAX_LEVEL);
-        const auto power_on_opt = dali.sendQuery(DALI_ADDRESS_TYPE_SHORT, shortAddr, DALI_COMMAND_QUERY_POWER_ON_LEVEL);
-        const auto fail_opt = dali.sendQuery(DALI_ADDRESS_TYPE_SHORT, shortAddr, DALI_COMMAND_QUERY_SYSTEM_FAILURE_LEVEL);
-        const auto gtin_opt = dali.getGTIN(shortAddr);
-        const auto dt_opt = dali.getDeviceType(shortAddr);
+        std::optional<uint8_t> min_opt, max_opt, power_on_opt, fail_opt, dt_opt, curve_opt;
+        std::optional<std::string> gtin_opt;
+        if (needs_load) {
+            min_opt = dali.sendQuery(DALI_ADDRESS_TYPE_SHORT, shortAddr, DALI_COMMAND_QUERY_MIN_LEVEL);
+            max_opt = dali.sendQuery(DALI_ADDRESS_TYPE_SHORT, shortAddr, DALI_COMMAND_QUERY_MAX_LEVEL);
+            power_on_opt = dali.sendQuery(DALI_ADDRESS_TYPE_SHORT, shortAddr, DALI_COMMAND_QUERY_POWER_ON_LEVEL);
+            fail_opt = dali.sendQuery(DALI_ADDRESS_TYPE_SHORT, shortAddr, DALI_COMMAND_QUERY_SYSTEM_FAILURE_LEVEL);
+            gtin_opt = dali.getGTIN(shortAddr);
+            dt_opt = dali.getDeviceType(shortAddr);
+            if (dt_opt == 6) curve_opt = dali.getDimmingCurve(shortAddr);
+        }
+        const auto fade_opt = dali.sendQuery(DALI_ADDRESS_TYPE_SHORT, shortAddr, DALI_COMMAND_QUERY_FADE_TIME_FADE_RATE);
+        // DALI-1 gear does not answer, extended fade time then stays disabled
+        const auto ext_fade_opt = dali.sendQuery(DALI_ADDRESS_TYPE_SHORT, shortAddr, DALI_COMMAND_QUERY_EXTENDED_FADE_TIME);
 
         {
             std::lock_guard<std::mutex> lock(m_devices_mutex);
@@ -706,10 +882,20 @@ namespace daliMQTT
                     bool changed = false;
                     if (gtin_opt.has_value()) { g->gtin = gtin_opt.value(); changed = true; }
                     if (dt_opt.has_value()) { g->device_type = dt_opt; changed = true; }
+                    if (curve_opt.has_value()) {
+                        g->dimming_curve = *curve_opt == 1 ? DimmingCurve::Linear : DimmingCurve::Logarithmic;
+                        changed = true;
+                    }
                     if (min_opt.has_value()) { g->min_level = *min_opt; changed = true; }
                     if (max_opt.has_value()) { g->max_level = *max_opt; changed = true; }
                     if (power_on_opt.has_value()) { g->power_on_level = *power_on_opt; changed = true; }
                     if (fail_opt.has_value()) { g->system_failure_level = *fail_opt; changed = true; }
+                    if (fade_opt.has_value()) {
+                        g->fade_time = (*fade_opt >> 4) & 0x0F;
+                        g->fade_rate = *fade_opt & 0x0F;
+                        changed = true;
+                    }
+                    if (ext_fade_opt.has_value()) { g->extended_fade_time = *ext_fade_opt; changed = true; }
 
                     g->static_data_loaded = true;
                     if (changed) {
@@ -719,38 +905,62 @@ namespace daliMQTT
                 }
             }
         }
-        publishAttributes(longAddr);
+        if (needs_load) publishAttributes(longAddr);
     }
-    void DaliDeviceController::pollSingleDevice(const uint8_t shortAddr) {
+
+    void DaliDeviceController::pollSingleDevice(const uint8_t shortAddr, const bool forced) {
         DaliLongAddress_t longAddr = 0;
         bool known_device = false;
+        bool isControlGear = false;
+        bool initial_sync = false;
+        uint8_t cached_level = 0;
+        DevicePollPlan plan;
 
         {
             std::lock_guard<std::mutex> lock(m_devices_mutex);
             if (const auto it = m_short_to_long_map.find(shortAddr); it != m_short_to_long_map.end()) {
                 longAddr = it->second;
                 known_device = true;
+                if (const auto dev_it = m_devices.find(longAddr); dev_it != m_devices.end()) {
+                    if (const auto* gear = std::get_if<ControlGear>(&dev_it->second)) {
+                        isControlGear = true;
+                        initial_sync = gear->initial_sync_needed;
+                        cached_level = gear->current_level;
+                    }
+                }
             }
+            plan = m_poll_plans[shortAddr];
         }
         if (!known_device) return;
 
-        const auto levelOpt = pollAvailabilityAndLevel(shortAddr, longAddr);
-        if (!levelOpt) return; // Offline
-        const uint8_t actualLevel = *levelOpt;
+        const auto statusOpt = pollAvailabilityAndStatus(shortAddr, longAddr);
+        if (!statusOpt) return; // Offline
+        if (!isControlGear) return;
 
-        bool isControlGear = false;
+        const auto decision = DaliQueryPlanner::decide(plan, *statusOpt, forced, initial_sync);
+
+        uint8_t actualLevel = cached_level;
+        bool level_answered = false;
+        if (decision.level_is_off) {
+            actualLevel = 0;
+        } else if (decision.query_level) {
+            auto& dali = DaliAdapter::Instance();
+            if (const auto level_opt = dali.sendQuery(DALI_ADDRESS_TYPE_SHORT, shortAddr, DALI_COMMAND_QUERY_ACTUAL_LEVEL)) {
+                level_answered = true;
+                if (*level_opt != 255) actualLevel = *level_opt;
+            }
+        }
+        DaliQueryPlanner::record(plan, *statusOpt, decision, level_answered);
         {
             std::lock_guard<std::mutex> lock(m_devices_mutex);
-            if (m_devices.contains(longAddr)) {
-                isControlGear = std::holds_alternative<ControlGear>(m_devices.at(longAddr));
+            // A rediscovery in between reset the plans and may have moved the short address
+            if (const auto it = m_short_to_long_map.find(shortAddr); it != m_short_to_long_map.end() && it->second == longAddr) {
+                m_poll_plans[shortAddr] = plan;
             }
         }
-        if (!isControlGear) return;
-        auto& dali = DaliAdapter::Instance();
-        const auto statusOpt = dali.getDeviceStatus(shortAddr);
 
         checkDT8Features(shortAddr, longAddr);
-        const auto colorData = pollColorDataCyclic(shortAddr, longAddr, actualLevel);
+        const auto colorData = pollColorDataCyclic(shortAddr, longAddr, actualLevel, decision.query_color);
 
         updateDeviceState(longAddr, {
             .level = actualLevel,
@@ -761,6 +971,99 @@ namespace daliMQTT
 
         performInitialGroupSync(longAddr, actualLevel, colorData);
         initialStaticDataFetch(shortAddr, longAddr);
+        fetchSceneTable(shortAddr, longAddr);
+    }
+
+    void DaliDeviceController::fetchSceneTable(const uint8_t shortAddr, const DaliLongAddress_t longAddr) {
+        bool read_tc = false;
+        bool read_rgb = false;
+        {
+            std::lock_guard<std::mutex> lock(m_devices_mutex);
+            if (m_scene_checked.test(shortAddr)) return;
+            const auto it = m_devices.find(longAddr);
+            if (it == m_devices.end()) return;
+            const auto* gear = std::get_if<ControlGear>(&it->second);
+            if (!gear || !gear->static_data_loaded) return;
+            if (gear->scene_levels.has_value()) { // restored from NVS
+                m_scene_checked.set(shortAddr);
+                return;
+            }
+            if (gear->color.has_value()) {
+                read_tc = gear->color->supports_tc;
+                read_rgb = gear->color->supports_rgb;
+            }
+            m_scene_checked.set(shortAddr);
+        }
+
+        auto& dali = DaliAdapter::Instance();
+        std::array<uint8_t, 16> levels{};
+        std::array<DaliSceneColor, 16> colors{};
+        for (uint8_t scene = 0; scene < 16; ++scene) {
+            const auto level_opt = dali.sendQuery(DALI_ADDRESS_TYPE_SHORT, shortAddr, DALI_COMMAND_QUERY_SCENE_LEVEL_0 + scene);
+            if (!level_opt.has_value()) {
+                ESP_LOGW(TAG, "Scene table read for SA %d interrupted at scene %d", shortAddr, scene);
+                return; // Retried after the next discovery
+            }
+            levels[scene] = *level_opt;
+            if (*level_opt == 255) {
+                colors[scene].known = true;
+            } else if (read_tc || read_rgb) {
+                if (const auto color_opt = dali.getDT8SceneColor(shortAddr, scene, read_tc, read_rgb)) {
+                    colors[scene] = *color_opt;
+                }
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_devices_mutex);
+            const auto it = m_devices.find(longAddr);
+            if (it == m_devices.end()) return;
+            if (auto* gear = std::get_if<ControlGear>(&it->second)) {
+                gear->scene_levels = levels;
+                if (gear->color.has_value()) gear->color->scene_colors = colors;
+                m_nvs_dirty = true;
+                m_last_nvs_change_ts = esp_timer_get_time() / 1000;
+            }
+        }
+        ESP_LOGI(TAG, "Cached scene table for SA %d", shortAddr);
+    }
+
+    void DaliDeviceController::setCachedSceneLevel(const uint8_t shortAddr, const uint8_t scene, const uint8_t level) {
+        if (scene >= 16) return;
+        std::lock_guard<std::mutex> lock(m_devices_mutex);
+        const auto sa_it = m_short_to_long_map.find(shortAddr);
+        if (sa_it == m_short_to_long_map.end()) return;
+        const auto it = m_devices.find(sa_it->second);
+        if (it == m_devices.end()) return;
+        if (auto* gear = std::get_if<ControlGear>(&it->second)) {
+            if (!gear->scene_levels.has_value()) return; // Partial tables are never cached
+            (*gear->scene_levels)[scene] = level;
+            if (gear->color.has_value()) {
+                // Scene colour comes from the temporary colour, which we do not track
+                gear->color->scene_colors[scene] = DaliSceneColor{.known = (level == 255)};
+            }
+            m_nvs_dirty = true;
+            m_last_nvs_change_ts = esp_timer_get_time() / 1000;
+        }
+    }
+
+    std::optional<std::array<uint8_t, 16>> DaliDeviceController::getCachedSceneLevels(const DaliLongAddress_t longAddress) const {
+        std::lock_guard<std::mutex> lock(m_devices_mutex);
+        const auto it = m_devices.find(longAddress);
+        if (it == m_devices.end()) return std::nullopt;
+        if (const auto* gear = std::get_if<ControlGear>(&it->second)) {
+            return gear->scene_levels;
+        }
+        return std::nullopt;
+    }
+
+    void DaliDeviceController::applyOwnCommand(const uint8_t addr_byte, const uint8_t cmd_byte) {
+        // The sniffer does not receive our own transmissions, so model them the same way
+        SnifferProcessFrame(dali_frame_t{
+            .data = static_cast<uint32_t>((addr_byte << 8) | cmd_byte),
+            .length = 16,
+            .is_backward_frame = false,
+        });
     }
 
     std::bitset<64> DaliDeviceController::performFullInitialization() {
@@ -795,6 +1098,7 @@ namespace daliMQTT
         std::map<DaliLongAddress_t, DaliDevice> new_devices;
         std::map<uint8_t, DaliLongAddress_t> new_short_to_long_map;
         std::bitset<64> found_devices;
+        bool all_gear_mapped = true;
 
         for (uint8_t sa = 0; sa < 64; ++sa) {
             if (auto status_opt = dali.sendQuery(DALI_ADDRESS_TYPE_SHORT, sa, DALI_COMMAND_QUERY_STATUS); status_opt.has_value()) {
@@ -808,6 +1112,8 @@ namespace daliMQTT
                     dev.available = true;
                     new_devices.emplace(long_addr, dev);
                     new_short_to_long_map[sa] = long_addr;
+                } else {
+                    all_gear_mapped = false;
                 }
             }
 
@@ -832,14 +1138,30 @@ namespace daliMQTT
             vTaskDelay(pdMS_TO_TICKS(CONFIG_DALI2MQTT_DALI_POLL_DELAY_MS));
         }
 
+        if (all_gear_mapped) {
+            // Gear without a short address is invisible to the scan but still obeys broadcasts
+            const auto unaddressed = dali.hasGearWithoutShortAddress();
+            if (unaddressed.value_or(true)) {
+                ESP_LOGW(TAG, "Control gear without a short address is on the bus.");
+                all_gear_mapped = false;
+            }
+        }
+
         {
             std::lock_guard<std::mutex> lock(m_devices_mutex);
             m_devices = std::move(new_devices);
             m_short_to_long_map = std::move(new_short_to_long_map);
+            m_poll_plans = {};
+            m_fade_checked.reset();
+            m_scene_checked.reset();
             ESP_LOGI(TAG, "Discovery finished. Mapped %zu DALI devices.", m_devices.size());
             DaliAddressMap::save(m_devices);
             m_nvs_dirty = false;
         }
+        m_map_complete = all_gear_mapped;
+        rebuildTopics();
+        // Group member masks are indexed by short address
+        DaliGroupManagement::Instance().rebuildMemberMasks();
         return found_devices;
     }
 
@@ -887,4 +1209,5 @@ namespace daliMQTT
         }
         return std::nullopt;
     }
+
 } // daliMQTT
\ No newline at end of file
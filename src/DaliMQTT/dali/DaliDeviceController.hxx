@@ -2,6 +2,10 @@
 #define DALIMQTT_DALIDEVICECONTROLLER_HXX
 
 #include "dali/DaliAdapter.hxx"
+#include "dali/DaliQueryPlanner.hxx"
+#include "dali/DaliGearModel.hxx"
+#include "mqtt/MQTTTopics.hxx"
+#include "mqtt/MQTTBusSnapshot.hxx"
 
 namespace daliMQTT
 {
@@ -46,6 +50,12 @@ namespace daliMQTT
         [[nodiscard]] std::map<DaliLongAddress_t, DaliDevice> getDevices() const;
         [[nodiscard]] std::optional<uint8_t> getShortAddress(DaliLongAddress_t longAddress) const;
         [[nodiscard]] std::optional<DaliLongAddress_t> getLongAddress(uint8_t shortAddress, bool is24bitSpace = false) const;
+        /**
+         * True when the address map comes from a bus scan since boot in which every answering
+         * control gear was mapped and no gear answered QUERY MISSING SHORT ADDRESS, so a broadcast
+         * reaches no gear outside the map.
+         */
+        [[nodiscard]] bool isAddressMapComplete() const { return m_map_complete.load(); }
 
         /**
          * @brief Updates the state of a device in the cache and publishes to MQTT.
@@ -58,6 +68,8 @@ namespace daliMQTT
         void publishAttributes(DaliLongAddress_t longAddr) const;
 
         [[nodiscard]] std::optional<uint8_t> getLastLevel(DaliLongAddress_t longAddress) const;
+        /** Dimming curve of the control gear at a short address; the standard curve if unknown. */
+        [[nodiscard]] DimmingCurve getDimmingCurve(uint8_t shortAddress) const;
 
         /**
          * @brief Requests a sync (poll) for a specific device.
@@ -69,27 +81,83 @@ namespace daliMQTT
          */
         void requestBroadcastSync(uint32_t base_delay_ms, uint32_t stagger_ms);
 
+        /**
+         * @brief Updates one entry of a device's cached scene table after we programmed it.
+         */
+        void setCachedSceneLevel(uint8_t shortAddress, uint8_t scene, uint8_t level);
+
+        /**
+         * @brief Returns the cached scene table of a device, if it has been read.
+         */
+        [[nodiscard]] std::optional<std::array<uint8_t, 16>> getCachedSceneLevels(DaliLongAddress_t longAddress) const;
+
+        /**
+         * @brief Applies the state effects of a forward frame we sent ourselves (e.g. GO TO SCENE).
+         */
+        void applyOwnCommand(uint8_t addr_byte, uint8_t cmd_byte);
+
+        /**
+         * @brief Returns the precomputed MQTT topics of a device, or nullptr if it is not mapped.
+         */
+        [[nodiscard]] std::shared_ptr<const DeviceTopics> getDeviceTopics(DaliLongAddress_t longAddress) const;
+
+        /**
+         * @brief Rebuilds the per-device topics, e.g. after the base topic has changed.
+         */
+        void rebuildTopics();
+
+        /**
+         * @brief Fills the compact per-short-address state used by the bus snapshot topic.
+         */
+        void collectBusSnapshot(BusSnapshotEntries& entries) const;
+
+        /**
+         * @brief Publishes the cached state of all devices with a known (polled or restored) state.
+         */
+        void publishAllStates() const;
+
+        /**
+         * @brief Recomputes group states from the cached member device states.
+         * @param force_publish Publish every group even if its state did not change.
+         */
+        void syncGroupStatesFromDevices(bool force_publish = false) const;
 
     private:
         DaliDeviceController() = default;
 
+        static constexpr size_t STATE_PAYLOAD_BUFFER_SIZE = 128;
+        static constexpr size_t ATTRIBUTES_JSON_BUFFER_SIZE = 256;
+        static constexpr size_t EVENT_PAYLOAD_BUFFER_SIZE = 192;
+        static constexpr size_t TOPIC_BUFFER_SIZE = 128;
+
         void SnifferProcessFrame(const dali_frame_t& frame);
         void ProcessInputDeviceFrame(const dali_frame_t& frame) const;
+        static GearModelInput makeGearModelInput(const ControlGear& gear);
+        /**
+         * @brief Applies a sniffed configuration command to the cached gear parameters.
+         * @param clamped_level Set when a new min/max level moves the current level; the caller
+         *                      applies it through updateDeviceState so it is published and journalled.
+         * @return true if published attributes changed.
+         */
+        bool applySniffedConfigCommand(ControlGear& gear, uint8_t cmd_byte, std::optional<uint8_t>& clamped_level);
 
         std::bitset<64> discoverAndMapDevices();
         bool validateAddressMap();
-        void pollSingleDevice(uint8_t shortAddr);
+        void pollSingleDevice(uint8_t shortAddr, bool forced = false);
 
         struct ColorPollResult {
             std::optional<uint16_t> tc;
             std::optional<DaliRGB> rgb;
         };
 
-        std::optional<uint8_t> pollAvailabilityAndLevel(uint8_t shortAddr, DaliLongAddress_t longAddr);
+        std::optional<uint8_t> pollAvailabilityAndStatus(uint8_t shortAddr, DaliLongAddress_t longAddr);
         void checkDT8Features(uint8_t shortAddr, DaliLongAddress_t longAddr);
-        ColorPollResult pollColorDataCyclic(uint8_t shortAddr, DaliLongAddress_t longAddr, uint8_t current_level);
+        ColorPollResult pollColorDataCyclic(uint8_t shortAddr, DaliLongAddress_t longAddr, uint8_t current_level, bool force = false);
         void performInitialGroupSync(DaliLongAddress_t longAddr, uint8_t level, const ColorPollResult& colorData);
         void initialStaticDataFetch(uint8_t shortAddr, DaliLongAddress_t longAddr);
+        void fetchSceneTable(uint8_t shortAddr, DaliLongAddress_t longAddr);
+        void flushStateJournal();
+        void processFadeTransitions(int64_t now_ms);
 
         [[noreturn]] static void daliEventHandlerTask(void* pvParameters);
         [[noreturn]] static void daliSyncTask(void* pvParameters);
@@ -105,13 +173,27 @@ namespace daliMQTT
         std::map<uint8_t, DaliLongAddress_t> m_short_to_long_map{};
         mutable std::mutex m_devices_mutex{};
 
+        std::map<DaliLongAddress_t, std::shared_ptr<const DeviceTopics>> m_device_topics{};
+        std::string m_topic_base{};
+        mutable std::mutex m_topics_mutex{};
+
         std::vector<DeferredRequest> m_deferred_requests{};
         std::vector<uint8_t> m_priority_queue{};
         std::set<uint8_t> m_priority_set{};
         mutable std::mutex m_queue_mutex{};
         uint8_t m_round_robin_index{0};
+        std::array<DevicePollPlan, 64> m_poll_plans{};   // Guarded by m_devices_mutex, like the two bitsets below
+        std::optional<uint8_t> m_sniffed_dtr0{};   // Guarded by m_devices_mutex; sniffer and command workers write it
+        std::bitset<64> m_fade_checked{};
+        std::bitset<64> m_scene_checked{};
+        std::map<DaliLongAddress_t, FadeTransition> m_fade_transitions{};
+        int64_t m_last_fade_publish_ts{0};
         bool m_nvs_dirty{false};
         int64_t m_last_nvs_change_ts{0};
+        std::atomic<bool> m_map_complete{false};
+        std::set<DaliLongAddress_t> m_state_dirty{};
+        int64_t m_last_state_change_ts{0};
+        int64_t m_first_state_change_ts{0};    // Oldest change not yet journalled
     };
 
 } // daliMQTT
@@ -0,0 +1,127 @@
+#include "dali/DaliGearModel.hxx"
+#include "dali/DaliArcPower.hxx"
+#include "dali/driver/dali_commands.h"
+
+namespace daliMQTT
+{
+    // Fade time codes 1..15: 0.5 * sqrt(2^X) seconds
+    static constexpr std::array<uint32_t, 16> FADE_TIME_MS = {
+        0, 707, 1000, 1414, 2000, 2828, 4000, 5657, 8000, 11314, 16000, 22627, 32000, 45255, 64000, 90510
+    };
+
+    // Extended fade time multipliers (bits 6..4): disabled, 100 ms, 1 s, 10 s, 1 min
+    static constexpr std::array<uint32_t, 5> EXTENDED_FADE_MULTIPLIER_MS = { 0, 100, 1000, 10000, 60000 };
+
+    static constexpr uint32_t UP_DOWN_DURATION_MS = 200;
+
+    std::optional<uint32_t> DaliGearModel::fadeTimeMs(const GearModelInput& gear) {
+        if (!gear.fade_time.has_value()) return std::nullopt;
+        const uint8_t code = *gear.fade_time & 0x0F;
+        if (code > 0) return FADE_TIME_MS[code];
+
+        const uint8_t multiplier = (gear.extended_fade_time >> 4) & 0x07;
+        const uint8_t base = (gear.extended_fade_time & 0x0F) + 1;
+        if (multiplier >= EXTENDED_FADE_MULTIPLIER_MS.size()) return 0;
+        return base * EXTENDED_FADE_MULTIPLIER_MS[multiplier];
+    }
+
+    std::optional<uint32_t> DaliGearModel::transitionMs(const GearModelInput& gear, const uint8_t command, const bool is_arc_power) {
+        if (is_arc_power) {
+            return (command == 255) ? std::optional<uint32_t>{0} : fadeTimeMs(gear);
+        }
+        if ((command >= DALI_COMMAND_GO_TO_SCENE_0 && command <= DALI_COMMAND_GO_TO_SCENE_15) ||
+            command == DALI_COMMAND_GO_TO_LAST_ACTIVE_LEVEL) {
+            return fadeTimeMs(gear);
+        }
+        if (command == DALI_COMMAND_UP || command == DALI_COMMAND_DOWN) {
+            return UP_DOWN_DURATION_MS;
+        }
+        return 0;
+    }
+
+    uint8_t DaliGearModel::stepsPerUpDown(const uint8_t fade_rate) {
+        return DaliArcPower::stepsPerUpDown(fade_rate);
+    }
+
+    bool DaliGearModel::affectsArcPower(const uint8_t command) {
+        return command <= DALI_COMMAND_GO_TO_LAST_ACTIVE_LEVEL ||
+               (command >= DALI_COMMAND_GO_TO_SCENE_0 && command <= DALI_COMMAND_GO_TO_SCENE_15) ||
+               command == DALI_COMMAND_RESET;
+    }
+
+    uint8_t DaliGearModel::clampLevel(const GearModelInput& gear, const uint8_t level) {
+        if (level == 0) return 0;
+        return std::clamp(level, gear.min_level, gear.max_level);
+    }
+
+    GearPrediction DaliGearModel::predictArcPower(const GearModelInput& gear, const uint8_t level) {
+        if (level == 255) {
+            // MASK: stops a running fade, the level it stops at is not known
+            return { PredictionKind::Unknown, gear.current_level };
+        }
+        return { PredictionKind::Exact, clampLevel(gear, level) };
+    }
+
+    GearPrediction DaliGearModel::predictCommand(const GearModelInput& gear, const uint8_t command) {
+        const uint8_t level = gear.current_level;
+        const bool is_on = level > 0;
+
+        switch (command) {
+            case DALI_COMMAND_OFF:
+                return { PredictionKind::Exact, 0 };
+
+            case DALI_COMMAND_UP:
+            case DALI_COMMAND_DOWN: {
+                // UP/DOWN never switch the lamp on or off
+                if (!is_on) return { PredictionKind::NoChange, level };
+                if (!gear.fade_rate.has_value()) return { PredictionKind::Unknown, level };
+                const int steps = stepsPerUpDown(*gear.fade_rate);
+                const int target = (command == DALI_COMMAND_UP) ? level + steps : level - steps;
+                const auto clamped = static_cast<uint8_t>(std::clamp<int>(target, gear.min_level, gear.max_level));
+                return { PredictionKind::Estimated, clamped };
+            }
+
+            case DALI_COMMAND_STEP_UP:
+                if (!is_on) return { PredictionKind::NoChange, level };
+                return { PredictionKind::Exact, static_cast<uint8_t>(std::min<int>(level + 1, gear.max_level)) };
+
+            case DALI_COMMAND_STEP_DOWN:
+                if (!is_on) return { PredictionKind::NoChange, level };
+                return { PredictionKind::Exact, static_cast<uint8_t>(std::max<int>(level - 1, gear.min_level)) };
+
+            case DALI_COMMAND_RECALL_MAX_LEVEL:
+                return { PredictionKind::Exact, gear.max_level };
+
+            case DALI_COMMAND_RECALL_MIN_LEVEL:
+                return { PredictionKind::Exact, gear.min_level };
+
+            case DALI_COMMAND_STEP_DOWN_AND_OFF:
+                if (!is_on) return { PredictionKind::NoChange, level };
+                if (level <= gear.min_level) return { PredictionKind::Exact, 0 };
+                return { PredictionKind::Exact, static_cast<uint8_t>(level - 1) };
+
+            case DALI_COMMAND_ON_AND_STEP_UP:
+                if (!is_on) return { PredictionKind::Exact, gear.min_level };
+                return { PredictionKind::Exact, static_cast<uint8_t>(std::min<int>(level + 1, gear.max_level)) };
+
+            case DALI_COMMAND_GO_TO_LAST_ACTIVE_LEVEL:
+                return { PredictionKind::Exact, clampLevel(gear, gear.last_level > 0 ? gear.last_level : gear.max_level) };
+
+            case DALI_COMMAND_RESET:
+                // Reset values: actual level 254 (within the reset max level)
+                return { PredictionKind::Exact, 254 };
+
+            default:
+                break;
+        }
+
+        if (command >= DALI_COMMAND_GO_TO_SCENE_0 && command <= DALI_COMMAND_GO_TO_SCENE_15) {
+            if (!gear.scene_levels.has_value()) return { PredictionKind::Unknown, level };
+            const uint8_t scene_level = (*gear.scene_levels)[command - DALI_COMMAND_GO_TO_SCENE_0];
+            if (scene_level == 255) return { PredictionKind::NoChange, level };
+            return { PredictionKind::Exact, clampLevel(gear, scene_level) };
+        }
+
+        return { PredictionKind::NoChange, level };
+    }
+}
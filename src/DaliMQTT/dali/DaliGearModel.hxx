@@ -0,0 +1,64 @@
+#ifndef DALIMQTT_DALIGEARMODEL_HXX
+#define DALIMQTT_DALIGEARMODEL_HXX
+
+namespace daliMQTT {
+
+    /** Cached gear parameters the behaviour model works from. */
+    struct GearModelInput {
+        uint8_t current_level{0};
+        uint8_t last_level{254};                        // Last active level
+        uint8_t min_level{1};
+        uint8_t max_level{254};
+        std::optional<uint8_t> fade_time;               // Fade time code 0..15, if known
+        std::optional<uint8_t> fade_rate;               // Fade rate code 1..15, if known
+        uint8_t extended_fade_time{0};                  // Extended fade time byte
+        std::optional<std::array<uint8_t, 16>> scene_levels; // 255 = not part of scene
+    };
+
+    enum class PredictionKind {
+        NoChange,   // Command provably leaves the level untouched
+        Exact,      // Level is fully determined by the cached parameters
+        Estimated,  // Level is approximate (e.g. UP/DOWN), confirm later
+        Unknown,    // Cache lacks the data, device must be queried
+    };
+
+    struct GearPrediction {
+        PredictionKind kind{PredictionKind::NoChange};
+        uint8_t level{0};
+    };
+
+    /**
+     * @brief Models IEC 62386-102 arc power behaviour of a control gear.
+     *
+     * Predictions describe the target arc power level reached once any fade completes.
+     * The dimming curve does not affect the arc power level itself, only its light output.
+     */
+    class DaliGearModel {
+    public:
+        /** Direct arc power control (DAPC). */
+        static GearPrediction predictArcPower(const GearModelInput& gear, uint8_t level);
+
+        /** Indirect arc power commands (OFF, UP, RECALL MAX, GO TO SCENE, ...). */
+        static GearPrediction predictCommand(const GearModelInput& gear, uint8_t command);
+
+        /** True for commands that can change the arc power level. */
+        static bool affectsArcPower(uint8_t command);
+
+        /** Clamps a non-zero level into the gear's [min, max] range. */
+        static uint8_t clampLevel(const GearModelInput& gear, uint8_t level);
+
+        /** Fade time in ms, honouring the extended fade time when fade time is 0. */
+        static std::optional<uint32_t> fadeTimeMs(const GearModelInput& gear);
+
+        /**
+         * @brief Duration of the transition started by a command.
+         * @return 0 for instant changes, nullopt if the fade settings are unknown.
+         */
+        static std::optional<uint32_t> transitionMs(const GearModelInput& gear, uint8_t command, bool is_arc_power);
+
+        /** Arc power steps covered by one 200 ms UP/DOWN fade at the given fade rate code. */
+        static uint8_t stepsPerUpDown(uint8_t fade_rate);
+    };
+}
+
+#endif //DALIMQTT_DALIGEARMODEL_HXX
@@ -3,8 +3,16 @@
 #include "system/ConfigManager.hxx"
 #include "dali/DaliDeviceController.hxx"
 #include "dali/DaliAdapter.hxx"
+#include "dali/DaliArcPower.hxx"
+#include "dali/DaliGearModel.hxx"
 #include "mqtt/MQTTClient.hxx"
+#include "mqtt/MQTTPublishCoalescer.hxx"
 #include "utils/DaliLongAddrConversions.hxx"
+#include "utils/JsonWriter.hxx"
+#include "mqtt/MQTTPayloadFormats.hxx"
+#include "utils/NvsHandle.hxx"
+#include <esp_system.h>
+#include <esp_timer.h>
 
 namespace daliMQTT
 {
@@ -12,76 +20,178 @@ namespace daliMQTT
 
     void DaliGroupManagement::init() {
         ESP_LOGI(TAG, "Initializing DALI Group Manager...");
-        loadFromConfig();
+        // A restart must not lose changes still waiting for the debounce
+        esp_register_shutdown_handler([] { Instance().flushPendingSave(); });
+        loadAssignments();
+        rebuildMemberMasks();
+        rebuildTopics();
     }
 
-    void DaliGroupManagement::loadFromConfig() {
+    void DaliGroupManagement::rebuildMemberMasks() {
+        std::lock_guard<std::mutex> members_lock(m_members_mutex);
+        // Copied so the device controller is not called with m_mutex held
+        const GroupAssignments assignments = getAllAssignments();
+        const auto& device_controller = DaliDeviceController::Instance();
+
+        std::array<uint64_t, 16> members{};
+        std::array<DaliLongAddress_t, 64> long_addresses{};
+        long_addresses.fill(NO_LONG_ADDRESS);
+        for (const auto& [long_addr, groups] : assignments) {
+            if (groups.none()) continue;
+            const auto short_addr = device_controller.getShortAddress(long_addr);
+            if (!short_addr || *short_addr >= 64) continue;
+            long_addresses[*short_addr] = long_addr;
+            for (uint8_t group = 0; group < 16; ++group) {
+                if (groups.test(group)) members[group] |= 1ULL << *short_addr;
+            }
+        }
+        // Readers load a mask with acquire, so they see at least these long addresses
+        for (uint8_t short_addr = 0; short_addr < 64; ++short_addr) {
+            m_member_long_addresses[short_addr].store(long_addresses[short_addr], std::memory_order_relaxed);
+        }
+        for (uint8_t group = 0; group < 16; ++group) {
+            m_group_members[group].store(members[group], std::memory_order_release);
+        }
+    }
+
+    void DaliGroupManagement::rebuildTopics() {
+        const std::string base_topic = ConfigManager::Instance().getMqttBaseTopic();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (uint8_t group_id = 0; group_id < 16; ++group_id) {
+            m_group_state_topics[group_id] = utils::stringFormat("%s/light/group/%d/state", base_topic.c_str(), group_id);
+        }
+    }
+
+    void DaliGroupManagement::loadAssignments() {
+        if (!loadFromBlob()) {
+            migrateFromConfig();
+        }
+    }
+
+    bool DaliGroupManagement::loadFromBlob() {
+        NvsHandle nvs_handle(NVS_NAMESPACE, NVS_READONLY);
+        if (!nvs_handle) return false;
+
+        size_t required_size = 0;
+        esp_err_t err = nvs_get_blob(nvs_handle.get(), GROUPS_KEY, nullptr, &required_size);
+        if (err != ESP_OK || required_size < sizeof(BlobHeader)) return false;
+
+        std::vector<uint8_t> blob(required_size);
+        err = nvs_get_blob(nvs_handle.get(), GROUPS_KEY, blob.data(), &required_size);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Error reading group assignments blob: %s", esp_err_to_name(err));
+            return false;
+        }
+
+        BlobHeader header{};
+        std::memcpy(&header, blob.data(), sizeof(header));
+        if (header.version != BLOB_VERSION ||
+            required_size != sizeof(BlobHeader) + header.count * sizeof(GroupAssignmentRecord)) {
+            ESP_LOGE(TAG, "Unsupported or corrupt group assignments blob (version %u, %zu bytes).", header.version, required_size);
+            return false;
+        }
+
         std::lock_guard<std::mutex> lock(m_mutex);
-        const auto& config = ConfigManager::Instance().getConfig();
         m_assignments.clear();
+        for (uint16_t i = 0; i < header.count; ++i) {
+            GroupAssignmentRecord record{};
+            std::memcpy(&record, blob.data() + sizeof(BlobHeader) + i * sizeof(record), sizeof(record));
+            m_assignments[record.long_address] = std::bitset<16>(record.groups);
+        }
+        ESP_LOGI(TAG, "Loaded %zu device group assignments from NVS.", m_assignments.size());
+        return true;
+    }
 
-        cJSON* root = cJSON_Parse(config.dali_group_assignments.c_str());
-        if (!cJSON_IsObject(root)) {
-            ESP_LOGW(TAG, "No valid group assignments found in NVS or JSON is invalid. Starting fresh.");
+    void DaliGroupManagement::migrateFromConfig() {
+        const auto config = ConfigManager::Instance().getSnapshot();
+        cJSON* root = cJSON_Parse(config->dali_group_assignments.c_str());
+        if (!cJSON_IsObject(root) || cJSON_GetArraySize(root) == 0) {
+            ESP_LOGI(TAG, "No group assignments stored yet. Starting fresh.");
             cJSON_Delete(root);
             return;
         }
 
-        cJSON* device_item = nullptr;
-        cJSON_ArrayForEach(device_item, root) {
-            auto long_addr_opt = utils::stringToLongAddress(device_item->string);
-            if (!long_addr_opt) {
-                ESP_LOGW(TAG, "Skipping invalid key '%s' in DALI group assignments JSON.", device_item->string);
-                continue;
-            }
-            DaliLongAddress_t long_address = *long_addr_opt;
-
-            std::bitset<16> groups;
-            if (cJSON_IsArray(device_item)) {
-                cJSON* group_item = nullptr;
-                cJSON_ArrayForEach(group_item, device_item) {
-                    if (cJSON_IsNumber(group_item) && group_item->valueint >= 0 && group_item->valueint < 16) {
-                        groups.set(group_item->valueint);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_assignments.clear();
+            cJSON* device_item = nullptr;
+            cJSON_ArrayForEach(device_item, root) {
+                auto long_addr_opt = utils::stringToLongAddress(device_item->string);
+                if (!long_addr_opt) {
+                    ESP_LOGW(TAG, "Skipping invalid key '%s' in DALI group assignments JSON.", device_item->string);
+                    continue;
+                }
+
+                std::bitset<16> groups;
+                if (cJSON_IsArray(device_item)) {
+                    cJSON* group_item = nullptr;
+                    cJSON_ArrayForEach(group_item, device_item) {
+                        if (cJSON_IsNumber(group_item) && group_item->valueint >= 0 && group_item->valueint < 16) {
+                            groups.set(group_item->valueint);
+                        }
                     }
                 }
+                m_assignments[*long_addr_opt] = groups;
             }
-            m_assignments[long_address] = groups;
+            ESP_LOGI(TAG, "Migrating %zu device group assignments from JSON to binary.", m_assignments.size());
         }
-
         cJSON_Delete(root);
-        ESP_LOGI(TAG, "Loaded %zu device group assignments from NVS.", m_assignments.size());
+
+        if (writeBlob() == ESP_OK) {
+            ConfigManager::Instance().saveDaliGroupAssignments("{}");
+        }
+    }
+
+    esp_err_t DaliGroupManagement::scheduleSave() {
+        // Written by the device sync loop, see flushPendingSaveIfDue()
+        m_last_save_request_ms = esp_timer_get_time() / 1000;
+        m_save_pending = true;
+        return ESP_OK;
+    }
+
+    void DaliGroupManagement::flushPendingSaveIfDue(const int64_t now_ms) {
+        if (m_save_pending && (now_ms - m_last_save_request_ms) > CONFIG_DALI2MQTT_DALI_GROUP_SAVE_DEBOUNCE_MS) {
+            writeBlob();
+        }
     }
 
-    esp_err_t DaliGroupManagement::saveToConfig() {
-        cJSON* root = nullptr;
-        char* json_string = nullptr;
+    void DaliGroupManagement::flushPendingSave() {
+        if (m_save_pending) {
+            writeBlob();
+        }
+    }
 
+    esp_err_t DaliGroupManagement::writeBlob() {
+        std::vector<uint8_t> blob;
         {
             std::lock_guard<std::mutex> lock(m_mutex);
-            root = cJSON_CreateObject();
-            if (!root) return ESP_ERR_NO_MEM;
-
+            m_save_pending = false;
+            const BlobHeader header{BLOB_VERSION, static_cast<uint16_t>(m_assignments.size())};
+            blob.resize(sizeof(BlobHeader) + m_assignments.size() * sizeof(GroupAssignmentRecord));
+            std::memcpy(blob.data(), &header, sizeof(header));
+            size_t offset = sizeof(BlobHeader);
             for (const auto& [addr, groups] : m_assignments) {
-                const auto addr_str = utils::longAddressToString(addr);
-                cJSON* group_array = cJSON_CreateArray();
-                for (int i = 0; i < 16; ++i) {
-                    if (groups.test(i)) {
-                        cJSON_AddItemToArray(group_array, cJSON_CreateNumber(i));
-                    }
-                }
-                cJSON_AddItemToObject(root, addr_str.data(), group_array);
+                const GroupAssignmentRecord record{addr, static_cast<uint16_t>(groups.to_ulong()), 0};
+                std::memcpy(blob.data() + offset, &record, sizeof(record));
+                offset += sizeof(record);
             }
         }
 
-        json_string = cJSON_PrintUnformatted(root);
-        cJSON_Delete(root);
-        if (!json_string) {
-            return ESP_ERR_NO_MEM;
+        NvsHandle nvs_handle(NVS_NAMESPACE, NVS_READWRITE);
+        if (!nvs_handle) {
+            ESP_LOGE(TAG, "Failed to open NVS for writing group assignments.");
+            m_save_pending = true;
+            return ESP_FAIL;
         }
-
-        const esp_err_t err = ConfigManager::Instance().saveDaliGroupAssignments(json_string);
-        free(json_string);
-        return err;
+        esp_err_t err = nvs_set_blob(nvs_handle.get(), GROUPS_KEY, blob.data(), blob.size());
+        if (err == ESP_OK) err = nvs_commit(nvs_handle.get());
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to save group assignments: %s", esp_err_to_name(err));
+            m_save_pending = true;
+            return err;
+        }
+        ESP_LOGI(TAG, "Saved group assignments (%zu bytes).", blob.size());
+        return ESP_OK;
     }
 
     GroupAssignments DaliGroupManagement::getAllAssignments() const {
@@ -124,7 +234,8 @@ namespace daliMQTT
         }
 
         if (result == ESP_OK) {
-            saveToConfig();
+            rebuildMemberMasks();
+            scheduleSave();
 
             std::bitset<16> current_groups;
             {
@@ -144,49 +255,94 @@ namespace daliMQTT
     }
 
     esp_err_t DaliGroupManagement::setAllAssignments(const GroupAssignments& newAssignments) {
-        struct CommandToSend {
-            uint8_t short_address;
-            uint8_t group;
-            bool assign;
+        auto& controller = DaliDeviceController::Instance();
+        GearByShortAddress gear{};
+        uint64_t present = 0;
+        bool all_available = true;
+        for (const auto& [long_addr, device] : controller.getDevices()) {
+            if (!std::holds_alternative<ControlGear>(device)) continue;
+            const auto& id = getIdentity(device);
+            if (id.short_address >= 64) continue;
+            if (!id.available) {
+                all_available = false;
+                continue;
+            }
+            gear[id.short_address] = long_addr;
+            present |= uint64_t{1} << id.short_address;
+        }
+        // A broadcast also reaches unavailable or unmapped gear, which the plan knows nothing about
+        const bool allow_broadcast = all_available && controller.isAddressMapComplete();
+
+        DaliGroupPlanner::MemberMasks current{};
+        DaliGroupPlanner::MemberMasks target{};
+        const auto toMasks = [&gear](const GroupAssignments& assignments, DaliGroupPlanner::MemberMasks& masks) {
+            for (uint8_t short_addr = 0; short_addr < 64; ++short_addr) {
+                if (!gear[short_addr]) continue;
+                const auto it = assignments.find(*gear[short_addr]);
+                if (it == assignments.end()) continue;
+                for (uint8_t group = 0; group < 16; ++group) {
+                    if (it->second.test(group)) masks[group] |= uint64_t{1} << short_addr;
+                }
+            }
         };
-        std::vector<CommandToSend> commands_to_send;
         {
             std::lock_guard<std::mutex> lock(m_mutex);
-            std::set<DaliLongAddress_t> all_addresses;
-            for(const auto& long_addr : m_assignments | std::views::keys) all_addresses.insert(long_addr);
-            for(const auto& long_addr : newAssignments | std::views::keys) all_addresses.insert(long_addr);
-
-            for (const auto& long_addr : all_addresses) {
-                std::bitset<16> old_groups = m_assignments.contains(long_addr) ? m_assignments.at(long_addr) : std::bitset<16>();
-                std::bitset<16> new_groups = newAssignments.contains(long_addr) ? newAssignments.at(long_addr) : std::bitset<16>();
-
-                if (old_groups == new_groups) continue;
-                
-                auto short_addr_opt = DaliDeviceController::Instance().getShortAddress(long_addr);
-                if (!short_addr_opt) continue;
-                std::bitset<16> changed_bits = old_groups ^ new_groups;
-                for (uint8_t i = 0; i < 16; ++i) {
-                    if (changed_bits.test(i)) {
-                        commands_to_send.push_back({*short_addr_opt, i, new_groups.test(i)});
-                    }
-                }
-            }
+            toMasks(m_assignments, current);
+            toMasks(newAssignments, target);
             m_assignments = newAssignments;
         }
 
+        const auto commands = DaliGroupPlanner::plan(present, current, target, allow_broadcast);
+        ESP_LOGI(TAG, "Sync: Reconfiguring groups with %zu config commands", commands.size());
+
         auto& dali = DaliAdapter::Instance();
-        for (const auto& [short_address, group, assign] : commands_to_send) {
-            if (assign) {
-                ESP_LOGI(TAG, "Sync: Adding device %d to group %d", short_address, group);
-                dali.assignToGroup(short_address, group);
-            } else {
-                ESP_LOGI(TAG, "Sync: Removing device %d from group %d", short_address, group);
-                dali.removeFromGroup(short_address, group);
-            }
-            vTaskDelay(pdMS_TO_TICKS(CONFIG_DALI2MQTT_DALI_INTER_FRAME_DELAY_MS));
+        DaliGroupPlanner::MemberMasks expected = current;
+        uint64_t touched = 0;
+        for (const auto& command : commands) {
+            touched |= DaliGroupPlanner::reached(expected, present, command);
+            DaliGroupPlanner::apply(expected, present, command);
+            const auto& [addr_type, addr, group, add] = command;
+            ESP_LOGD(TAG, "Sync: %s group %d via %s %d", add ? "Adding to" : "Removing from", group,
+                     addr_type == DALI_ADDRESS_TYPE_SHORT ? "device" :
+                     addr_type == DALI_ADDRESS_TYPE_GROUP ? "group" : "broadcast", addr);
+            const uint8_t opcode = (add ? DALI_COMMAND_ADD_TO_GROUP_0 : DALI_COMMAND_REMOVE_FROM_GROUP_0) + group;
+            dali.sendCommand(addr_type, addr, opcode, true);
         }
+
+        const bool verified = verifyGroups(touched, target, gear);
+        rebuildMemberMasks();
         publishAllGroups();
-        return saveToConfig();
+        const esp_err_t save_result = scheduleSave();
+        return verified ? save_result : ESP_ERR_INVALID_RESPONSE;
+    }
+
+    bool DaliGroupManagement::verifyGroups(uint64_t touched, const DaliGroupPlanner::MemberMasks& target,
+                                           const GearByShortAddress& gear) {
+        auto& dali = DaliAdapter::Instance();
+        bool verified = true;
+        for (; touched != 0; touched &= touched - 1) {
+            const auto short_addr = static_cast<uint8_t>(std::countr_zero(touched));
+            if (!gear[short_addr]) continue;
+
+            std::bitset<16> wanted;
+            for (uint8_t group = 0; group < 16; ++group) {
+                wanted[group] = (target[group] >> short_addr) & 1;
+            }
+            const auto groups_opt = dali.getDeviceGroups(short_addr);
+            if (!groups_opt) {
+                ESP_LOGW(TAG, "Device %d did not answer QUERY GROUPS after reconfiguration.", short_addr);
+                verified = false;
+                continue;
+            }
+            if (*groups_opt != wanted) {
+                ESP_LOGW(TAG, "Device %d has groups 0x%04lX, expected 0x%04lX.", short_addr,
+                         groups_opt->to_ulong(), wanted.to_ulong());
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_assignments[*gear[short_addr]] = *groups_opt;
+                verified = false;
+            }
+        }
+        return verified;
     }
 
     esp_err_t DaliGroupManagement::refreshAssignmentsFromBus() {
@@ -226,9 +382,10 @@ namespace daliMQTT
             m_assignments = new_assignments;
             ESP_LOGI(TAG, "Finished refreshing group assignments. Found assignments for %zu devices.", m_assignments.size());
         }
+        rebuildMemberMasks();
         publishAllGroups();
 
-        return saveToConfig();
+        return scheduleSave();
     }
     DaliGroup DaliGroupManagement::getGroupState(const uint8_t group_id) const {
         std::lock_guard<std::mutex> lock(m_mutex);
@@ -241,27 +398,22 @@ namespace daliMQTT
         auto const& mqtt = MQTTClient::Instance();
         if (mqtt.getStatus() != MqttStatus::CONNECTED) return;
 
-        const auto config = ConfigManager::Instance().getConfig();
-        const auto addr_str = utils::longAddressToString(longAddr);
-        const std::string topic = utils::stringFormat("%s/light/%s/groups", config.mqtt_base_topic.c_str(), addr_str.data()); // base/light/{LONG_ADDRESS}/groups
-
-        cJSON* root = cJSON_CreateObject();
-        cJSON* groups_array = cJSON_CreateArray();
+        const auto topics = DaliDeviceController::Instance().getDeviceTopics(longAddr); // base/light/{LONG_ADDRESS}/groups
+        if (!topics) return;
 
+        utils::StaticJsonWriter<DEVICE_GROUPS_JSON_BUFFER_SIZE> json;
+        json.beginObject().beginArray("groups");
         for (uint8_t i = 0; i < 16; ++i) {
             if (groups.test(i)) {
-                cJSON_AddItemToArray(groups_array, cJSON_CreateNumber(i));
+                json.element(i);
             }
         }
-        cJSON_AddItemToObject(root, "groups", groups_array);
+        json.endArray().endObject();
 
-        char* payload = cJSON_PrintUnformatted(root);
-        if (payload) {
-            mqtt.publish(topic, payload, 1, true);
-            free(payload);
-            ESP_LOGD(TAG, "Published groups for %s", addr_str.data());
+        if (json.ok()) {
+            mqtt.publish(topics->groups, json.view(), 1, true);
+            ESP_LOGD(TAG, "Published groups for %s", utils::longAddressToString(longAddr).data());
         }
-        cJSON_Delete(root);
     }
 
     void DaliGroupManagement::publishAllGroups() const {
@@ -270,10 +422,11 @@ namespace daliMQTT
             publishDeviceGroupState(longAddr, groups);
         }
     }
-    void DaliGroupManagement::updateGroupState(const uint8_t group_id, const DaliPublishState& state) {
+    void DaliGroupManagement::updateGroupState(const uint8_t group_id, const DaliPublishState& state, const bool force_publish) {
         if (group_id >= 16) return;
 
         bool changed = false;
+        DaliGroup snapshot;
         {
             std::lock_guard<std::mutex> lock(m_mutex);
             auto& group = m_group_states[group_id];
@@ -297,12 +450,11 @@ namespace daliMQTT
                 group.rgb = state.rgb;
                 changed = true;
             }
+            snapshot = group;
         }
 
-        publishGroupState(group_id,
-                          m_group_states[group_id].current_level,
-                          m_group_states[group_id].color_temp,
-                          m_group_states[group_id].rgb);
+        if (!changed && !force_publish) return;
+        publishGroupState(group_id, snapshot.current_level, snapshot.color_temp, snapshot.rgb);
     }
 
     void DaliGroupManagement::restoreGroupLevel(const uint8_t group_id) {
@@ -320,68 +472,49 @@ namespace daliMQTT
     void DaliGroupManagement::publishGroupState(const uint8_t group_id, const uint8_t level,
                                                 std::optional<uint16_t> color_temp,
                                                 std::optional<DaliRGB> rgb) const {
-        auto const& mqtt = MQTTClient::Instance();
-        const auto config = ConfigManager::Instance().getConfig();
-
-        // Topic: base/light/group/+/state
-        const std::string state_topic = utils::stringFormat("%s/light/group/%d/state", config.mqtt_base_topic.c_str(), group_id);
+        if (group_id >= 16) return;
 
-        cJSON* root = cJSON_CreateObject();
-        cJSON_AddStringToObject(root, "state", (level > 0 ? "ON" : "OFF"));
-        cJSON_AddNumberToObject(root, "brightness", level);
+        utils::StaticPayloadWriter<GROUP_STATE_PAYLOAD_BUFFER_SIZE> writer(STATE_PAYLOAD_FORMAT);
+        writer.beginObject()
+            .add("state", level > 0 ? "ON" : "OFF")
+            .add("brightness", levelToBrightness(level));
 
         if (color_temp.has_value()) {
-            cJSON_AddNumberToObject(root, "color_temp", *color_temp);
+            writer.add("color_temp", *color_temp);
         }
         if (rgb.has_value()) {
-            cJSON* color = cJSON_CreateObject();
-            cJSON_AddNumberToObject(color, "r", rgb->r);
-            cJSON_AddNumberToObject(color, "g", rgb->g);
-            cJSON_AddNumberToObject(color, "b", rgb->b);
-            cJSON_AddItemToObject(root, "color", color);
+            writer.beginObject("color")
+                .add("r", rgb->r)
+                .add("g", rgb->g)
+                .add("b", rgb->b)
+                .endObject();
         }
+        writer.endObject();
+        if (!writer.ok()) return;
 
-        char* payload = cJSON_PrintUnformatted(root);
-        if (payload) {
-            ESP_LOGD(TAG, "Publishing Group %d State: %s", group_id, payload);
-            mqtt.publish(state_topic, payload, 0, true);
-            free(payload);
-        }
-        cJSON_Delete(root);
+        ESP_LOGD(TAG, "Publishing Group %d State (%zu bytes)", group_id, writer.view().size());
+        std::lock_guard<std::mutex> lock(m_mutex); // Guards the topic slot against rebuildTopics()
+        MQTTPublishCoalescer::Instance().submit(m_group_state_topics[group_id], writer.view(), 0, true);
     }
 
-    void DaliGroupManagement::stepGroupLevel(const uint8_t group_id, const bool is_up) {
+    void DaliGroupManagement::stepGroupLevel(const uint8_t group_id, const uint8_t command) {
         if (group_id >= 16) return;
-        constexpr int STEP_SIZE = 10; // FIXME: hard coded step
-        uint8_t new_level = 0;
-        bool should_update = false;
+        GearPrediction prediction;
 
         {
             std::lock_guard<std::mutex> lock(m_mutex);
-            const uint8_t current = m_group_states[group_id].current_level;
-
-            if (current == 0) {
+            // Members are not modelled, assume the reset fade rate for UP/DOWN
+            const GearModelInput group_model{
+                .current_level = m_group_states[group_id].current_level,
+                .fade_rate = DaliArcPower::DEFAULT_FADE_RATE,
+            };
+            prediction = DaliGearModel::predictCommand(group_model, command);
+            if (prediction.kind == PredictionKind::NoChange || prediction.level == group_model.current_level) {
                 return;
             }
-
-            int calculated = current;
-            if (is_up) {
-                calculated += STEP_SIZE;
-                if (calculated > 254) calculated = 254;
-            } else {
-                calculated -= STEP_SIZE;
-                if (calculated < 1) calculated = 1;
-            }
-
-            if (calculated != current) {
-                new_level = static_cast<uint8_t>(calculated);
-                should_update = true;
-            }
         }
 
-        if (should_update) {
-            updateGroupState(group_id, {.level = new_level});
-        }
+        updateGroupState(group_id, {.level = prediction.level});
     }
 
 }
\ No newline at end of file
@@ -1,11 +1,19 @@
 #ifndef DALIMQTT_DALIGROUPMANAGEMENT_HXX
 #define DALIMQTT_DALIGROUPMANAGEMENT_HXX
 #include "dali/DaliСommon.hxx"
+#include "dali/DaliGroupPlanner.hxx"
 
 namespace daliMQTT
 {
     using GroupAssignments = std::map<DaliLongAddress_t, std::bitset<16>>;
 
+    struct GroupAssignmentRecord {
+        DaliLongAddress_t long_address;
+        uint16_t groups;                // Bit per group
+        uint16_t _reserved;
+    };
+    static_assert(sizeof(GroupAssignmentRecord) == 8, "GroupAssignmentRecord layout is persisted in NVS");
+
     class DaliGroupManagement {
     public:
         DaliGroupManagement(const DaliGroupManagement&) = delete;
@@ -25,20 +33,56 @@ namespace daliMQTT
         /** Gets groups for a specific device. */
         [[nodiscard]] std::optional<std::bitset<16>> getGroupsForDevice(DaliLongAddress_t longAddress) const;
 
+        /**
+         * @brief Short addresses in a group, bit n set for short address n. Lock-free.
+         * Resolve with forEachGroupMember().
+         */
+        [[nodiscard]] uint64_t getGroupMembers(const uint8_t group_id) const {
+            return group_id < 16 ? m_group_members[group_id].load(std::memory_order_acquire) : 0;
+        }
+
+        /** Calls fn(long_address) for each member of a group. Lock-free and allocation-free. */
+        template<typename Fn>
+        void forEachGroupMember(const uint8_t group_id, Fn&& fn) const {
+            for (uint64_t members = getGroupMembers(group_id); members != 0; members &= members - 1) {
+                const DaliLongAddress_t long_addr =
+                    m_member_long_addresses[std::countr_zero(members)].load(std::memory_order_relaxed);
+                if (long_addr != NO_LONG_ADDRESS) fn(long_addr);
+            }
+        }
+
+        /** Recomputes the per-group member masks, e.g. after short addresses changed. */
+        void rebuildMemberMasks();
+
         /** Sets the group membership for a device. */
         esp_err_t setGroupMembership(DaliLongAddress_t longAddress, uint8_t group, bool assigned);
 
-        /** Sets all assignments (e.g. from WebUI). */
+        /**
+         * @brief Sets all assignments (e.g. from WebUI).
+         * The bus is reconfigured with the fewest config commands DaliGroupPlanner finds. Afterwards
+         * every mapped device the commands touched is read back with QUERY GROUPS.
+         * @return ESP_ERR_INVALID_RESPONSE if a device did not answer or reports other groups;
+         *         the groups it reports are taken over.
+         */
         esp_err_t setAllAssignments(const GroupAssignments& newAssignments);
 
         /** Refreshes group assignments by querying all devices on the bus. */
         esp_err_t refreshAssignmentsFromBus();
 
+        /** Writes assignments still waiting for the save debounce. Also runs on esp_restart(). */
+        void flushPendingSave();
+
+        /** Writes pending assignments once the debounce has passed. Called from the device sync loop. */
+        void flushPendingSaveIfDue(int64_t now_ms);
+
         /** Gets the state of a specific group. */
         [[nodiscard]] DaliGroup getGroupState(uint8_t group_id) const;
 
-        /** Updates the state of a group. */
-        void updateGroupState(uint8_t group_id, const DaliPublishState& state);
+        /**
+        * @brief Updates the state of a group.
+        * @param force_publish: publish even if nothing changed, e.g. to republish after a reconnect
+        */
+        void updateGroupState(uint8_t group_id, const DaliPublishState& state, bool force_publish = false);
 
         /** Restores the group level. */
         void restoreGroupLevel(uint8_t group_id);
@@ -46,17 +90,49 @@ namespace daliMQTT
         /** Publishes the current group configuration to MQTT. */
         void publishAllGroups() const;
 
+        /** Rebuilds the group state topics, e.g. after the base topic has changed. */
+        void rebuildTopics();
+
 
         /**
-        * @brief Relative level change (Step Up/Down)
-        * @param is_up: true to increase, false to decrease
+        * @brief Relative level change (UP, DOWN, STEP UP, STEP DOWN) seen on the bus
+        * @param command: the indirect arc power command, modelled with DaliGearModel
         */
-        void stepGroupLevel(uint8_t group_id, bool is_up);
+        void stepGroupLevel(uint8_t group_id, uint8_t command);
     private:
         DaliGroupManagement() = default;
 
-        void loadFromConfig();
-        esp_err_t saveToConfig();
+        static constexpr size_t GROUP_STATE_PAYLOAD_BUFFER_SIZE = 128;
+        static constexpr size_t DEVICE_GROUPS_JSON_BUFFER_SIZE = 96;
+
+        struct BlobHeader {
+            uint16_t version;
+            uint16_t count;
+        };
+
+        static constexpr uint16_t BLOB_VERSION = 1;
+        static constexpr char NVS_NAMESPACE[] = "dali_state";
+        static constexpr char GROUPS_KEY[] = "DALIGroups";
+
+        void loadAssignments();
+        /** Reads the binary blob. Returns false if there is none or it is unusable. */
+        bool loadFromBlob();
+        /** One-time import of the JSON string kept in AppConfig by earlier firmware. */
+        void migrateFromConfig();
+        /** Saves after CONFIG_DALI2MQTT_DALI_GROUP_SAVE_DEBOUNCE_MS without further changes. */
+        esp_err_t scheduleSave();
+        esp_err_t writeBlob();
+
+        // Long address of the control gear at each short address
+        using GearByShortAddress = std::array<std::optional<DaliLongAddress_t>, 64>;
+
+        /**
+         * @brief Reads QUERY GROUPS back from every device in `touched` and compares it with `target`.
+         * Mismatching devices are stored in m_assignments as read. Gear outside the address map
+         * that a group or broadcast command reached is not seen.
+         * @return true if all devices matched.
+         */
+        bool verifyGroups(uint64_t touched, const DaliGroupPlanner::MemberMasks& target, const GearByShortAddress& gear);
 
         void publishGroupState(uint8_t group_id, uint8_t level,
                                        std::optional<uint16_t> color_temp,
@@ -64,7 +140,16 @@ namespace daliMQTT
         void publishDeviceGroupState(DaliLongAddress_t longAddr, const std::bitset<16>& groups) const;
 
         GroupAssignments m_assignments{};
+        // Reverse index of m_assignments by short address, for group fan-out on the hot path
+        std::array<std::atomic<uint64_t>, 16> m_group_members{};
+        // Long address of each group member by short address, stored before the masks that publish it
+        static constexpr DaliLongAddress_t NO_LONG_ADDRESS = 0xFFFFFFFF;
+        std::array<std::atomic<DaliLongAddress_t>, 64> m_member_long_addresses{};
+        std::mutex m_members_mutex{};   // Serializes rebuilds, readers never take it
+        std::atomic<bool> m_save_pending{false};
+        std::atomic<int64_t> m_last_save_request_ms{0};
         std::array<DaliGroup, 16> m_group_states{};
+        std::array<std::string, 16> m_group_state_topics{}; // base/light/group/{ID}/state
         mutable std::mutex m_mutex{};
     };
 
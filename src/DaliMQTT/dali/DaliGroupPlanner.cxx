@@ -0,0 +1,107 @@
+#include "dali/DaliGroupPlanner.hxx"
+
+namespace daliMQTT
+{
+    /**
+     * Covers the devices in `remaining` with group-addressed commands, taking the group that
+     * reaches the most of them each time. A group is usable when `usable` says so; one that
+     * reaches a single device is no cheaper than addressing the device directly.
+     */
+    template<typename Usable>
+    static void coverWithGroups(std::vector<GroupConfigCommand>& commands, uint64_t& remaining,
+                                const DaliGroupPlanner::MemberMasks& current, const uint8_t group,
+                                const bool add, Usable usable) {
+        while (std::popcount(remaining) > 1) {
+            uint8_t best_group = 0;
+            int best_count = 1;
+            for (uint8_t h = 0; h < 16; ++h) {
+                if (h == group || !usable(current[h])) continue;
+                const int count = std::popcount(current[h] & remaining);
+                if (count > best_count) {
+                    best_count = count;
+                    best_group = h;
+                }
+            }
+            if (best_count < 2) break;
+            commands.push_back({DALI_ADDRESS_TYPE_GROUP, best_group, group, add});
+            remaining &= ~current[best_group];
+        }
+    }
+
+    static void addIndividual(std::vector<GroupConfigCommand>& commands, uint64_t devices, const uint8_t group,
+                              const bool add) {
+        while (devices != 0) {
+            const auto short_address = static_cast<uint8_t>(std::countr_zero(devices));
+            commands.push_back({DALI_ADDRESS_TYPE_SHORT, short_address, group, add});
+            devices &= devices - 1;
+        }
+    }
+
+    /** Plans one group, optionally starting with a broadcast that adds or removes all present gear. */
+    static std::vector<GroupConfigCommand> planGroup(const uint64_t present, const DaliGroupPlanner::MemberMasks& current,
+                                                     const uint64_t wanted, const uint8_t group,
+                                                     const std::optional<bool> broadcast_add) {
+        std::vector<GroupConfigCommand> commands;
+        uint64_t members = current[group];
+        if (broadcast_add) {
+            commands.push_back({DALI_ADDRESS_TYPE_BROADCAST, 0, group, *broadcast_add});
+            members = *broadcast_add ? present : 0;
+        }
+
+        uint64_t to_add = wanted & ~members;
+        uint64_t to_remove = members & ~wanted;
+        coverWithGroups(commands, to_add, current, group, true,
+                        [wanted](const uint64_t h_members) { return (h_members & ~wanted) == 0; });
+        coverWithGroups(commands, to_remove, current, group, false,
+                        [wanted](const uint64_t h_members) { return (h_members & wanted) == 0; });
+        addIndividual(commands, to_add, group, true);
+        addIndividual(commands, to_remove, group, false);
+        return commands;
+    }
+
+    std::vector<GroupConfigCommand> DaliGroupPlanner::plan(const uint64_t present, const MemberMasks& current,
+                                                           const MemberMasks& target, const bool allow_broadcast) {
+        std::vector<GroupConfigCommand> result;
+        MemberMasks members = current;
+
+        for (uint8_t group = 0; group < 16; ++group) {
+            const uint64_t wanted = target[group] & present;
+            if ((members[group] & present) == wanted) continue;
+
+            auto best = planGroup(present, members, wanted, group, std::nullopt);
+            for (const bool broadcast_add : {false, true}) {
+                if (!allow_broadcast) break;
+                auto candidate = planGroup(present, members, wanted, group, broadcast_add);
+                if (candidate.size() < best.size()) best = std::move(candidate);
+            }
+
+            // Later groups may be addressed through this one, so track what it now contains
+            for (const auto& command : best) {
+                apply(members, present, command);
+                result.push_back(command);
+            }
+        }
+        return result;
+    }
+
+    uint64_t DaliGroupPlanner::reached(const MemberMasks& masks, const uint64_t present, const GroupConfigCommand& command) {
+        switch (command.addr_type) {
+            case DALI_ADDRESS_TYPE_SHORT:
+                return command.addr < 64 ? uint64_t{1} << command.addr : 0;
+            case DALI_ADDRESS_TYPE_GROUP:
+                return command.addr < 16 ? masks[command.addr] : 0;
+            case DALI_ADDRESS_TYPE_BROADCAST:
+                return present;
+            default:
+                return 0;
+        }
+    }
+
+    void DaliGroupPlanner::apply(MemberMasks& masks, const uint64_t present, const GroupConfigCommand& command) {
+        if (command.group >= 16) return;
+
+        const uint64_t devices = reached(masks, present, command);
+        if (command.add) masks[command.group] |= devices;
+        else masks[command.group] &= ~devices;
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef DALIMQTT_DALIGROUPPLANNER_HXX
+#define DALIMQTT_DALIGROUPPLANNER_HXX
+
+#include "dali/DaliСommon.hxx"
+
+namespace daliMQTT {
+
+    /** One ADD TO GROUP or REMOVE FROM GROUP frame pair. */
+    struct GroupConfigCommand {
+        dali_addressType_t addr_type;   // SHORT, GROUP or BROADCAST
+        uint8_t addr;                   // Short address or group, unused for broadcast
+        uint8_t group;
+        bool add;
+    };
+
+    /**
+     * @brief Plans group reconfiguration with as few config commands as possible.
+     *
+     * Each group is planned on its own, starting from the current members and, when allowed,
+     * also from a broadcast REMOVE FROM GROUP or a broadcast ADD TO GROUP. The remaining differences
+     * are covered by commands addressed to other groups whose members all need the same change,
+     * and whatever is left is sent per short address. The cheapest start wins; ties keep
+     * per-device commands.
+     *
+     * A group-addressed command is assumed to reach exactly the members in `current`, so stale
+     * cached memberships, or gear missing from the address map, make the result differ from the
+     * plan. The caller has to read the touched devices back.
+     */
+    class DaliGroupPlanner {
+    public:
+        using MemberMasks = std::array<uint64_t, 16>;   // Bit per short address, per group
+
+        /**
+         * @param present Short addresses of the mapped gear that answers; only these are planned for.
+         * @param current Current members of each group, as cached.
+         * @param target Wanted members of each group, limited to present.
+         * @param allow_broadcast Whether a broadcast may be taken to reach exactly `present`. Only true
+         *        when the address map is complete and all of its gear is available.
+         * @return Commands in execution order; later commands rely on memberships set by earlier ones.
+         */
+        static std::vector<GroupConfigCommand> plan(uint64_t present, const MemberMasks& current, const MemberMasks& target,
+                                                    bool allow_broadcast);
+
+        /** Short addresses the command is expected to reach, given the current masks. */
+        static uint64_t reached(const MemberMasks& masks, uint64_t present, const GroupConfigCommand& command);
+
+        /** Updates the masks as the gear would on receiving the command. */
+        static void apply(MemberMasks& masks, uint64_t present, const GroupConfigCommand& command);
+    };
+}
+
+#endif //DALIMQTT_DALIGROUPPLANNER_HXX
@@ -0,0 +1,37 @@
+#include "dali/DaliQueryPlanner.hxx"
+
+namespace daliMQTT
+{
+    PollDecision DaliQueryPlanner::decide(const DevicePollPlan& plan, const uint8_t status, const bool forced, const bool initial_sync) {
+        PollDecision decision;
+        const bool lamp_on = (status & DaliStatusBits::LAMP_ON) != 0;
+        const bool abnormal = (status & (DaliStatusBits::LAMP_FAILURE |
+                                         DaliStatusBits::RESET_STATE |
+                                         DaliStatusBits::POWER_FAILURE)) != 0;
+
+        if (!lamp_on && !abnormal) {
+            // Arc power is off: level is 0 and colour cannot be observed.
+            decision.level_is_off = true;
+            return decision;
+        }
+
+        const bool status_changed = !plan.last_status.has_value() || *plan.last_status != status;
+        const bool fading = (status & DaliStatusBits::FADE_RUNNING) != 0;
+        const bool verify_due = plan.polls_since_level_query + 1 >= LEVEL_VERIFY_EVERY;
+
+        decision.query_level = forced || initial_sync || abnormal || status_changed || fading || verify_due;
+
+        const bool turned_on = plan.last_status.has_value() && (*plan.last_status & DaliStatusBits::LAMP_ON) == 0;
+        decision.query_color = lamp_on && (forced || initial_sync || turned_on);
+        return decision;
+    }
+
+    void DaliQueryPlanner::record(DevicePollPlan& plan, const uint8_t status, const PollDecision& decision, const bool level_answered) {
+        plan.last_status = status;
+        if ((decision.query_level && level_answered) || decision.level_is_off) {
+            plan.polls_since_level_query = 0;
+        } else if (plan.polls_since_level_query < UINT8_MAX) {
+            ++plan.polls_since_level_query;
+        }
+    }
+}
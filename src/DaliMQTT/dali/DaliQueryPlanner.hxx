@@ -0,0 +1,56 @@
+#ifndef DALIMQTT_DALIQUERYPLANNER_HXX
+#define DALIMQTT_DALIQUERYPLANNER_HXX
+
+namespace daliMQTT {
+
+    // QUERY STATUS answer bits (IEC 62386-102)
+    namespace DaliStatusBits {
+        constexpr uint8_t GEAR_FAILURE      = 0x01;
+        constexpr uint8_t LAMP_FAILURE      = 0x02;
+        constexpr uint8_t LAMP_ON           = 0x04;
+        constexpr uint8_t LIMIT_ERROR       = 0x08;
+        constexpr uint8_t FADE_RUNNING      = 0x10;
+        constexpr uint8_t RESET_STATE       = 0x20;
+        constexpr uint8_t MISSING_SHORT     = 0x40;
+        constexpr uint8_t POWER_FAILURE     = 0x80;
+    }
+
+    /** Reusable per-device poll plan, carried between poll cycles. */
+    struct DevicePollPlan {
+        std::optional<uint8_t> last_status;
+        uint8_t polls_since_level_query{0};
+    };
+
+    /** Follow-up queries to issue after QUERY STATUS. */
+    struct PollDecision {
+        bool query_level{false};    // QUERY ACTUAL LEVEL is needed
+        bool level_is_off{false};   // Status proves the lamp is off, level is 0
+        bool query_color{false};    // Force a DT8 colour read now
+    };
+
+    /**
+     * @brief Chooses the minimal query set for a device.
+     *
+     * The plan is "STATUS only, escalate on change": QUERY STATUS is always sent, and
+     * QUERY ACTUAL LEVEL or colour reads are only added when the status byte, the poll
+     * reason or the verification counter say the cached values may be stale.
+     */
+    class DaliQueryPlanner {
+    public:
+        /** A lit, unchanged device still gets its level re-read every N polls. */
+        static constexpr uint8_t LEVEL_VERIFY_EVERY = 8;
+
+        /**
+         * @param plan Plan state from previous polls of this device.
+         * @param status Fresh QUERY STATUS answer.
+         * @param forced Poll was explicitly requested (sniffer uncertainty, MQTT sync).
+         * @param initial_sync Device has not been confirmed since boot.
+         */
+        static PollDecision decide(const DevicePollPlan& plan, uint8_t status, bool forced, bool initial_sync);
+
+        /** Records the outcome of a poll in the device plan. */
+        static void record(DevicePollPlan& plan, uint8_t status, const PollDecision& decision, bool level_answered);
+    };
+}
+
+#endif //DALIMQTT_DALIQUERYPLANNER_HXX
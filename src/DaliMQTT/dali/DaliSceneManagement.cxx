@@ -17,48 +17,73 @@ namespace daliMQTT
         }
         ESP_LOGI(TAG, "Activating DALI Scene %d", sceneId);
         auto& dali = DaliAdapter::Instance();
-        return dali.sendCommand(DALI_ADDRESS_TYPE_BROADCAST, 0, DALI_COMMAND_GO_TO_SCENE_0 + sceneId);
+        const esp_err_t res = dali.sendCommand(DALI_ADDRESS_TYPE_BROADCAST, 0, DALI_COMMAND_GO_TO_SCENE_0 + sceneId);
+        if (res == ESP_OK) {
+            // Resulting states come from the cached scene tables, no read-back needed
+            DaliDeviceController::Instance().applyOwnCommand(0xFF, DALI_COMMAND_GO_TO_SCENE_0 + sceneId);
+        }
+        return res;
     }
 
-    esp_err_t DaliSceneManagement::saveScene(uint8_t sceneId, const SceneDeviceLevels& levels) const
+    SceneWriteBatches DaliSceneManagement::planWrites(const SceneDeviceLevels& requested, const SceneDeviceLevels& cached) {
+        SceneWriteBatches batches;
+        for (const auto& [addr, level] : requested) {
+            if (const auto it = cached.find(addr); it != cached.end() && it->second == level) continue;
+            batches[level].push_back(addr);
+        }
+        return batches;
+    }
+
+    esp_err_t DaliSceneManagement::saveScene(const uint8_t sceneId, const SceneDeviceLevels& levels) const
     {
         if (sceneId >= 16) {
             return ESP_ERR_INVALID_ARG;
         }
-        ESP_LOGI(TAG, "Saving configuration for DALI Scene %d for %zu devices", sceneId, levels.size());
-        auto& dali = DaliAdapter::Instance();
-
-        for (const auto& [addr, level] : levels) {
-            ESP_LOGD(TAG, "Setting device %d to level %d for scene %d", addr, level, sceneId);
-
-            esp_err_t res = dali.sendCommand(
-                DALI_ADDRESS_TYPE_SPECIAL_CMD,
-                level,
-                DALI_SPECIAL_COMMAND_DATA_TRANSFER_REGISTER
-            );
-            if (res != ESP_OK) {
-                ESP_LOGE(TAG, "Failed to set DTR for device %d", addr);
-                continue;
+        auto& controller = DaliDeviceController::Instance();
+        SceneDeviceLevels cached;
+        for (const auto addr : levels | std::views::keys) {
+            const auto long_addr = controller.getLongAddress(addr);
+            if (!long_addr) continue;
+            if (const auto table = controller.getCachedSceneLevels(*long_addr)) {
+                cached[addr] = (*table)[sceneId];
             }
-            vTaskDelay(pdMS_TO_TICKS(CONFIG_DALI2MQTT_DALI_INTER_FRAME_DELAY_MS));
+        }
 
+        const auto batches = planWrites(levels, cached);
+        size_t writes = 0;
+        for (const auto& addresses : batches | std::views::values) writes += addresses.size();
+        ESP_LOGI(TAG, "Saving DALI Scene %d: %zu of %zu devices changed, %zu distinct levels",
+                 sceneId, writes, levels.size(), batches.size());
 
-            res = dali.sendCommand(
-                DALI_ADDRESS_TYPE_SHORT,
-                addr,
-                DALI_COMMAND_STORE_DTR_AS_SCENE_0 + sceneId,
-                true
-            );
-            if (res != ESP_OK) {
-                ESP_LOGE(TAG, "Failed to store scene %d for device %d", sceneId, addr);
+        auto& dali = DaliAdapter::Instance();
+        for (const auto& [level, addresses] : batches) {
+            // No other task may load DTR0 between the load and the stores
+            const auto bus = dali.reserveBus();
+            dali.sendCommand(DALI_ADDRESS_TYPE_SPECIAL_CMD, level, DALI_SPECIAL_COMMAND_DATA_TRANSFER_REGISTER);
+            for (const uint8_t addr : addresses) {
+                ESP_LOGD(TAG, "Storing level %d as scene %d for device %d", level, sceneId, addr);
+                dali.sendCommand(DALI_ADDRESS_TYPE_SHORT, addr, DALI_COMMAND_STORE_DTR_AS_SCENE_0 + sceneId, true);
             }
+        }
 
-            vTaskDelay(pdMS_TO_TICKS(CONFIG_DALI2MQTT_DALI_INTER_FRAME_DELAY_MS));
+        esp_err_t result = ESP_OK;
+        for (const auto& [level, addresses] : batches) {
+            for (const uint8_t addr : addresses) {
+                const auto stored = dali.sendQuery(DALI_ADDRESS_TYPE_SHORT, addr, DALI_COMMAND_QUERY_SCENE_LEVEL_0 + sceneId);
+                if (!stored.has_value() || *stored != level) {
+                    ESP_LOGW(TAG, "Device %d did not confirm level %d for scene %d", addr, level, sceneId);
+                    result = ESP_ERR_INVALID_RESPONSE;
+                }
+                if (stored.has_value()) {
+                    controller.setCachedSceneLevel(addr, sceneId, *stored);
+                }
+            }
         }
 
         ESP_LOGI(TAG, "Finished saving configuration for Scene %d", sceneId);
-        return ESP_OK;
+        return result;
     }
+
     SceneDeviceLevels DaliSceneManagement::getSceneLevels(uint8_t sceneId) const
     {
         SceneDeviceLevels results;
@@ -67,11 +92,16 @@ namespace daliMQTT
         auto& dali = DaliAdapter::Instance();
         auto devices = DaliDeviceController::Instance().getDevices();
 
-        ESP_LOGI(TAG, "Querying levels for Scene %d...", sceneId);
+        ESP_LOGI(TAG, "Reading levels for Scene %d...", sceneId);
 
         for (const auto& device : devices | std::views::values) {
-            auto* gear = std::get_if<ControlGear>(&device);
-            if (!gear->available) continue;
+            const auto* gear = std::get_if<ControlGear>(&device);
+            if (!gear || !gear->available) continue;
+
+            if (gear->scene_levels.has_value()) {
+                results[gear->short_address] = (*gear->scene_levels)[sceneId];
+                continue;
+            }
 
             auto level_opt = dali.sendQuery(
                 DALI_ADDRESS_TYPE_SHORT,
@@ -84,7 +114,6 @@ namespace daliMQTT
             } else {
                 results[gear->short_address] = 255;
             }
-            vTaskDelay(pdMS_TO_TICKS(CONFIG_DALI2MQTT_DALI_INTER_FRAME_DELAY_MS));
         }
         return results;
     }
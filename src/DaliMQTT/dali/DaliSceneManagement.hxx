@@ -6,6 +6,9 @@ namespace daliMQTT
     /** Map: short_address -> brightness_level (0-254) */
     using SceneDeviceLevels = std::map<uint8_t, uint8_t>;
 
+    /** Map: level -> short addresses to store it for; one DTR0 load serves the whole list */
+    using SceneWriteBatches = std::map<uint8_t, std::vector<uint8_t>>;
+
     class DaliSceneManagement {
     public:
         DaliSceneManagement(const DaliSceneManagement&) = delete;
@@ -19,9 +22,20 @@ namespace daliMQTT
         void init();
 
         esp_err_t activateScene(uint8_t sceneId) const;
+        /**
+         * @brief Stores scene levels, writing only entries that differ from the cached scene tables.
+         * Every written entry is read back and the cache updated with what the gear holds.
+         * @return ESP_ERR_INVALID_RESPONSE if a device did not confirm its level.
+         */
         esp_err_t saveScene(uint8_t sceneId, const SceneDeviceLevels& levels) const;
         [[nodiscard]] SceneDeviceLevels getSceneLevels(uint8_t sceneId) const;
 
+        /**
+         * @brief Groups the requested levels by level, skipping devices whose cached level already matches.
+         * @param cached Scene level per short address, for devices with a cached scene table.
+         */
+        [[nodiscard]] static SceneWriteBatches planWrites(const SceneDeviceLevels& requested, const SceneDeviceLevels& cached);
+
     private:
         DaliSceneManagement() = default;
     };
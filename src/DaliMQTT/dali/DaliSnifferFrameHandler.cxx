@@ -2,9 +2,18 @@
 #include <dali/DaliGroupManagement.hxx>
 #include <mqtt/MQTTClient.hxx>
 #include "utils/DaliLongAddrConversions.hxx"
+#include <esp_timer.h>
 
 namespace daliMQTT {
     static constexpr char TAG[] = "DaliSnifferFrameHandler";
+    static constexpr uint32_t FADE_PUBLISH_INTERVAL_MS = CONFIG_DALI2MQTT_DALI_FADE_PUBLISH_INTERVAL_MS;
+    static constexpr uint32_t FADE_CONFIRM_MARGIN_MS = 100;
+    static constexpr uint32_t UNKNOWN_FADE_CONFIRM_DELAY_MS = 400;
+
+    static bool isSceneRecall(const uint8_t cmd_byte) {
+        return cmd_byte >= DALI_COMMAND_GO_TO_SCENE_0 && cmd_byte <= DALI_COMMAND_GO_TO_SCENE_15;
+    }
+
     void DaliDeviceController::SnifferProcessFrame(const dali_frame_t& frame) {
         if (frame.is_backward_frame) {
             ESP_LOGD(TAG, "Process sniffed backward frame 0x%02X", frame.data & 0xFF);
@@ -15,6 +24,15 @@ namespace daliMQTT {
         uint8_t addr_byte = (frame.data >> 8) & 0xFF;
         uint8_t cmd_byte = frame.data & 0xFF;
 
+        // Special commands (101x xxx1, 110x xxx1) carry data instead of an address
+        if (addr_byte >= 0xA1 && addr_byte <= 0xCB && (addr_byte & 0x01)) {
+            if (addr_byte == DALI_SPECIAL_COMMAND_DATA_TRANSFER_REGISTER) {
+                std::lock_guard<std::mutex> lock(m_devices_mutex);
+                m_sniffed_dtr0 = cmd_byte;
+            }
+            return;
+        }
+
         std::vector<DaliLongAddress_t> affected_devices;
         std::optional<uint8_t> target_group_id = std::nullopt;
 
@@ -50,170 +68,252 @@ namespace daliMQTT {
         }
 
         if (target_group_id.has_value()) {
-            auto all_assignments = DaliGroupManagement::Instance().getAllAssignments();
-            for (const auto& [long_addr, groups] : all_assignments) {
-                if (groups.test(target_group_id.value())) {
-                    affected_devices.push_back(long_addr);
+            auto& group_management = DaliGroupManagement::Instance();
+            affected_devices.reserve(std::popcount(group_management.getGroupMembers(*target_group_id)));
+            group_management.forEachGroupMember(*target_group_id, [&affected_devices](const DaliLongAddress_t long_addr) {
+                affected_devices.push_back(long_addr);
+            });
+        }
+
+        std::vector<std::pair<DaliLongAddress_t, DaliPublishState>> predicted_updates;
+        std::vector<std::pair<DaliLongAddress_t, uint32_t>> confirm_devices; // device, confirm after (ms)
+        std::vector<DaliLongAddress_t> attributes_changed;
+        std::optional<uint8_t> predicted_group_level;
+        const bool is_arc_power = (addr_byte & 0x01) == 0;
+        const bool models_level = is_arc_power || DaliGearModel::affectsArcPower(cmd_byte);
+        const int64_t now_ms = esp_timer_get_time() / 1000;
+
+        if (!is_arc_power && cmd_byte == DALI_COMMAND_STORE_ACTUAL_LEVEL) {
+            // DTR0 now holds a per-device value we cannot follow
+            std::lock_guard<std::mutex> lock(m_devices_mutex);
+            m_sniffed_dtr0.reset();
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_devices_mutex);
+            for (const auto& long_addr : affected_devices) {
+                const auto it = m_devices.find(long_addr);
+                if (it == m_devices.end()) continue;
+                auto* gear = std::get_if<ControlGear>(&it->second);
+                if (!gear) continue;
+
+                if (!is_arc_power) {
+                    std::optional<uint8_t> clamped_level;
+                    if (applySniffedConfigCommand(*gear, cmd_byte, clamped_level)) {
+                        attributes_changed.push_back(long_addr);
+                    }
+                    if (clamped_level) {
+                        predicted_updates.emplace_back(long_addr, DaliPublishState{.level = *clamped_level});
+                    }
+                }
+                if (!models_level) continue;
+
+                const auto input = makeGearModelInput(*gear);
+                const auto prediction = is_arc_power
+                    ? DaliGearModel::predictArcPower(input, cmd_byte)
+                    : DaliGearModel::predictCommand(input, cmd_byte);
+                const auto transition_ms = DaliGearModel::transitionMs(input, cmd_byte, is_arc_power);
+                // Confirm once the transition has ended; unknown fade settings fall back to a fixed delay
+                const uint32_t confirm_after_ms = transition_ms.has_value()
+                    ? *transition_ms + FADE_CONFIRM_MARGIN_MS
+                    : UNKNOWN_FADE_CONFIRM_DELAY_MS;
+
+                DaliPublishState update{};
+                bool confirm = prediction.kind != PredictionKind::Exact;
+                if (!is_arc_power && isSceneRecall(cmd_byte) && prediction.kind == PredictionKind::Exact && gear->color.has_value()) {
+                    const auto& scene_color = gear->color->scene_colors[cmd_byte & 0x0F];
+                    if (scene_color.known) {
+                        update.color_temp = scene_color.tc;
+                        update.rgb = scene_color.rgb;
+                        if (scene_color.tc) update.active_mode = DaliColorMode::Tc;
+                        if (scene_color.rgb) update.active_mode = DaliColorMode::Rgb;
+                    } else {
+                        confirm = true; // Level is known, colour has to be read back
+                    }
+                }
+
+                uint8_t resulting_level = gear->current_level;
+                switch (prediction.kind) {
+                    case PredictionKind::Exact:
+                    case PredictionKind::Estimated:
+                        resulting_level = prediction.level;
+                        if (FADE_PUBLISH_INTERVAL_MS > 0 && transition_ms.value_or(0) > 0 && prediction.level != gear->current_level) {
+                            m_fade_transitions[long_addr] = FadeTransition{
+                                .start_level = gear->current_level,
+                                .target_level = prediction.level,
+                                .start_ts = now_ms,
+                                .end_ts = now_ms + *transition_ms,
+                            };
+                        } else {
+                            m_fade_transitions.erase(long_addr);
+                            update.level = prediction.level;
+                        }
+                        if (update.level || update.color_temp || update.rgb) {
+                            predicted_updates.emplace_back(long_addr, update);
+                        }
+                        if (confirm) {
+                            confirm_devices.emplace_back(long_addr, confirm_after_ms);
+                        }
+                        break;
+                    case PredictionKind::Unknown:
+                        m_fade_transitions.erase(long_addr);
+                        confirm_devices.emplace_back(long_addr, confirm_after_ms);
+                        continue;
+                    case PredictionKind::NoChange:
+                        break;
                 }
+                // group takes max level of any member
+                predicted_group_level = std::max(predicted_group_level.value_or(0), resulting_level);
             }
         }
 
-        if (target_group_id.has_value()) {
+        if (target_group_id.has_value() && models_level) {
             auto& group_mgr = DaliGroupManagement::Instance();
             const uint8_t gid = target_group_id.value();
-            if ((addr_byte & 0x01) == 0) { // DACP
-                group_mgr.updateGroupState(gid, {.level = cmd_byte});
-            } else {                       // Command
+            if (predicted_group_level.has_value()) {
+                group_mgr.updateGroupState(gid, {.level = *predicted_group_level});
+            } else if (is_arc_power) { // DACP, no modelled members
+                if (cmd_byte != 255) group_mgr.updateGroupState(gid, {.level = cmd_byte});
+            } else {                   // Command, no modelled members
                 switch (cmd_byte) {
                 case DALI_COMMAND_OFF:
-                case DALI_COMMAND_STEP_DOWN_AND_OFF:
                     group_mgr.updateGroupState(gid, {.level = 0});
                     break;
-                case DALI_COMMAND_RECALL_MAX_LEVEL:
-                    group_mgr.updateGroupState(gid, {.level = 254});
-                    break;
-                case DALI_COMMAND_RECALL_MIN_LEVEL:
-                    group_mgr.updateGroupState(gid, {.level = 1});
-                    break;
                 case DALI_COMMAND_ON_AND_STEP_UP:
                     group_mgr.restoreGroupLevel(gid);
                     break;
                 case DALI_COMMAND_UP:
                 case DALI_COMMAND_STEP_UP:
-                    group_mgr.stepGroupLevel(gid, true);
-                    break;
                 case DALI_COMMAND_DOWN:
                 case DALI_COMMAND_STEP_DOWN:
-                    group_mgr.stepGroupLevel(gid, false);
+                    group_mgr.stepGroupLevel(gid, cmd_byte);
                     break;
-                default: break; // TODO: Other cmd
+                default: break;
                 }
             }
         }
 
-        if (affected_devices.empty()) {
-            return;
+        for (const auto& [long_addr, update] : predicted_updates) {
+            ESP_LOGD(TAG, "Sniffer: Predicted level %d for %s", update.level.value_or(255), utils::longAddressToString(long_addr).data());
+            updateDeviceState(long_addr, update);
         }
 
-        std::optional<uint8_t> known_level;
-        bool needs_query = false;
-
-        if ((addr_byte & 0x01) == 0) { // DACP
-            known_level = cmd_byte;
-        } else { // Command
-            switch (cmd_byte)
-            {
-            case DALI_COMMAND_OFF:
-            case DALI_COMMAND_STEP_DOWN_AND_OFF:
-                known_level = 0;
-                break;
-            case DALI_COMMAND_ON_AND_STEP_UP:
-                {
-                    std::vector<std::pair<DaliLongAddress_t, uint8_t>> optimistic_updates;
-                    bool any_requires_query = false;
-
-                    {
-                        std::lock_guard<std::mutex> lock(m_devices_mutex);
-                        for (const auto& long_addr : affected_devices) {
-                            if (auto it = m_devices.find(long_addr); it != m_devices.end()) {
-                                if (auto* gear = std::get_if<ControlGear>(&it->second)) {
-                                    if (gear->current_level == 0) {
-                                        uint8_t target = (gear->last_level > 0) ? gear->last_level : 254;
-                                        optimistic_updates.emplace_back(long_addr, target);
-                                    } else {
-                                        any_requires_query = true;
-                                    }
-                                }
-                            }
-                        }
-                    }
-
-                    for (const auto& [addr, lvl] : optimistic_updates) {
-                        ESP_LOGD(TAG, "Sniffer: Optimistic ON_AND_STEP_UP for %s to level %d",
-                                 utils::longAddressToString(addr).data(), lvl);
-                        updateDeviceState(addr, {.level = lvl});
-                    }
-
-                    if (any_requires_query) {
-                        needs_query = true;
-                    }
-                    break;
-                }
-                case DALI_COMMAND_RECALL_MAX_LEVEL:
-                    {
-                        std::lock_guard<std::mutex> lock(m_devices_mutex);
-                        if (affected_devices.size() == 1) {
-                            if (auto* gear = std::get_if<ControlGear>(&m_devices[affected_devices[0]])) {
-                                known_level = gear->max_level;
-                            }
-                        } else {
-                            known_level = 254; // FIXME
-                        }
-                    }
-                    break;
-                case DALI_COMMAND_RECALL_MIN_LEVEL:
-                {
-                    std::lock_guard<std::mutex> lock(m_devices_mutex);
-                    if (affected_devices.size() == 1) {
-                        if (auto* gear = std::get_if<ControlGear>(&m_devices[affected_devices[0]])) {
-                            known_level = gear->min_level;
-                        }
-                    } else {
-                        known_level = 1; // FIXME
-                    }
-                }
-                    break;
-                // Should be recalled
-                case DALI_COMMAND_UP:
-                case DALI_COMMAND_DOWN:
-                case DALI_COMMAND_STEP_UP:
-                case DALI_COMMAND_STEP_DOWN:
-                case DALI_COMMAND_GO_TO_SCENE_0:
-                case DALI_COMMAND_GO_TO_SCENE_1:
-                case DALI_COMMAND_GO_TO_SCENE_2:
-                case DALI_COMMAND_GO_TO_SCENE_3:
-                case DALI_COMMAND_GO_TO_SCENE_4:
-                case DALI_COMMAND_GO_TO_SCENE_5:
-                case DALI_COMMAND_GO_TO_SCENE_6:
-                case DALI_COMMAND_GO_TO_SCENE_7:
-                case DALI_COMMAND_GO_TO_SCENE_8:
-                case DALI_COMMAND_GO_TO_SCENE_9:
-                case DALI_COMMAND_GO_TO_SCENE_10:
-                case DALI_COMMAND_GO_TO_SCENE_11:
-                case DALI_COMMAND_GO_TO_SCENE_12:
-                case DALI_COMMAND_GO_TO_SCENE_13:
-                case DALI_COMMAND_GO_TO_SCENE_14:
-                case DALI_COMMAND_GO_TO_SCENE_15:
-                    needs_query = true;
-                    break;
-                default:
-                    return;
-            }
+        for (const auto& long_addr : attributes_changed) {
+            publishAttributes(long_addr);
         }
 
-        if (known_level.has_value()) {
-            ESP_LOGD(TAG, "Sniffer: Applying known level %d to %zu devices.", *known_level, affected_devices.size());
-            for (const auto& long_addr : affected_devices) {
-                updateDeviceState(long_addr, {.level = *known_level});
-            }
-        } else if (needs_query) {
-            uint32_t current_delay_ms = 400;
+        if (!confirm_devices.empty()) {
             constexpr uint32_t stagger_step_ms = 150;
+            uint32_t stagger_ms = 0;
 
-            // if (is_group_or_broadcast) {
-            //     current_delay_ms = 600;
-            // }
+            ESP_LOGD(TAG, "Sniffer: Scheduling confirmation for %zu devices", confirm_devices.size());
 
-            ESP_LOGD(TAG, "Sniffer: Scheduling sync for %zu devices (Base delay: %u ms)", affected_devices.size(), current_delay_ms);
-
-            for (const auto& long_addr : affected_devices) {
+            for (const auto& [long_addr, confirm_after_ms] : confirm_devices) {
                 auto short_addr_opt = getShortAddress(long_addr);
 
                 if (short_addr_opt.has_value()) {
-                    requestDeviceSync(short_addr_opt.value(), current_delay_ms);
-                    current_delay_ms += stagger_step_ms;
+                    requestDeviceSync(short_addr_opt.value(), confirm_after_ms + stagger_ms);
+                    stagger_ms += stagger_step_ms;
                 }
             }
         }
     }
+
+    GearModelInput DaliDeviceController::makeGearModelInput(const ControlGear& gear) {
+        return GearModelInput{
+            .current_level = gear.current_level,
+            .last_level = gear.last_level,
+            .min_level = gear.min_level,
+            .max_level = gear.max_level,
+            .fade_time = gear.fade_time,
+            .fade_rate = gear.fade_rate,
+            .extended_fade_time = gear.extended_fade_time,
+            .scene_levels = gear.scene_levels,
+        };
+    }
+
+    bool DaliDeviceController::applySniffedConfigCommand(ControlGear& gear, const uint8_t cmd_byte,
+                                                         std::optional<uint8_t>& clamped_level) {
+        bool changed = false;
+        if (cmd_byte >= DALI_COMMAND_STORE_DTR_AS_SCENE_0 && cmd_byte <= DALI_COMMAND_REMOVE_FROM_SCENE_15) {
+            if (!gear.scene_levels.has_value()) return false;
+            const uint8_t scene = cmd_byte & 0x0F;
+            const bool removed = cmd_byte >= DALI_COMMAND_REMOVE_FROM_SCENE_0;
+            if (removed) {
+                (*gear.scene_levels)[scene] = 255;
+            } else if (m_sniffed_dtr0) {
+                (*gear.scene_levels)[scene] = *m_sniffed_dtr0;
+            } else {
+                // Value unknown, drop the table so it gets read again
+                gear.scene_levels.reset();
+                m_scene_checked.reset(gear.short_address);
+            }
+            if (gear.color.has_value()) {
+                // A stored scene takes the temporary colour, which we do not follow
+                gear.color->scene_colors[scene] = DaliSceneColor{.known = removed};
+            }
+            m_nvs_dirty = true;
+            m_last_nvs_change_ts = esp_timer_get_time() / 1000;
+            return false; // Scene tables are not part of the published attributes
+        }
+        switch (cmd_byte) {
+            case DALI_COMMAND_RESET:
+                gear.fade_time = 0;
+                gear.fade_rate = 7;
+                gear.extended_fade_time = 0;
+                gear.max_level = 254;
+                gear.power_on_level = 254;
+                gear.system_failure_level = 254;
+                gear.static_data_loaded = false; // re-read physical min level and device data
+                if (gear.scene_levels.has_value()) gear.scene_levels->fill(255);
+                if (gear.color.has_value()) gear.color->scene_colors.fill(DaliSceneColor{.known = true});
+                changed = true;
+                break;
+            case DALI_COMMAND_STORE_DTR_AS_MAX_LEVEL:
+                if (!m_sniffed_dtr0) break;
+                gear.max_level = std::max(*m_sniffed_dtr0, gear.min_level);
+                if (gear.current_level > gear.max_level) clamped_level = gear.max_level;
+                changed = true;
+                break;
+            case DALI_COMMAND_STORE_DTR_AS_MIN_LEVEL:
+                if (!m_sniffed_dtr0) break;
+                gear.min_level = std::min(*m_sniffed_dtr0, gear.max_level);
+                if (gear.current_level > 0 && gear.current_level < gear.min_level) clamped_level = gear.min_level;
+                changed = true;
+                break;
+            case DALI_COMMAND_STORE_DTR_AS_SYSTEM_FAILURE_LEVEL:
+                if (!m_sniffed_dtr0) break;
+                gear.system_failure_level = *m_sniffed_dtr0;
+                changed = true;
+                break;
+            case DALI_COMMAND_STORE_DTR_AS_POWER_ON_LEVEL:
+                if (!m_sniffed_dtr0) break;
+                gear.power_on_level = *m_sniffed_dtr0;
+                changed = true;
+                break;
+            case DALI_COMMAND_STORE_DTR_AS_FADE_TIME:
+                if (!m_sniffed_dtr0) break;
+                gear.fade_time = std::min<uint8_t>(*m_sniffed_dtr0, 15);
+                changed = true;
+                break;
+            case DALI_COMMAND_STORE_DTR_AS_FADE_RATE:
+                if (!m_sniffed_dtr0) break;
+                gear.fade_rate = std::clamp<uint8_t>(*m_sniffed_dtr0, 1, 15);
+                changed = true;
+                break;
+            case DALI_COMMAND_STORE_DTR_AS_EXTENDED_FADE_TIME:
+                if (!m_sniffed_dtr0) break;
+                gear.extended_fade_time = (*m_sniffed_dtr0 > 0x4F) ? 0 : *m_sniffed_dtr0;
+                changed = true;
+                break;
+            default:
+                break;
+        }
+        if (changed) {
+            m_nvs_dirty = true;
+            m_last_nvs_change_ts = esp_timer_get_time() / 1000;
+        }
+        return changed;
+    }
 }
@@ -0,0 +1,220 @@
+#include "dali/DaliStateJournal.hxx"
+#include "utils/NvsHandle.hxx"
+#include <esp_timer.h>
+
+namespace daliMQTT
+{
+    static constexpr char TAG[] = "DaliStateJournal";
+
+    static std::array<char, 8> segmentKey(const uint32_t slot) {
+        std::array<char, 8> key{};
+        snprintf(key.data(), key.size(), "rtJ%lu", static_cast<unsigned long>(slot));
+        return key;
+    }
+
+    RuntimeStateRecord DaliStateJournal::makeRecord(const ControlGear& gear) {
+        RuntimeStateRecord record{};
+        record.long_address = gear.long_address;
+        record.current_level = gear.current_level;
+        record.last_level = gear.last_level;
+        record.status_byte = gear.status_byte;
+        if (gear.color.has_value()) {
+            const auto& c = gear.color.value();
+            if (c.current_tc.has_value()) {
+                record.flags |= FLAG_HAS_TC;
+                record.color_temp = c.current_tc.value();
+            }
+            if (c.current_rgb.has_value()) {
+                record.flags |= FLAG_HAS_RGB;
+                record.r = c.current_rgb->r;
+                record.g = c.current_rgb->g;
+                record.b = c.current_rgb->b;
+            }
+            if (c.active_mode == DaliColorMode::Rgb) {
+                record.flags |= FLAG_MODE_RGB;
+            }
+        }
+        return record;
+    }
+
+    bool DaliStateJournal::sameState(const RuntimeStateRecord& a, const RuntimeStateRecord& b) {
+        return a.current_level == b.current_level &&
+               a.last_level == b.last_level &&
+               a.status_byte == b.status_byte &&
+               a.flags == b.flags &&
+               a.color_temp == b.color_temp &&
+               a.r == b.r && a.g == b.g && a.b == b.b;
+    }
+
+    bool DaliStateJournal::readSegment(const nvs_handle_t handle, const char* key, SegmentHeader& header, std::vector<RuntimeStateRecord>& records) {
+        size_t required_size = 0;
+        esp_err_t err = nvs_get_blob(handle, key, nullptr, &required_size);
+        if (err != ESP_OK || required_size < sizeof(SegmentHeader)) {
+            return false;
+        }
+        if ((required_size - sizeof(SegmentHeader)) % sizeof(RuntimeStateRecord) != 0) {
+            ESP_LOGW(TAG, "Invalid blob size for journal segment %s. Ignoring it.", key);
+            return false;
+        }
+
+        std::vector<uint8_t> buffer(required_size);
+        err = nvs_get_blob(handle, key, buffer.data(), &required_size);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Error reading journal segment %s: %s", key, esp_err_to_name(err));
+            return false;
+        }
+
+        memcpy(&header, buffer.data(), sizeof(SegmentHeader));
+        const size_t stored = (required_size - sizeof(SegmentHeader)) / sizeof(RuntimeStateRecord);
+        if (header.version != JOURNAL_VERSION || header.count != stored) {
+            ESP_LOGW(TAG, "Journal segment %s has unexpected version or size. Ignoring it.", key);
+            return false;
+        }
+
+        records.resize(stored);
+        memcpy(records.data(), buffer.data() + sizeof(SegmentHeader), stored * sizeof(RuntimeStateRecord));
+        return true;
+    }
+
+    esp_err_t DaliStateJournal::writeSegment(const nvs_handle_t handle, const char* key, const uint32_t seq, const std::vector<RuntimeStateRecord>& records) {
+        const SegmentHeader header{ .version = JOURNAL_VERSION, .count = static_cast<uint16_t>(records.size()), .seq = seq };
+        std::vector<uint8_t> buffer(sizeof(SegmentHeader) + records.size() * sizeof(RuntimeStateRecord));
+        memcpy(buffer.data(), &header, sizeof(SegmentHeader));
+        if (!records.empty()) {
+            memcpy(buffer.data() + sizeof(SegmentHeader), records.data(), records.size() * sizeof(RuntimeStateRecord));
+        }
+        return nvs_set_blob(handle, key, buffer.data(), buffer.size());
+    }
+
+    size_t DaliStateJournal::load(std::map<DaliLongAddress_t, DaliDevice>& devices) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_persisted.clear();
+        m_seq = 0;
+        m_base_seq = 0;
+
+        NvsHandle nvs_handle(NVS_NAMESPACE, NVS_READONLY);
+        if (!nvs_handle) {
+            ESP_LOGW(TAG, "Failed to open NVS for reading state journal.");
+            return 0;
+        }
+
+        SegmentHeader header{};
+        std::vector<RuntimeStateRecord> records;
+        if (readSegment(nvs_handle.get(), BASE_KEY, header, records)) {
+            m_base_seq = header.seq;
+            m_seq = header.seq;
+            for (const auto& record : records) {
+                m_persisted[record.long_address] = record;
+            }
+        }
+
+        // Replay delta segments newer than the base, oldest first.
+        std::vector<std::pair<uint32_t, std::vector<RuntimeStateRecord>>> segments;
+        for (uint32_t slot = 0; slot < SEGMENT_COUNT; ++slot) {
+            const auto key = segmentKey(slot);
+            if (readSegment(nvs_handle.get(), key.data(), header, records) && header.seq > m_base_seq) {
+                segments.emplace_back(header.seq, std::move(records));
+            }
+        }
+        std::ranges::sort(segments, {}, &std::pair<uint32_t, std::vector<RuntimeStateRecord>>::first);
+        for (const auto& [seq, segment_records] : segments) {
+            for (const auto& record : segment_records) {
+                m_persisted[record.long_address] = record;
+            }
+            m_seq = std::max(m_seq, seq);
+        }
+
+        if (m_persisted.empty()) {
+            ESP_LOGI(TAG, "No runtime state journal found in NVS.");
+            return 0;
+        }
+
+        const int64_t now_sec = esp_timer_get_time() / 1000000;
+        size_t restored = 0;
+        for (const auto& [long_addr, record] : m_persisted) {
+            const auto it = devices.find(long_addr);
+            if (it == devices.end()) continue;
+            auto* gear = std::get_if<ControlGear>(&it->second);
+            if (!gear) continue;
+
+            gear->current_level = record.current_level;
+            gear->last_level = record.last_level;
+            gear->status_byte = record.status_byte;
+            if (record.flags & (FLAG_HAS_TC | FLAG_HAS_RGB)) {
+                if (!gear->color.has_value()) gear->color = ColorFeatures();
+                auto& c = gear->color.value();
+                if (record.flags & FLAG_HAS_TC) c.current_tc = record.color_temp;
+                if (record.flags & FLAG_HAS_RGB) c.current_rgb = DaliRGB{record.r, record.g, record.b};
+                c.active_mode = (record.flags & FLAG_MODE_RGB) ? DaliColorMode::Rgb : DaliColorMode::Tc;
+                // Colour was restored, so the first confirmation poll only needs the level.
+                c.last_poll_ts = now_sec;
+            }
+            gear->state_restored = true;
+            ++restored;
+        }
+
+        ESP_LOGI(TAG, "Restored runtime state for %zu devices (journal seq %lu, %zu segments replayed).",
+                 restored, static_cast<unsigned long>(m_seq), segments.size());
+        return restored;
+    }
+
+    esp_err_t DaliStateJournal::commit(const std::vector<RuntimeStateRecord>& changed, const std::vector<RuntimeStateRecord>& all) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        std::vector<RuntimeStateRecord> delta;
+        delta.reserve(changed.size());
+        for (const auto& record : changed) {
+            const auto it = m_persisted.find(record.long_address);
+            if (it == m_persisted.end() || !sameState(it->second, record)) {
+                delta.push_back(record);
+            }
+        }
+        if (delta.empty()) {
+            ESP_LOGD(TAG, "State unchanged since last journal write, nothing to persist.");
+            return ESP_OK;
+        }
+
+        NvsHandle nvs_handle(NVS_NAMESPACE, NVS_READWRITE);
+        if (!nvs_handle) {
+            ESP_LOGE(TAG, "Failed to open NVS for writing state journal.");
+            return ESP_FAIL;
+        }
+
+        const uint32_t next_seq = m_seq + 1;
+        const bool compact = (next_seq - m_base_seq) > SEGMENT_COUNT;
+        esp_err_t err;
+        if (compact) {
+            err = writeSegment(nvs_handle.get(), BASE_KEY, next_seq, all);
+        } else {
+            const auto key = segmentKey(next_seq % SEGMENT_COUNT);
+            err = writeSegment(nvs_handle.get(), key.data(), next_seq, delta);
+        }
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to write state journal: %s", esp_err_to_name(err));
+            return err;
+        }
+
+        err = nvs_commit(nvs_handle.get());
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to commit NVS after writing state journal: %s", esp_err_to_name(err));
+            return err;
+        }
+
+        m_seq = next_seq;
+        if (compact) {
+            m_base_seq = next_seq;
+            m_persisted.clear();
+            for (const auto& record : all) {
+                m_persisted[record.long_address] = record;
+            }
+            ESP_LOGI(TAG, "Compacted state journal into base snapshot (%zu devices).", all.size());
+        } else {
+            for (const auto& record : delta) {
+                m_persisted[record.long_address] = record;
+            }
+            ESP_LOGD(TAG, "Appended %zu records to state journal (seq %lu).", delta.size(), static_cast<unsigned long>(next_seq));
+        }
+        return ESP_OK;
+    }
+
+} // namespace daliMQTT
@@ -0,0 +1,83 @@
+#ifndef DALIMQTT_DALISTATEJOURNAL_HXX
+#define DALIMQTT_DALISTATEJOURNAL_HXX
+
+#include "dali/DaliСommon.hxx"
+
+namespace daliMQTT {
+    struct RuntimeStateRecord {
+            DaliLongAddress_t long_address;
+            uint8_t current_level;
+            uint8_t last_level;
+            uint8_t status_byte;
+            uint8_t flags;
+            uint16_t color_temp;
+            uint8_t r;
+            uint8_t g;
+            uint8_t b;
+            uint8_t _padding;
+            uint32_t _reserved;
+    };
+    static_assert(sizeof(RuntimeStateRecord) == 20, "RuntimeStateRecord layout is persisted in NVS");
+
+    /**
+     * @brief Append-only journal of the runtime state of control gear (levels, status, colour).
+     *
+     * Changes are written as small delta segments into a fixed ring of NVS keys. When the ring
+     * is exhausted the whole state is compacted into a single base blob. Records identical to the
+     * last persisted ones are never written, so idle lights cost no flash writes at all.
+     */
+    class DaliStateJournal {
+        public:
+            DaliStateJournal(const DaliStateJournal&) = delete;
+            DaliStateJournal& operator=(const DaliStateJournal&) = delete;
+
+            static DaliStateJournal& Instance() {
+                static DaliStateJournal instance;
+                return instance;
+            }
+
+            /**
+             * @brief Replays the journal and seeds the runtime state of known control gear.
+             * @return Number of devices that received a restored state.
+             */
+            size_t load(std::map<DaliLongAddress_t, DaliDevice>& devices);
+
+            /**
+             * @brief Appends changed records to the journal, compacting it when required.
+             * @param changed Records of devices whose state changed since the last commit.
+             * @param all Records of all current devices, used when the journal is compacted.
+             */
+            esp_err_t commit(const std::vector<RuntimeStateRecord>& changed, const std::vector<RuntimeStateRecord>& all);
+
+            /** Builds a journal record from the cached device state. */
+            static RuntimeStateRecord makeRecord(const ControlGear& gear);
+
+        private:
+            DaliStateJournal() = default;
+
+            struct SegmentHeader {
+                    uint16_t version;
+                    uint16_t count;
+                    uint32_t seq;
+            };
+
+            static constexpr uint16_t JOURNAL_VERSION = 1;
+            static constexpr uint32_t SEGMENT_COUNT = 8;
+            static constexpr uint8_t FLAG_HAS_TC = 0x01;
+            static constexpr uint8_t FLAG_HAS_RGB = 0x02;
+            static constexpr uint8_t FLAG_MODE_RGB = 0x04;
+            static constexpr char NVS_NAMESPACE[] = "dali_state";
+            static constexpr char BASE_KEY[] = "rtBase";
+
+            static bool sameState(const RuntimeStateRecord& a, const RuntimeStateRecord& b);
+            static bool readSegment(nvs_handle_t handle, const char* key, SegmentHeader& header, std::vector<RuntimeStateRecord>& records);
+            static esp_err_t writeSegment(nvs_handle_t handle, const char* key, uint32_t seq, const std::vector<RuntimeStateRecord>& records);
+
+            std::map<DaliLongAddress_t, RuntimeStateRecord> m_persisted{};
+            uint32_t m_seq{0};
+            uint32_t m_base_seq{0};
+            mutable std::mutex m_mutex{};
+    };
+}
+
+#endif //DALIMQTT_DALISTATEJOURNAL_HXX
@@ -56,6 +56,12 @@ namespace daliMQTT
         uint8_t short_address;
         int64_t execute_at_ts; // Timestamp (ms)
     };
+    struct FadeTransition {
+        uint8_t start_level;
+        uint8_t target_level;
+        int64_t start_ts;      // Timestamp (ms)
+        int64_t end_ts;        // Timestamp (ms)
+    };
 } // daliMQTT
 
 #endif //DALIMQTT_DALICOMMON_HXX
\ No newline at end of file
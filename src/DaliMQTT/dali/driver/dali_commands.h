@@ -13,6 +13,7 @@
 #define DALI_COMMAND_STEP_DOWN_AND_OFF                    0x07 // dec. 7
 #define DALI_COMMAND_ON_AND_STEP_UP                       0x08 // dec. 8
 #define DALI_COMMAND_ENABLE_DAPC_SEQ                      0x09 // dec. 9
+#define DALI_COMMAND_GO_TO_LAST_ACTIVE_LEVEL              0x0A // dec. 10 (DALI-2)
 // reserved
 #define DALI_COMMAND_GO_TO_SCENE_0                        0x10 // dec. 16
 #define DALI_COMMAND_GO_TO_SCENE_1                        0x11 // dec. 17
@@ -39,6 +40,7 @@
 #define DALI_COMMAND_STORE_DTR_AS_POWER_ON_LEVEL          0x2D // dec. 45
 #define DALI_COMMAND_STORE_DTR_AS_FADE_TIME               0x2E // dec. 46
 #define DALI_COMMAND_STORE_DTR_AS_FADE_RATE               0x2F // dec. 47
+#define DALI_COMMAND_STORE_DTR_AS_EXTENDED_FADE_TIME      0x30 // dec. 48 (DALI-2)
 // reserved
 #define DALI_COMMAND_STORE_DTR_AS_SCENE_0                 0x40 // dec. 64
 #define DALI_COMMAND_STORE_DTR_AS_SCENE_1                 0x41 // dec. 65
@@ -128,6 +130,7 @@
 #define DALI_COMMAND_QUERY_POWER_ON_LEVEL                 0xA3 // dec. 163
 #define DALI_COMMAND_QUERY_SYSTEM_FAILURE_LEVEL           0xA4 // dec. 164
 #define DALI_COMMAND_QUERY_FADE_TIME_FADE_RATE            0xA5 // dec. 165
+#define DALI_COMMAND_QUERY_EXTENDED_FADE_TIME             0xA8 // dec. 168 (DALI-2)
 // reserved
 #define DALI_COMMAND_QUERY_SCENE_LEVEL_0                  0xB0 // dec. 176
 #define DALI_COMMAND_QUERY_SCENE_LEVEL_1                  0xB1 // dec. 177
@@ -160,6 +163,7 @@
 #define DALI_COMMAND_DT8_QUERY_COLOUR_STATUS                  0xF7 // 247
 #define DALI_COMMAND_DT8_QUERY_COLOUR_TYPE_FEATURES           0xF8 // 248
 #define DALI_COMMAND_DT8_QUERY_COLOUR_VALUE                   0xF9 // 249
+#define DALI_DT8_REPORT_COLOUR_SELECTOR_OFFSET                0xC0 // QUERY COLOUR VALUE selectors for the report colour
 
 #define DALI_SPECIAL_COMMAND_TERMINATE                    0xA1 // bin. 1010 0001 0000 0000
 #define DALI_SPECIAL_COMMAND_DATA_TRANSFER_REGISTER       0xA3 // bin. 1010 0011 XXXX XXXX
@@ -0,0 +1,20 @@
+#ifndef DALIMQTT_HASH_HXX
+#define DALIMQTT_HASH_HXX
+
+namespace daliMQTT::utils {
+    inline constexpr uint32_t FNV1A_SEED = 2166136261u;
+
+    /**
+     * @brief 32-bit FNV-1a. Cheap change detection for payloads and topics, not collision resistant.
+     * @param seed Pass a previous result to hash several fields as one.
+     */
+    constexpr uint32_t fnv1a(const std::string_view data, uint32_t seed = FNV1A_SEED) {
+        for (const char ch : data) {
+            seed ^= static_cast<uint8_t>(ch);
+            seed *= 16777619u;
+        }
+        return seed;
+    }
+}
+
+#endif //DALIMQTT_HASH_HXX
@@ -0,0 +1,185 @@
+#ifndef DALIMQTT_JSONREADER_HXX
+#define DALIMQTT_JSONREADER_HXX
+
+namespace daliMQTT::utils {
+    /**
+     * @brief Minimal JSON object reader over a caller-owned buffer.
+     *
+     * Never allocates and does not need a null-terminated input. Walks the members of one
+     * object; nested objects and arrays are returned as raw views that can be read with
+     * another JsonReader. String values are returned without quotes, escapes are not decoded.
+     */
+    class JsonReader {
+    public:
+        enum class Type : uint8_t {
+            String,
+            Number,
+            Bool,
+            Null,
+            Object,
+            Array
+        };
+
+        struct Value {
+            Type type{Type::Null};
+            std::string_view raw;
+
+            /** Integer value; fractions are truncated like cJSON's valueint. */
+            template<typename T> requires std::is_integral_v<T>
+            [[nodiscard]] std::optional<T> asInt() const {
+                if (type != Type::Number) return std::nullopt;
+                int64_t value = 0;
+                const auto [ptr, ec] = std::from_chars(raw.data(), raw.data() + raw.size(), value);
+                if (ec != std::errc()) return std::nullopt;
+                if (value < std::numeric_limits<T>::min() || value > std::numeric_limits<T>::max()) return std::nullopt;
+                return static_cast<T>(value);
+            }
+
+            [[nodiscard]] std::optional<float> asFloat() const {
+                if (type != Type::Number) return std::nullopt;
+                float value = 0;
+                const auto [ptr, ec] = std::from_chars(raw.data(), raw.data() + raw.size(), value);
+                if (ec != std::errc()) return std::nullopt;
+                return value;
+            }
+
+            [[nodiscard]] bool isString(const std::string_view expected) const {
+                return type == Type::String && raw == expected;
+            }
+            [[nodiscard]] bool isTrue() const { return type == Type::Bool && raw == "true"; }
+        };
+
+        explicit JsonReader(const std::string_view json) : m_json(json) {
+            skipWhitespace();
+            if (!consume('{')) m_error = true;
+        }
+
+        /**
+         * @brief Advances to the next member.
+         * @return false at the end of the object or on malformed input (see ok()).
+         */
+        bool next(std::string_view& key, Value& value) {
+            if (m_error || m_done) return false;
+            skipWhitespace();
+            if (consume('}')) {
+                m_done = true;
+                return false;
+            }
+            if (m_members > 0 && !consume(',')) return fail();
+            skipWhitespace();
+
+            Value key_value;
+            if (!readString(key_value)) return fail();
+            skipWhitespace();
+            if (!consume(':')) return fail();
+            skipWhitespace();
+            if (!readValue(value)) return fail();
+
+            key = key_value.raw;
+            ++m_members;
+            return true;
+        }
+
+        [[nodiscard]] bool ok() const { return !m_error; }
+
+    private:
+        static constexpr uint8_t MAX_DEPTH = 8;
+
+        bool fail() {
+            m_error = true;
+            return false;
+        }
+
+        void skipWhitespace() {
+            while (m_pos < m_json.size() && (m_json[m_pos] == ' ' || m_json[m_pos] == '\t' ||
+                                             m_json[m_pos] == '\n' || m_json[m_pos] == '\r')) {
+                ++m_pos;
+            }
+        }
+
+        bool consume(const char expected) {
+            if (m_pos < m_json.size() && m_json[m_pos] == expected) {
+                ++m_pos;
+                return true;
+            }
+            return false;
+        }
+
+        bool readString(Value& value) {
+            if (!consume('"')) return false;
+            const size_t start = m_pos;
+            while (m_pos < m_json.size() && m_json[m_pos] != '"') {
+                if (m_json[m_pos] == '\\') ++m_pos;
+                ++m_pos;
+            }
+            if (m_pos >= m_json.size()) return false;
+            value = {Type::String, m_json.substr(start, m_pos - start)};
+            ++m_pos;
+            return true;
+        }
+
+        bool readLiteral(const std::string_view literal, const Type type, Value& value) {
+            if (m_json.substr(m_pos, literal.size()) != literal) return false;
+            value = {type, m_json.substr(m_pos, literal.size())};
+            m_pos += literal.size();
+            return true;
+        }
+
+        bool readContainer(Value& value) {
+            const size_t start = m_pos;
+            std::array<char, MAX_DEPTH> closers{};
+            uint8_t depth = 0;
+            while (m_pos < m_json.size()) {
+                const char ch = m_json[m_pos];
+                if (ch == '"') {
+                    Value ignored;
+                    if (!readString(ignored)) return false;
+                    continue;
+                }
+                ++m_pos;
+                if (ch == '{' || ch == '[') {
+                    if (depth >= MAX_DEPTH) return false;
+                    closers[depth++] = ch == '{' ? '}' : ']';
+                } else if (ch == '}' || ch == ']') {
+                    if (depth == 0 || closers[depth - 1] != ch) return false;
+                    if (--depth == 0) {
+                        value = {m_json[start] == '{' ? Type::Object : Type::Array, m_json.substr(start, m_pos - start)};
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+
+        static bool isNumberChar(const char ch) {
+            return (ch >= '0' && ch <= '9') || ch == '-' || ch == '+' || ch == '.' || ch == 'e' || ch == 'E';
+        }
+
+        bool readValue(Value& value) {
+            if (m_pos >= m_json.size()) return false;
+            switch (const char ch = m_json[m_pos]) {
+                case '"': return readString(value);
+                case '{':
+                case '[': return readContainer(value);
+                case 't': return readLiteral("true", Type::Bool, value);
+                case 'f': return readLiteral("false", Type::Bool, value);
+                case 'n': return readLiteral("null", Type::Null, value);
+                default: {
+                    if (ch != '-' && (ch < '0' || ch > '9')) return false;
+                    const size_t start = m_pos;
+                    while (m_pos < m_json.size() && isNumberChar(m_json[m_pos])) ++m_pos;
+                    value = {Type::Number, m_json.substr(start, m_pos - start)};
+                    return true;
+                }
+            }
+        }
+
+        std::string_view m_json;
+        size_t m_pos{0};
+        size_t m_members{0};
+        bool m_error{false};
+        bool m_done{false};
+    };
+}
+
+#endif //DALIMQTT_JSONREADER_HXX
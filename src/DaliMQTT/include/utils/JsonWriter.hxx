@@ -0,0 +1,182 @@
+#ifndef DALIMQTT_JSONWRITER_HXX
+#define DALIMQTT_JSONWRITER_HXX
+
+namespace daliMQTT::utils {
+    /**
+     * @brief Minimal JSON writer over a caller-owned buffer.
+     *
+     * Never allocates. Output is always null-terminated; if the buffer is too small
+     * the writer stops appending and ok() returns false.
+     */
+    class JsonWriter {
+    public:
+        JsonWriter(char* buffer, const size_t capacity) : m_buf(buffer), m_cap(capacity) {
+            if (m_cap > 0) m_buf[0] = '\0';
+        }
+
+        JsonWriter& beginObject() {
+            separator();
+            put('{');
+            push();
+            return *this;
+        }
+
+        JsonWriter& beginObject(const std::string_view key) {
+            writeKey(key);
+            put('{');
+            push();
+            return *this;
+        }
+
+        JsonWriter& endObject() {
+            put('}');
+            pop();
+            return *this;
+        }
+
+        /** Nested array element. */
+        JsonWriter& beginArray() {
+            separator();
+            put('[');
+            push();
+            return *this;
+        }
+
+        JsonWriter& beginArray(const std::string_view key) {
+            writeKey(key);
+            put('[');
+            push();
+            return *this;
+        }
+
+        JsonWriter& endArray() {
+            put(']');
+            pop();
+            return *this;
+        }
+
+        JsonWriter& add(const std::string_view key, const std::string_view value) {
+            writeKey(key);
+            writeString(value);
+            return *this;
+        }
+
+        JsonWriter& add(const std::string_view key, const char* value) {
+            return add(key, std::string_view(value));
+        }
+
+        JsonWriter& add(const std::string_view key, const bool value) {
+            writeKey(key);
+            append(value ? "true" : "false");
+            return *this;
+        }
+
+        template<typename T> requires std::is_integral_v<T> && (!std::is_same_v<T, bool>)
+        JsonWriter& add(const std::string_view key, const T value) {
+            writeKey(key);
+            writeNumber(static_cast<int64_t>(value));
+            return *this;
+        }
+
+        /** Array element. */
+        template<typename T> requires std::is_integral_v<T> && (!std::is_same_v<T, bool>)
+        JsonWriter& element(const T value) {
+            separator();
+            writeNumber(static_cast<int64_t>(value));
+            return *this;
+        }
+
+        [[nodiscard]] bool ok() const { return !m_overflow && m_depth == 0; }
+        [[nodiscard]] std::string_view view() const { return {m_buf, m_len}; }
+        [[nodiscard]] const char* c_str() const { return m_buf; }
+
+    private:
+        static constexpr uint8_t MAX_DEPTH = 16;
+
+        void push() {
+            if (m_depth >= MAX_DEPTH) { m_overflow = true; return; }
+            m_first[m_depth++] = true;
+        }
+
+        void pop() {
+            if (m_depth > 0) --m_depth;
+        }
+
+        void separator() {
+            if (m_depth == 0) return;
+            if (!m_first[m_depth - 1]) put(',');
+            m_first[m_depth - 1] = false;
+        }
+
+        void writeKey(const std::string_view key) {
+            separator();
+            writeString(key);
+            put(':');
+        }
+
+        void writeString(const std::string_view value) {
+            put('"');
+            for (const char ch : value) {
+                switch (ch) {
+                    case '"':  append("\\\""); break;
+                    case '\\': append("\\\\"); break;
+                    case '\n': append("\\n"); break;
+                    case '\r': append("\\r"); break;
+                    case '\t': append("\\t"); break;
+                    default:
+                        if (static_cast<unsigned char>(ch) < 0x20) {
+                            static constexpr char HEX[] = "0123456789abcdef";
+                            const char esc[] = {'\\', 'u', '0', '0', HEX[(ch >> 4) & 0x0F], HEX[ch & 0x0F]};
+                            append(std::string_view(esc, sizeof(esc)));
+                        } else {
+                            put(ch);
+                        }
+                }
+            }
+            put('"');
+        }
+
+        void writeNumber(const int64_t value) {
+            char tmp[24];
+            const auto [ptr, ec] = std::to_chars(tmp, tmp + sizeof(tmp), value);
+            append(std::string_view(tmp, ptr - tmp));
+        }
+
+        void append(const std::string_view s) {
+            for (const char ch : s) put(ch);
+        }
+
+        void put(const char ch) {
+            if (m_overflow || m_len + 1 >= m_cap) {
+                m_overflow = true;
+                return;
+            }
+            m_buf[m_len++] = ch;
+            m_buf[m_len] = '\0';
+        }
+
+        char* m_buf;
+        size_t m_cap;
+        size_t m_len{0};
+        bool m_overflow{false};
+        uint8_t m_depth{0};
+        std::array<bool, MAX_DEPTH> m_first{};
+    };
+
+    template<size_t N>
+    struct JsonWriterStorage {
+        std::array<char, N> m_storage;
+    };
+
+    /** JsonWriter with an inline buffer of N bytes, meant to live on the stack. */
+    template<size_t N>
+    class StaticJsonWriter : private JsonWriterStorage<N>, public JsonWriter {
+    public:
+        // Storage base is constructed first, JsonWriter only writes the terminator into it
+        StaticJsonWriter() : JsonWriter(this->m_storage.data(), N) {}
+        StaticJsonWriter(const StaticJsonWriter&) = delete;
+        StaticJsonWriter& operator=(const StaticJsonWriter&) = delete;
+    };
+}
+
+#endif //DALIMQTT_JSONWRITER_HXX
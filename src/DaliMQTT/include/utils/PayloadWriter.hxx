@@ -0,0 +1,233 @@
+#ifndef DALIMQTT_PAYLOADWRITER_HXX
+#define DALIMQTT_PAYLOADWRITER_HXX
+
+#include "utils/JsonWriter.hxx"
+
+namespace daliMQTT::utils {
+    enum class PayloadFormat : uint8_t {
+        Json,
+        Cbor,
+        MsgPack
+    };
+
+    /**
+     * @brief Serializer with the JsonWriter interface that can also emit CBOR (RFC 8949) or MessagePack.
+     *
+     * Never allocates. Binary containers are written with a one-byte header that is
+     * widened in place if a container ends up with more entries than it can encode.
+     * Binary output is not null-terminated; use view().
+     */
+    class PayloadWriter {
+    public:
+        PayloadWriter(char* buffer, const size_t capacity, const PayloadFormat format)
+            : m_format(format), m_json(buffer, capacity), m_buf(reinterpret_cast<uint8_t*>(buffer)), m_cap(capacity) {}
+
+        PayloadWriter& beginObject() {
+            if (isJson()) { m_json.beginObject(); return *this; }
+            countElement();
+            openContainer(true);
+            return *this;
+        }
+
+        PayloadWriter& beginObject(const std::string_view key) {
+            if (isJson()) { m_json.beginObject(key); return *this; }
+            writeKey(key);
+            openContainer(true);
+            return *this;
+        }
+
+        PayloadWriter& endObject() {
+            if (isJson()) { m_json.endObject(); return *this; }
+            closeContainer();
+            return *this;
+        }
+
+        PayloadWriter& beginArray() {
+            if (isJson()) { m_json.beginArray(); return *this; }
+            countElement();
+            openContainer(false);
+            return *this;
+        }
+
+        PayloadWriter& beginArray(const std::string_view key) {
+            if (isJson()) { m_json.beginArray(key); return *this; }
+            writeKey(key);
+            openContainer(false);
+            return *this;
+        }
+
+        PayloadWriter& endArray() {
+            if (isJson()) { m_json.endArray(); return *this; }
+            closeContainer();
+            return *this;
+        }
+
+        PayloadWriter& add(const std::string_view key, const std::string_view value) {
+            if (isJson()) { m_json.add(key, value); return *this; }
+            writeKey(key);
+            writeString(value);
+            return *this;
+        }
+
+        PayloadWriter& add(const std::string_view key, const char* value) {
+            return add(key, std::string_view(value));
+        }
+
+        PayloadWriter& add(const std::string_view key, const bool value) {
+            if (isJson()) { m_json.add(key, value); return *this; }
+            writeKey(key);
+            if (m_format == PayloadFormat::Cbor) put(value ? 0xF5 : 0xF4);
+            else put(value ? 0xC3 : 0xC2);
+            return *this;
+        }
+
+        template<typename T> requires std::is_integral_v<T> && (!std::is_same_v<T, bool>)
+        PayloadWriter& add(const std::string_view key, const T value) {
+            if (isJson()) { m_json.add(key, value); return *this; }
+            writeKey(key);
+            writeInt(static_cast<int64_t>(value));
+            return *this;
+        }
+
+        /** Array element. */
+        template<typename T> requires std::is_integral_v<T> && (!std::is_same_v<T, bool>)
+        PayloadWriter& element(const T value) {
+            if (isJson()) { m_json.element(value); return *this; }
+            countElement();
+            writeInt(static_cast<int64_t>(value));
+            return *this;
+        }
+
+        [[nodiscard]] bool ok() const {
+            return isJson() ? m_json.ok() : (!m_overflow && m_depth == 0);
+        }
+        [[nodiscard]] std::string_view view() const {
+            return isJson() ? m_json.view() : std::string_view(reinterpret_cast<const char*>(m_buf), m_len);
+        }
+        [[nodiscard]] PayloadFormat format() const { return m_format; }
+        [[nodiscard]] bool isJson() const { return m_format == PayloadFormat::Json; }
+
+    private:
+        static constexpr uint8_t MAX_DEPTH = 16;
+
+        struct Container {
+            size_t header_pos;
+            uint16_t count;
+            bool is_map;
+        };
+
+        void countElement() {
+            if (m_depth > 0) ++m_stack[m_depth - 1].count;
+        }
+
+        void writeKey(const std::string_view key) {
+            countElement();
+            writeString(key);
+        }
+
+        void openContainer(const bool is_map) {
+            if (m_depth >= MAX_DEPTH) { m_overflow = true; return; }
+            m_stack[m_depth++] = {m_len, 0, is_map};
+            put(0); // Placeholder for the short-form header
+        }
+
+        void closeContainer() {
+            if (m_depth == 0 || m_overflow) return;
+            const auto [pos, count, is_map] = m_stack[--m_depth];
+            const bool cbor = m_format == PayloadFormat::Cbor;
+            const uint8_t short_limit = cbor ? 23 : 15;
+            if (count <= short_limit) {
+                const uint8_t base = cbor ? (is_map ? 0xA0 : 0x80) : (is_map ? 0x80 : 0x90);
+                m_buf[pos] = base | static_cast<uint8_t>(count);
+                return;
+            }
+            // Widen to a 16-bit count: one header byte plus two length bytes
+            if (m_len + 2 > m_cap) { m_overflow = true; return; }
+            std::memmove(m_buf + pos + 3, m_buf + pos + 1, m_len - pos - 1);
+            m_len += 2;
+            m_buf[pos] = cbor ? (is_map ? 0xB9 : 0x99) : (is_map ? 0xDE : 0xDC);
+            m_buf[pos + 1] = static_cast<uint8_t>(count >> 8);
+            m_buf[pos + 2] = static_cast<uint8_t>(count & 0xFF);
+        }
+
+        void writeString(const std::string_view value) {
+            const size_t len = value.size();
+            if (m_format == PayloadFormat::Cbor) {
+                writeCborHead(3, len);
+            } else if (len < 32) {
+                put(0xA0 | static_cast<uint8_t>(len));
+            } else if (len <= 0xFF) {
+                put(0xD9);
+                putBE(len, 1);
+            } else {
+                put(0xDA);
+                putBE(len, 2);
+            }
+            for (const char ch : value) put(static_cast<uint8_t>(ch));
+        }
+
+        void writeInt(const int64_t value) {
+            if (m_format == PayloadFormat::Cbor) {
+                if (value >= 0) writeCborHead(0, static_cast<uint64_t>(value));
+                else writeCborHead(1, static_cast<uint64_t>(-1 - value));
+                return;
+            }
+            if (value >= 0) {
+                if (value <= 0x7F) put(static_cast<uint8_t>(value));
+                else if (value <= 0xFF) { put(0xCC); putBE(value, 1); }
+                else if (value <= 0xFFFF) { put(0xCD); putBE(value, 2); }
+                else if (value <= 0xFFFFFFFF) { put(0xCE); putBE(value, 4); }
+                else { put(0xCF); putBE(value, 8); }
+            } else {
+                if (value >= -32) put(static_cast<uint8_t>(value));
+                else if (value >= INT8_MIN) { put(0xD0); putBE(value, 1); }
+                else if (value >= INT16_MIN) { put(0xD1); putBE(value, 2); }
+                else if (value >= INT32_MIN) { put(0xD2); putBE(value, 4); }
+                else { put(0xD3); putBE(value, 8); }
+            }
+        }
+
+        void writeCborHead(const uint8_t major, const uint64_t arg) {
+            const uint8_t mt = static_cast<uint8_t>(major << 5);
+            if (arg < 24) put(mt | static_cast<uint8_t>(arg));
+            else if (arg <= 0xFF) { put(mt | 24); putBE(arg, 1); }
+            else if (arg <= 0xFFFF) { put(mt | 25); putBE(arg, 2); }
+            else if (arg <= 0xFFFFFFFF) { put(mt | 26); putBE(arg, 4); }
+            else { put(mt | 27); putBE(arg, 8); }
+        }
+
+        void putBE(const uint64_t value, const uint8_t bytes) {
+            for (int i = bytes - 1; i >= 0; --i) {
+                put(static_cast<uint8_t>((value >> (i * 8)) & 0xFF));
+            }
+        }
+
+        void put(const uint8_t byte) {
+            if (m_overflow || m_len >= m_cap) {
+                m_overflow = true;
+                return;
+            }
+            m_buf[m_len++] = byte;
+        }
+
+        PayloadFormat m_format;
+        JsonWriter m_json;
+        uint8_t* m_buf;
+        size_t m_cap;
+        size_t m_len{0};
+        bool m_overflow{false};
+        uint8_t m_depth{0};
+        std::array<Container, MAX_DEPTH> m_stack{};
+    };
+
+    /** PayloadWriter with an inline buffer of N bytes, meant to live on the stack. */
+    template<size_t N>
+    class StaticPayloadWriter : private JsonWriterStorage<N>, public PayloadWriter {
+    public:
+        explicit StaticPayloadWriter(const PayloadFormat format) : PayloadWriter(this->m_storage.data(), N, format) {}
+        StaticPayloadWriter(const StaticPayloadWriter&) = delete;
+        StaticPayloadWriter& operator=(const StaticPayloadWriter&) = delete;
+    };
+}
+
+#endif //DALIMQTT_PAYLOADWRITER_HXX
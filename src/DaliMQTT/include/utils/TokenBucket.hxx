@@ -0,0 +1,51 @@
+#ifndef DALIMQTT_TOKENBUCKET_HXX
+#define DALIMQTT_TOKENBUCKET_HXX
+
+namespace daliMQTT::utils {
+    /**
+     * @brief Token bucket rate limiter on a millisecond clock supplied by the caller.
+     *
+     * Starts full, so the first `capacity` operations pass immediately and the rest
+     * are paced at `rate_per_s`. Tokens are kept in thousandths to avoid floats.
+     */
+    class TokenBucket {
+    public:
+        TokenBucket(const uint32_t capacity, const uint32_t rate_per_s)
+            : m_capacity_milli(static_cast<int64_t>(capacity) * 1000),
+              m_rate_per_s(std::max<uint32_t>(1, rate_per_s)),
+              m_tokens_milli(m_capacity_milli) {}
+
+        /**
+         * @brief Takes one token if available.
+         * @return 0 if a token was taken, otherwise the milliseconds until one will be available.
+         */
+        uint32_t tryAcquire(const int64_t now_ms) {
+            refill(now_ms);
+            if (m_tokens_milli >= 1000) {
+                m_tokens_milli -= 1000;
+                return 0;
+            }
+            const int64_t missing = 1000 - m_tokens_milli;
+            return static_cast<uint32_t>((missing + m_rate_per_s - 1) / m_rate_per_s);
+        }
+
+    private:
+        void refill(const int64_t now_ms) {
+            if (m_last_ms < 0) {
+                m_last_ms = now_ms;
+                return;
+            }
+            if (now_ms <= m_last_ms) return;
+            // elapsed_ms * rate_per_s / 1000 tokens == elapsed_ms * rate_per_s milli-tokens
+            m_tokens_milli = std::min(m_capacity_milli, m_tokens_milli + (now_ms - m_last_ms) * m_rate_per_s);
+            m_last_ms = now_ms;
+        }
+
+        int64_t m_capacity_milli;
+        int64_t m_rate_per_s;
+        int64_t m_tokens_milli;
+        int64_t m_last_ms{-1};
+    };
+}
+
+#endif //DALIMQTT_TOKENBUCKET_HXX
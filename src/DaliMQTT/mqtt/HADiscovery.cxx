@@ -5,17 +5,83 @@
 #include "dali/DaliDeviceController.hxx"
 #include "utils/DaliLongAddrConversions.hxx"
 #include "utils/StringUtils.hxx"
+#include "utils/NvsHandle.hxx"
+#include "utils/Hash.hxx"
+#include <esp_timer.h>
 
 namespace daliMQTT
 {
-    MQTTHomeAssistantDiscovery::MQTTHomeAssistantDiscovery() {
-        const auto config = ConfigManager::Instance().getConfig();
+    static constexpr char TAG[] = "HADiscovery";
+#ifdef CONFIG_DALI2MQTT_HA_DEVICE_DISCOVERY
+    static constexpr bool DEVICE_DISCOVERY = true;
+#else
+    static constexpr bool DEVICE_DISCOVERY = false;
+#endif
+
+    void MQTTHomeAssistantDiscovery::requestPublish(const bool force) {
+        std::lock_guard<std::mutex> lock(m_request_mutex);
+        m_force_requested = m_force_requested || force;
+        if (m_running) {
+            m_rerun_requested = true;
+            return;
+        }
+        m_running = true;
+        if (xTaskCreate(discoveryTask, "ha_discovery", 6144, this, 3, nullptr) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create discovery task");
+            m_running = false;
+        }
+    }
+
+    void MQTTHomeAssistantDiscovery::discoveryTask(void* arg) {
+        auto* self = static_cast<MQTTHomeAssistantDiscovery*>(arg);
+        while (true) {
+            bool force;
+            {
+                std::lock_guard<std::mutex> lock(self->m_request_mutex);
+                force = self->m_force_requested;
+                self->m_force_requested = false;
+                self->m_rerun_requested = false;
+            }
+            self->publishAllDevices(force);
+            {
+                std::lock_guard<std::mutex> lock(self->m_request_mutex);
+                if (!self->m_rerun_requested) {
+                    self->m_running = false;
+                    break;
+                }
+            }
+        }
+        vTaskDelete(nullptr);
+    }
 
-        base_topic = config.mqtt_base_topic;
+    void MQTTHomeAssistantDiscovery::refreshRunContext() {
+        const auto config = ConfigManager::Instance().getSnapshot();
+
+        base_topic = config->mqtt_base_topic;
+        client_id = config->client_id;
         availability_topic = utils::stringFormat("%s%s", base_topic.c_str(), CONFIG_DALI2MQTT_MQTT_AVAILABILITY_TOPIC);
-        bridge_public_name = utils::stringFormat("DALI-MQTT Bridge (%s)", config.client_id.c_str());
+        bridge_public_name = utils::stringFormat("DALI-MQTT Bridge (%s)", config->client_id.c_str());
+
+        uint32_t context_hash = utils::fnv1a(config->mqtt_uri);
+        context_hash = utils::fnv1a(config->client_id, context_hash);
+        context_hash = utils::fnv1a(config->mqtt_base_topic, context_hash);
+        if (context_hash != m_context_hash) {
+            // Hashes describe what a different broker or topic tree holds
+            if (!m_published_hashes.empty()) {
+                ESP_LOGI(TAG, "Broker or topic settings changed, discarding discovery hashes");
+            }
+            m_published_hashes.clear();
+            m_context_hash = context_hash;
+            m_hashes_dirty = true;
+        }
 
-        cJSON* names_root = cJSON_Parse(config.dali_device_identificators.c_str());
+        // The names JSON only needs parsing when it actually changed
+        const uint32_t names_hash = utils::fnv1a(config->dali_device_identificators);
+        if (names_hash == m_names_hash && !device_identification.empty()) return;
+        m_names_hash = names_hash;
+        device_identification.clear();
+
+        cJSON* names_root = cJSON_Parse(config->dali_device_identificators.c_str());
         if (cJSON_IsObject(names_root)) {
             const cJSON* current_name = nullptr;
             const auto addr_str = utils::longAddressToString(0);
@@ -29,56 +95,174 @@ namespace daliMQTT
         cJSON_Delete(names_root);
     }
 
-    void MQTTHomeAssistantDiscovery::publishAllDevices() {
-        auto devices = DaliDeviceController::Instance().getDevices();
-        for (const auto& [long_addr,dev] : devices) {
-            if (std::holds_alternative<InputDevice>(dev)) continue;
+    void MQTTHomeAssistantDiscovery::publishAllDevices(const bool force) {
+        if (!m_hashes_loaded) {
+            loadHashes();
+            m_hashes_loaded = true;
+        }
+        refreshRunContext();
+
+        // One snapshot for the whole run
+        const auto devices = DaliDeviceController::Instance().getDevices();
+        const auto assignments = DaliGroupManagement::Instance().getAllAssignments();
 
-            publishLight(long_addr);
+        utils::TokenBucket bucket(CONFIG_DALI2MQTT_HA_DISCOVERY_BURST, CONFIG_DALI2MQTT_HA_DISCOVERY_RATE);
+        size_t published = 0;
+        size_t total = 0;
+        bool aborted = false;
+
+        const auto connected = [&aborted]() {
+            if (!aborted && MQTTClient::Instance().getStatus() != MqttStatus::CONNECTED) {
+                aborted = true;
+            }
+            return !aborted;
+        };
+        const auto publish = [&](const std::optional<DiscoveryMessage>& msg) {
+            // An empty retained payload would delete the entity in Home Assistant
+            if (!msg || msg->payload.empty() || !connected()) return;
+            ++total;
+            if (publishIfChanged(*msg, force, bucket)) ++published;
+        };
+
+        std::array<bool, 16> group_tc{};
+        std::array<bool, 16> group_rgb{};
+        std::vector<const ControlGear*> gears;
+        for (const auto& [long_addr, dev] : devices) {
+            const auto* gear = std::get_if<ControlGear>(&dev);
+            if (!gear) continue;
+            gears.push_back(gear);
+
+            const auto groups_it = assignments.find(long_addr);
+            if (groups_it == assignments.end() || !gear->color.has_value()) continue;
+            for (uint8_t group = 0; group < 16; ++group) {
+                if (!groups_it->second.test(group)) continue;
+                group_tc[group] = group_tc[group] || gear->color->supports_tc;
+                group_rgb[group] = group_rgb[group] || gear->color->supports_rgb;
+            }
         }
 
-        for (uint8_t i = 0; i < 16; ++i) {
-            publishGroup(i);
+        // Configs of the other discovery layout that we published before and must hand over
+        std::vector<std::string> retired;
+        const auto retire_if_published = [&](std::string topic) {
+            if (m_published_hashes.contains(utils::fnv1a(topic))) retired.push_back(std::move(topic));
+        };
+        for (const auto* gear : gears) {
+            retire_if_published(DEVICE_DISCOVERY ? lightTopic(gear->long_address) : gearDeviceTopic(gear->long_address));
+        }
+        if (DEVICE_DISCOVERY) {
+            for (uint8_t i = 0; i < 16; ++i) retire_if_published(groupTopic(i));
+            retire_if_published(sceneSelectorTopic());
+        } else {
+            retire_if_published(bridgeDeviceTopic());
         }
 
-        publishSceneSelector();
+        // Home Assistant keeps the entity registry entries of configs marked for migration
+        static constexpr char MIGRATE_PAYLOAD[] = R"({"migrate_discovery":true})";
+        for (const auto& topic : retired) {
+            if (!connected()) break;
+            publishPaced(topic, MIGRATE_PAYLOAD, bucket);
+        }
+
+        if (DEVICE_DISCOVERY) {
+            publish(buildBridgeDevice(group_tc, group_rgb));
+            for (const auto* gear : gears) {
+                publish(buildGearDevice(*gear));
+            }
+        } else {
+            for (const auto* gear : gears) {
+                publish(buildLight(*gear));
+            }
+            for (uint8_t i = 0; i < 16; ++i) {
+                publish(buildGroup(i, group_tc[i], group_rgb[i]));
+            }
+            publish(buildSceneSelector());
+        }
+
+        for (const auto& topic : retired) {
+            if (!connected()) break;
+            // A dropped removal keeps the hash, so the config is retired again on the next run
+            if (!publishPaced(topic, "", bucket)) continue;
+            m_published_hashes.erase(utils::fnv1a(topic));
+            m_hashes_dirty = true;
+        }
+        if (!retired.empty()) {
+            ESP_LOGI(TAG, "Migrated %zu discovery configs to the %s layout", retired.size(), DEVICE_DISCOVERY ? "device" : "entity");
+        }
+
+        if (aborted) {
+            ESP_LOGW(TAG, "MQTT disconnected during discovery, %zu of %zu configs published", published, total);
+        } else {
+            ESP_LOGI(TAG, "Discovery done: %zu of %zu configs changed%s", published, total, force ? " (forced)" : "");
+        }
+        if (m_hashes_dirty) {
+            saveHashes();
+            m_hashes_dirty = false;
+        }
+    }
+
+    bool MQTTHomeAssistantDiscovery::publishPaced(const std::string& topic, const std::string_view payload, utils::TokenBucket& bucket) {
+        while (const uint32_t wait_ms = bucket.tryAcquire(esp_timer_get_time() / 1000)) {
+            vTaskDelay(pdMS_TO_TICKS(std::max<uint32_t>(wait_ms, portTICK_PERIOD_MS)));
+        }
+        return MQTTClient::Instance().publish(topic, payload, 1, true);
     }
 
-    void MQTTHomeAssistantDiscovery::publishLight(const DaliLongAddress_t long_addr) {
-        const auto& mqtt = MQTTClient::Instance();
+    bool MQTTHomeAssistantDiscovery::publishIfChanged(const DiscoveryMessage& msg, const bool force, utils::TokenBucket& bucket) {
+        const uint32_t topic_hash = utils::fnv1a(msg.topic);
+        const uint32_t payload_hash = utils::fnv1a(msg.payload);
 
-        const auto addr_str_arr = utils::longAddressToString(long_addr);
-        const std::string addr_str(addr_str_arr.data());
+        const auto it = m_published_hashes.find(topic_hash);
+        if (!force && it != m_published_hashes.end() && it->second == payload_hash) {
+            return false;
+        }
 
-        const std::string object_id = utils::stringFormat("dali_light_%s", addr_str.c_str());
-        const std::string discovery_topic = utils::stringFormat("homeassistant/light/%s/config", object_id.c_str());
-        const std::string device_status_topic = utils::stringFormat("%s/light/%s/status", base_topic.c_str(), addr_str.c_str());
+        if (!publishPaced(msg.topic, msg.payload, bucket)) {
+            ESP_LOGW(TAG, "Discovery config %s was dropped, retrying on the next run", msg.topic.c_str());
+            // The broker may hold neither the old nor the new config now
+            if (it != m_published_hashes.end()) {
+                m_published_hashes.erase(it);
+                m_hashes_dirty = true;
+            }
+            return false;
+        }
 
-        std::string readable_name;
+        if (it == m_published_hashes.end() || it->second != payload_hash) {
+            m_published_hashes[topic_hash] = payload_hash;
+            m_hashes_dirty = true;
+        }
+        return true;
+    }
+
+    void MQTTHomeAssistantDiscovery::addBridgeDevice(cJSON* root) const {
+        cJSON* device = cJSON_CreateObject();
+        if (device) {
+            cJSON_AddStringToObject(device, "identifiers", bridge_public_name.c_str());
+            cJSON_AddStringToObject(device, "name", bridge_public_name.c_str());
+            cJSON_AddStringToObject(device, "model", "ESP32 DALI Bridge");
+            cJSON_AddStringToObject(device, "manufacturer", "DALI-MQTT4ESP");
+            cJSON_AddStringToObject(device, "sw_version", DALIMQTT_VERSION);
+            cJSON_AddItemToObject(root, "device", device);
+        }
+    }
+
+    std::string MQTTHomeAssistantDiscovery::readableName(const std::string& addr_str) const {
         const auto it = device_identification.find(addr_str);
         if (it != device_identification.end() && !it->second.empty()) {
-            readable_name = it->second;
-        }
-        if (readable_name.empty()) {
-            readable_name = utils::stringFormat("DALI Device %s", addr_str.c_str());
+            return it->second;
         }
+        return utils::stringFormat("DALI Device %s", addr_str.c_str());
+    }
+
+    cJSON* MQTTHomeAssistantDiscovery::createLightComponent(const ControlGear& gear) const {
+        const auto addr_str_arr = utils::longAddressToString(gear.long_address);
+        const std::string addr_str(addr_str_arr.data());
+
+        const std::string object_id = utils::stringFormat("dali_light_%s", addr_str.c_str());
+        const std::string device_status_topic = utils::stringFormat("%s/light/%s/status", base_topic.c_str(), addr_str.c_str());
+        const std::string readable_name = readableName(addr_str);
 
         cJSON* root = cJSON_CreateObject();
-        if (!root) return;
-
-        ControlGear dev_copy;
-        {
-            const auto devices = DaliDeviceController::Instance().getDevices();
-            if (devices.contains(long_addr)) {
-                if (const auto* gear = std::get_if<ControlGear>(&devices.at(long_addr))) {
-                    dev_copy = *gear;
-                } else {
-                    return;
-                }
-            } else {
-                return;
-            }
-        }
+        if (!root) return nullptr;
 
         cJSON_AddStringToObject(root, "name", readable_name.c_str());
         cJSON_AddStringToObject(root, "unique_id", object_id.c_str());
@@ -86,9 +270,10 @@ namespace daliMQTT
         cJSON_AddStringToObject(root, "command_topic", utils::stringFormat("%s/light/%s/set", base_topic.c_str(), addr_str.c_str()).c_str());
         cJSON_AddStringToObject(root, "state_topic", utils::stringFormat("%s/light/%s/state", base_topic.c_str(), addr_str.c_str()).c_str());
         cJSON_AddTrueToObject(root, "brightness");
+        cJSON_AddNumberToObject(root, "brightness_scale", 254);
 
-        if (dev_copy.device_type.has_value() && dev_copy.device_type.value() == 8 && dev_copy.color.has_value()) {
-            const auto& c = dev_copy.color.value();
+        if (gear.device_type.has_value() && gear.device_type.value() == 8 && gear.color.has_value()) {
+            const auto& c = gear.color.value();
             cJSON* color_modes = cJSON_CreateArray();
             if (c.supports_tc) {
                 cJSON_AddItemToArray(color_modes, cJSON_CreateString("color_temp"));
@@ -118,34 +303,15 @@ namespace daliMQTT
 
         cJSON_AddItemToObject(root, "availability", av_list);
         cJSON_AddStringToObject(root, "availability_mode", "all");
-
-        cJSON* device = cJSON_CreateObject();
-        if (device) {
-            cJSON_AddStringToObject(device, "identifiers", bridge_public_name.c_str());
-            cJSON_AddStringToObject(device, "name", bridge_public_name.c_str());
-            cJSON_AddStringToObject(device, "model", "ESP32 DALI Bridge");
-            cJSON_AddStringToObject(device, "manufacturer", "DALI-MQTT4ESP");
-            cJSON_AddStringToObject(device, "sw_version", DALIMQTT_VERSION);
-            cJSON_AddItemToObject(root, "device", device);
-        }
-
-        if (char* json_payload = cJSON_PrintUnformatted(root)) {
-            mqtt.publish(discovery_topic, json_payload, 1, true);
-            free(json_payload);
-        }
-
-        cJSON_Delete(root);
+        return root;
     }
 
-    void MQTTHomeAssistantDiscovery::publishGroup(uint8_t group_id) {
-        const auto& mqtt = MQTTClient::Instance();
-        const auto config = ConfigManager::Instance().getConfig();
-        const std::string object_id = utils::stringFormat("dali_group_%s_%d", config.client_id.c_str(), group_id);
-        const std::string discovery_topic = utils::stringFormat("homeassistant/light/%s/config", object_id.c_str());
+    cJSON* MQTTHomeAssistantDiscovery::createGroupComponent(const uint8_t group_id, const bool supports_tc, const bool supports_rgb) const {
+        const std::string object_id = utils::stringFormat("dali_group_%s_%d", client_id.c_str(), group_id);
         const std::string readable_name = utils::stringFormat("DALI Group %d", group_id);
 
         cJSON* root = cJSON_CreateObject();
-        if (!root) return;
+        if (!root) return nullptr;
 
         cJSON_AddStringToObject(root, "name", readable_name.c_str());
         cJSON_AddStringToObject(root, "unique_id", object_id.c_str());
@@ -156,72 +322,30 @@ namespace daliMQTT
                                 utils::stringFormat("%s/light/group/%d/state", base_topic.c_str(), group_id).c_str());
 
         cJSON_AddTrueToObject(root, "brightness");
+        cJSON_AddNumberToObject(root, "brightness_scale", 254);
 
-        bool group_supports_tc = false;
-        bool group_supports_rgb = false;
-
-        {
-            const auto devices = DaliDeviceController::Instance().getDevices();
-            auto assignments = DaliGroupManagement::Instance().getAllAssignments();
-
-            for (const auto& [long_addr, groups] : assignments) {
-                if (groups.test(group_id)) {
-                    if (devices.contains(long_addr)) {
-                        if (auto* gear = std::get_if<ControlGear>(&devices.at(long_addr))) {
-                            if (gear->color.has_value())
-                            {
-                                if (gear->color->supports_tc) group_supports_tc = true;
-                                if (gear->color->supports_rgb) group_supports_rgb = true;
-                            }
-                        }
-                    }
-                }
-            }
-        }
-
-        if (group_supports_tc || group_supports_rgb) {
+        if (supports_tc || supports_rgb) {
             cJSON* color_modes = cJSON_CreateArray();
-            if (group_supports_tc) {
+            if (supports_tc) {
                 cJSON_AddItemToArray(color_modes, cJSON_CreateString("color_temp"));
                 cJSON_AddNumberToObject(root, "min_mireds", 153);
                 cJSON_AddNumberToObject(root, "max_mireds", 500);
             }
-            if (group_supports_rgb) {
+            if (supports_rgb) {
                 cJSON_AddItemToArray(color_modes, cJSON_CreateString("rgb"));
             }
             cJSON_AddItemToObject(root, "supported_color_modes", color_modes);
         }
 
-        cJSON_AddStringToObject(root, "availability_topic", availability_topic.c_str());
-        cJSON_AddStringToObject(root, "payload_available", CONFIG_DALI2MQTT_MQTT_PAYLOAD_ONLINE);
-        cJSON_AddStringToObject(root, "payload_not_available", CONFIG_DALI2MQTT_MQTT_PAYLOAD_OFFLINE);
-
-        cJSON* device = cJSON_CreateObject();
-        if (device) {
-            cJSON_AddStringToObject(device, "identifiers", bridge_public_name.c_str());
-            cJSON_AddStringToObject(device, "name", bridge_public_name.c_str());
-            cJSON_AddStringToObject(device, "model", "ESP32 DALI Bridge");
-            cJSON_AddStringToObject(device, "manufacturer", "DALI-MQTT4ESP");
-            cJSON_AddStringToObject(device, "sw_version", DALIMQTT_VERSION);
-            cJSON_AddItemToObject(root, "device", device);
-        }
-
-        if (char* json_payload = cJSON_PrintUnformatted(root)) {
-            mqtt.publish(discovery_topic, json_payload, 1, true);
-            free(json_payload);
-        }
-
-        cJSON_Delete(root);
+        addBridgeAvailability(root);
+        return root;
     }
 
-    void MQTTHomeAssistantDiscovery::publishSceneSelector() {
-        const auto& mqtt = MQTTClient::Instance();
-        const auto config = ConfigManager::Instance().getConfig();
-        const std::string object_id = utils::stringFormat("dali_scenes_%s", config.client_id.c_str());
-        const std::string discovery_topic = utils::stringFormat("homeassistant/select/%s/config", object_id.c_str());
+    cJSON* MQTTHomeAssistantDiscovery::createSceneSelectComponent() const {
+        const std::string object_id = utils::stringFormat("dali_scenes_%s", client_id.c_str());
 
         cJSON* root = cJSON_CreateObject();
-        if (!root) return;
+        if (!root) return nullptr;
 
         cJSON_AddStringToObject(root, "name", "DALI Scenes");
         cJSON_AddStringToObject(root, "unique_id", object_id.c_str());
@@ -234,24 +358,211 @@ namespace daliMQTT
         }
         cJSON_AddItemToObject(root, "options", options);
 
+        addBridgeAvailability(root);
+        return root;
+    }
+
+    cJSON* MQTTHomeAssistantDiscovery::createDiagnosticSensor(const char* name, const char* key, const char* subtopic) const {
+        cJSON* root = cJSON_CreateObject();
+        if (!root) return nullptr;
+
+        cJSON_AddStringToObject(root, "platform", "sensor");
+        cJSON_AddStringToObject(root, "name", name);
+        cJSON_AddStringToObject(root, "unique_id", utils::stringFormat("dali_bridge_%s_%s", client_id.c_str(), key).c_str());
+        cJSON_AddStringToObject(root, "state_topic", utils::stringFormat("%s%s", base_topic.c_str(), subtopic).c_str());
+        cJSON_AddStringToObject(root, "entity_category", "diagnostic");
+        return root;
+    }
+
+    void MQTTHomeAssistantDiscovery::addBridgeAvailability(cJSON* root) const {
         cJSON_AddStringToObject(root, "availability_topic", availability_topic.c_str());
         cJSON_AddStringToObject(root, "payload_available", CONFIG_DALI2MQTT_MQTT_PAYLOAD_ONLINE);
         cJSON_AddStringToObject(root, "payload_not_available", CONFIG_DALI2MQTT_MQTT_PAYLOAD_OFFLINE);
+    }
+
+    std::optional<MQTTHomeAssistantDiscovery::DiscoveryMessage> MQTTHomeAssistantDiscovery::finish(std::string topic, cJSON* root) {
+        if (!root) return std::nullopt;
+        std::optional<DiscoveryMessage> msg;
+        if (char* json_payload = cJSON_PrintUnformatted(root)) {
+            msg = DiscoveryMessage{std::move(topic), json_payload};
+            free(json_payload);
+        }
+        cJSON_Delete(root);
+        return msg;
+    }
+
+    std::optional<MQTTHomeAssistantDiscovery::DiscoveryMessage> MQTTHomeAssistantDiscovery::buildLight(const ControlGear& gear) const {
+        cJSON* root = createLightComponent(gear);
+        if (root) addBridgeDevice(root);
+        return finish(lightTopic(gear.long_address), root);
+    }
+
+    std::optional<MQTTHomeAssistantDiscovery::DiscoveryMessage> MQTTHomeAssistantDiscovery::buildGroup(const uint8_t group_id, const bool supports_tc, const bool supports_rgb) const {
+        cJSON* root = createGroupComponent(group_id, supports_tc, supports_rgb);
+        if (root) addBridgeDevice(root);
+        return finish(groupTopic(group_id), root);
+    }
+
+    std::optional<MQTTHomeAssistantDiscovery::DiscoveryMessage> MQTTHomeAssistantDiscovery::buildSceneSelector() const {
+        cJSON* root = createSceneSelectComponent();
+        if (root) addBridgeDevice(root);
+        return finish(sceneSelectorTopic(), root);
+    }
+
+    void MQTTHomeAssistantDiscovery::addOrigin(cJSON* root) {
+        cJSON* origin = cJSON_CreateObject();
+        if (!origin) return;
+        cJSON_AddStringToObject(origin, "name", "DALI-MQTT4ESP");
+        cJSON_AddStringToObject(origin, "sw_version", DALIMQTT_VERSION);
+        cJSON_AddItemToObject(root, "origin", origin);
+    }
+
+    std::optional<MQTTHomeAssistantDiscovery::DiscoveryMessage> MQTTHomeAssistantDiscovery::buildBridgeDevice(
+        const std::array<bool, 16>& group_tc, const std::array<bool, 16>& group_rgb) const {
+        cJSON* root = cJSON_CreateObject();
+        if (!root) return std::nullopt;
+
+        addBridgeDevice(root);
+        addOrigin(root);
+
+        cJSON* components = cJSON_CreateObject();
+        for (uint8_t i = 0; i < 16; ++i) {
+            if (cJSON* group = createGroupComponent(i, group_tc[i], group_rgb[i])) {
+                cJSON_AddStringToObject(group, "platform", "light");
+                cJSON_AddItemToObject(components, utils::stringFormat("group_%d", i).c_str(), group);
+            }
+        }
+        if (cJSON* scenes = createSceneSelectComponent()) {
+            cJSON_AddStringToObject(scenes, "platform", "select");
+            cJSON_AddItemToObject(components, "scenes", scenes);
+        }
+        if (cJSON* ip = createDiagnosticSensor("IP Address", "ip", "/ip_addr")) {
+            cJSON_AddItemToObject(components, "ip", ip);
+        }
+        if (cJSON* version = createDiagnosticSensor("Firmware Version", "version", "/version")) {
+            cJSON_AddItemToObject(components, "version", version);
+        }
+        cJSON_AddItemToObject(root, "components", components);
+
+        return finish(bridgeDeviceTopic(), root);
+    }
+
+    std::optional<MQTTHomeAssistantDiscovery::DiscoveryMessage> MQTTHomeAssistantDiscovery::buildGearDevice(const ControlGear& gear) const {
+        const auto addr_str_arr = utils::longAddressToString(gear.long_address);
+        const std::string addr_str(addr_str_arr.data());
+
+        cJSON* light = createLightComponent(gear);
+        if (!light) return std::nullopt;
+        cJSON* root = cJSON_CreateObject();
+        if (!root) {
+            cJSON_Delete(light);
+            return std::nullopt;
+        }
 
         cJSON* device = cJSON_CreateObject();
         if (device) {
-            cJSON_AddStringToObject(device, "identifiers", bridge_public_name.c_str());
-            cJSON_AddStringToObject(device, "name", bridge_public_name.c_str());
-            cJSON_AddStringToObject(device, "model", "ESP32 DALI Bridge");
-            cJSON_AddStringToObject(device, "manufacturer", "DALI-MQTT4ESP");
-            cJSON_AddStringToObject(device, "sw_version", DALIMQTT_VERSION);
+            cJSON_AddStringToObject(device, "identifiers", utils::stringFormat("dali_gear_%s", addr_str.c_str()).c_str());
+            cJSON_AddStringToObject(device, "name", readableName(addr_str).c_str());
+            cJSON_AddStringToObject(device, "manufacturer", "DALI");
+            cJSON_AddStringToObject(device, "model", gear.device_type.has_value()
+                ? utils::stringFormat("DALI DT%u", *gear.device_type).c_str() : "DALI Control Gear");
+            if (!gear.gtin.empty()) {
+                cJSON_AddStringToObject(device, "model_id", gear.gtin.c_str());
+            }
+            cJSON_AddStringToObject(device, "serial_number", addr_str.c_str());
+            cJSON_AddStringToObject(device, "via_device", bridge_public_name.c_str());
             cJSON_AddItemToObject(root, "device", device);
         }
+        addOrigin(root);
 
-        if (char* json_payload = cJSON_PrintUnformatted(root)) {
-            mqtt.publish(discovery_topic, json_payload, 1, true);
-            free(json_payload);
+        // The entity takes the device name instead of repeating it
+        cJSON_ReplaceItemInObject(light, "name", cJSON_CreateNull());
+        cJSON_AddStringToObject(light, "platform", "light");
+        cJSON* components = cJSON_CreateObject();
+        cJSON_AddItemToObject(components, "light", light);
+        cJSON_AddItemToObject(root, "components", components);
+
+        return finish(gearDeviceTopic(gear.long_address), root);
+    }
+
+    std::string MQTTHomeAssistantDiscovery::lightTopic(const DaliLongAddress_t long_addr) {
+        return utils::stringFormat("homeassistant/light/dali_light_%s/config", utils::longAddressToString(long_addr).data());
+    }
+
+    std::string MQTTHomeAssistantDiscovery::groupTopic(const uint8_t group_id) const {
+        return utils::stringFormat("homeassistant/light/dali_group_%s_%d/config", client_id.c_str(), group_id);
+    }
+
+    std::string MQTTHomeAssistantDiscovery::sceneSelectorTopic() const {
+        return utils::stringFormat("homeassistant/select/dali_scenes_%s/config", client_id.c_str());
+    }
+
+    std::string MQTTHomeAssistantDiscovery::bridgeDeviceTopic() const {
+        return utils::stringFormat("homeassistant/device/dali_bridge_%s/config", client_id.c_str());
+    }
+
+    std::string MQTTHomeAssistantDiscovery::gearDeviceTopic(const DaliLongAddress_t long_addr) {
+        return utils::stringFormat("homeassistant/device/dali_gear_%s/config", utils::longAddressToString(long_addr).data());
+    }
+
+    void MQTTHomeAssistantDiscovery::loadHashes() {
+        const NvsHandle nvs_handle(NVS_NAMESPACE, NVS_READONLY);
+        if (!nvs_handle) return;
+
+        size_t required_size = 0;
+        esp_err_t err = nvs_get_blob(nvs_handle.get(), HASHES_KEY, nullptr, &required_size);
+        if (err != ESP_OK || required_size < sizeof(HashesHeader)) {
+            ESP_LOGI(TAG, "No discovery hashes in NVS, all configs will be published.");
+            return;
+        }
+        if ((required_size - sizeof(HashesHeader)) % sizeof(HashRecord) != 0) {
+            ESP_LOGE(TAG, "Invalid blob size for discovery hashes. Data might be corrupt.");
+            return;
+        }
+
+        std::vector<uint8_t> blob(required_size);
+        err = nvs_get_blob(nvs_handle.get(), HASHES_KEY, blob.data(), &required_size);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Error reading discovery hashes blob: %s", esp_err_to_name(err));
+            return;
+        }
+
+        HashesHeader header{};
+        std::memcpy(&header, blob.data(), sizeof(header));
+        if (header.version != HASHES_VERSION) {
+            ESP_LOGW(TAG, "Discovery hashes have version %u, expected %u. Ignoring.", header.version, HASHES_VERSION);
+            return;
+        }
+
+        m_context_hash = header.context_hash;
+        for (size_t offset = sizeof(HashesHeader); offset < blob.size(); offset += sizeof(HashRecord)) {
+            HashRecord record{};
+            std::memcpy(&record, blob.data() + offset, sizeof(record));
+            m_published_hashes[record.topic_hash] = record.payload_hash;
+        }
+        ESP_LOGI(TAG, "Loaded %zu discovery hashes from NVS.", m_published_hashes.size());
+    }
+
+    void MQTTHomeAssistantDiscovery::saveHashes() const {
+        const NvsHandle nvs_handle(NVS_NAMESPACE, NVS_READWRITE);
+        if (!nvs_handle) return;
+
+        std::vector<uint8_t> blob(sizeof(HashesHeader) + m_published_hashes.size() * sizeof(HashRecord));
+        const HashesHeader header{.version = HASHES_VERSION, .reserved = {}, .context_hash = m_context_hash};
+        std::memcpy(blob.data(), &header, sizeof(header));
+        size_t offset = sizeof(HashesHeader);
+        for (const auto& [topic_hash, payload_hash] : m_published_hashes) {
+            const HashRecord record{.topic_hash = topic_hash, .payload_hash = payload_hash};
+            std::memcpy(blob.data() + offset, &record, sizeof(record));
+            offset += sizeof(record);
+        }
+
+        esp_err_t err = nvs_set_blob(nvs_handle.get(), HASHES_KEY, blob.data(), blob.size());
+        if (err == ESP_OK) {
+            err = nvs_commit(nvs_handle.get());
+        }
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to save discovery hashes: %s", esp_err_to_name(err));
         }
-        cJSON_Delete(root);
     }
-} // daliMQTT
\ No newline at end of file
+} // daliMQTT
@@ -1,25 +1,119 @@
 #ifndef DALIMQTT_HA_DISCOVERY_HXX
 #define DALIMQTT_HA_DISCOVERY_HXX
 #include "dali/DaliСommon.hxx"
+#include "dali/DaliGroupManagement.hxx"
+#include "utils/TokenBucket.hxx"
 
 namespace daliMQTT
 {
+    /** Home Assistant publishes its birth ("online") message here after it starts. */
+    inline constexpr char HA_STATUS_TOPIC[] = "homeassistant/status";
+
     class MQTTHomeAssistantDiscovery
     {
         public:
-            MQTTHomeAssistantDiscovery();
-            void publishAllDevices();
+            MQTTHomeAssistantDiscovery(const MQTTHomeAssistantDiscovery&) = delete;
+            MQTTHomeAssistantDiscovery& operator=(const MQTTHomeAssistantDiscovery&) = delete;
+
+            static MQTTHomeAssistantDiscovery& Instance() {
+                static MQTTHomeAssistantDiscovery instance;
+                return instance;
+            }
+
+            /**
+             * @brief Publishes discovery configs in a background task.
+             * @param force Republish every config, even those whose hash matches the last published one
+             *              (manual request, Home Assistant restart).
+             * A request arriving while a run is in progress is queued and runs afterwards.
+             */
+            void requestPublish(bool force);
 
         private:
-            void publishLight(DaliLongAddress_t long_addr);
-            void publishGroup(uint8_t group_id);
-            void publishSceneSelector();
+            MQTTHomeAssistantDiscovery() = default;
+
+            static constexpr char NVS_NAMESPACE[] = "dali_state";
+            static constexpr char HASHES_KEY[] = "HADiscHash";
+            static constexpr uint8_t HASHES_VERSION = 1;
+
+            struct DiscoveryMessage {
+                std::string topic;
+                std::string payload;
+            };
+
+            struct __attribute__((packed)) HashesHeader {
+                uint8_t version;
+                uint8_t reserved[3];
+                uint32_t context_hash;   // Broker, client id and base topic the hashes are valid for
+            };
+
+            struct __attribute__((packed)) HashRecord {
+                uint32_t topic_hash;
+                uint32_t payload_hash;
+            };
+
+            static void discoveryTask(void* arg);
+            void publishAllDevices(bool force);
+
+            void refreshRunContext();
+            [[nodiscard]] std::string readableName(const std::string& addr_str) const;
+
+            // Entity components, shared by both discovery layouts
+            [[nodiscard]] cJSON* createLightComponent(const ControlGear& gear) const;
+            [[nodiscard]] cJSON* createGroupComponent(uint8_t group_id, bool supports_tc, bool supports_rgb) const;
+            [[nodiscard]] cJSON* createSceneSelectComponent() const;
+            [[nodiscard]] cJSON* createDiagnosticSensor(const char* name, const char* key, const char* subtopic) const;
+            void addBridgeAvailability(cJSON* root) const;
+            void addBridgeDevice(cJSON* root) const;
+            static void addOrigin(cJSON* root);
+
+            /** Prints and frees root. */
+            static std::optional<DiscoveryMessage> finish(std::string topic, cJSON* root);
+
+            // One config per entity
+            [[nodiscard]] std::optional<DiscoveryMessage> buildLight(const ControlGear& gear) const;
+            [[nodiscard]] std::optional<DiscoveryMessage> buildGroup(uint8_t group_id, bool supports_tc, bool supports_rgb) const;
+            [[nodiscard]] std::optional<DiscoveryMessage> buildSceneSelector() const;
+
+            // One config per device (bridge with groups, scenes and diagnostics; one per gear)
+            [[nodiscard]] std::optional<DiscoveryMessage> buildBridgeDevice(const std::array<bool, 16>& group_tc,
+                                                                            const std::array<bool, 16>& group_rgb) const;
+            [[nodiscard]] std::optional<DiscoveryMessage> buildGearDevice(const ControlGear& gear) const;
+
+            static std::string lightTopic(DaliLongAddress_t long_addr);
+            [[nodiscard]] std::string groupTopic(uint8_t group_id) const;
+            [[nodiscard]] std::string sceneSelectorTopic() const;
+            [[nodiscard]] std::string bridgeDeviceTopic() const;
+            static std::string gearDeviceTopic(DaliLongAddress_t long_addr);
+
+            /**
+             * Publishes the message unless its hash is unchanged. The hash is only recorded once the
+             * message was accepted, so a dropped config is retried on the next run.
+             * @return true if it was published.
+             */
+            bool publishIfChanged(const DiscoveryMessage& msg, bool force, utils::TokenBucket& bucket);
+            /** Publishes at the discovery rate. Returns false if the message was dropped. */
+            static bool publishPaced(const std::string& topic, std::string_view payload, utils::TokenBucket& bucket);
+
+            void loadHashes();
+            void saveHashes() const;
 
             std::string base_topic;
             std::string availability_topic;
             std::string bridge_public_name;
+            std::string client_id;
             std::map<std::string, std::string> device_identification;
+            uint32_t m_names_hash{0};
+
+            std::map<uint32_t, uint32_t> m_published_hashes;   // topic hash -> payload hash
+            uint32_t m_context_hash{0};
+            bool m_hashes_loaded{false};
+            bool m_hashes_dirty{false};
+
+            std::mutex m_request_mutex;
+            bool m_running{false};
+            bool m_rerun_requested{false};
+            bool m_force_requested{false};
     };
 } // daliMQTT
 
-#endif // DALIMQTT_HA_DISCOVERY_HXX
\ No newline at end of file
+#endif // DALIMQTT_HA_DISCOVERY_HXX
@@ -0,0 +1,125 @@
+#include "mqtt/MQTTBusSnapshot.hxx"
+#include "mqtt/MQTTClient.hxx"
+#include "dali/DaliDeviceController.hxx"
+#include "mqtt/MQTTPayloadFormats.hxx"
+#include "system/ConfigManager.hxx"
+
+namespace daliMQTT
+{
+    static constexpr char TAG[] = "MQTTBusSnapshot";
+#ifdef CONFIG_DALI2MQTT_MQTT_BUS_SNAPSHOT_ENABLED
+    static constexpr bool SNAPSHOT_ENABLED = true;
+    static constexpr uint32_t SNAPSHOT_INTERVAL_MS = CONFIG_DALI2MQTT_MQTT_BUS_SNAPSHOT_INTERVAL_MS;
+#else
+    static constexpr bool SNAPSHOT_ENABLED = false;
+    static constexpr uint32_t SNAPSHOT_INTERVAL_MS = 0;
+#endif
+
+    void MQTTBusSnapshot::init() {
+        if (!SNAPSHOT_ENABLED || m_task_handle) return;
+        if (xTaskCreate(publishTask, "mqtt_bus_snap", 3072, this, 3, &m_task_handle) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create bus snapshot task");
+            m_task_handle = nullptr;
+            return;
+        }
+        ESP_LOGI(TAG, "Bus snapshot topic enabled (%lu ms)", static_cast<unsigned long>(SNAPSHOT_INTERVAL_MS));
+    }
+
+    void MQTTBusSnapshot::markDirty() {
+        if (m_task_handle) {
+            xTaskNotifyGive(m_task_handle);
+        }
+    }
+
+    void MQTTBusSnapshot::reset() {
+        m_force.store(true);
+        markDirty();
+    }
+
+    bool MQTTBusSnapshot::serialize(utils::PayloadWriter& writer, const uint32_t seq, const BusSnapshotEntries& entries) {
+        uint64_t avail_bitmap = 0;
+        for (size_t sa = 0; sa < entries.size(); ++sa) {
+            if (entries[sa].present && entries[sa].available) {
+                avail_bitmap |= (1ULL << sa);
+            }
+        }
+        // 64-bit values exceed the exact integer range of JSON doubles, so send hex in every encoding
+        char avail_hex[17];
+        snprintf(avail_hex, sizeof(avail_hex), "%016llX", static_cast<unsigned long long>(avail_bitmap));
+
+        writer.beginObject()
+            .add("v", FORMAT_VERSION)
+            .add("seq", seq)
+            .add("avail", avail_hex)
+            .beginArray("d");
+        for (size_t sa = 0; sa < entries.size(); ++sa) {
+            const auto& entry = entries[sa];
+            if (!entry.present) continue;
+            const int32_t rgb = entry.rgb.has_value()
+                ? static_cast<int32_t>((entry.rgb->r << 16) | (entry.rgb->g << 8) | entry.rgb->b)
+                : -1;
+            writer.beginArray()
+                .element(sa)
+                .element(entry.level)
+                .element(entry.status_byte)
+                .element(entry.color_temp.has_value() ? static_cast<int32_t>(*entry.color_temp) : -1)
+                .element(rgb)
+                .endArray();
+        }
+        writer.endArray().endObject();
+        return writer.ok();
+    }
+
+    void MQTTBusSnapshot::publishTask(void* arg) {
+        auto* self = static_cast<MQTTBusSnapshot*>(arg);
+        const TickType_t interval = pdMS_TO_TICKS(SNAPSHOT_INTERVAL_MS);
+        while (true) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            // Let the burst that woke us settle, everything arriving meanwhile is in the same message
+            vTaskDelay(interval);
+            ulTaskNotifyTake(pdTRUE, 0);
+            self->publishIfChanged();
+        }
+    }
+
+    void MQTTBusSnapshot::publishIfChanged() {
+        DaliDeviceController::Instance().collectBusSnapshot(m_entries);
+
+        const uint32_t hash = hashEntries(m_entries);
+        const bool force = m_force.exchange(false);
+        if (m_has_published && hash == m_last_hash && !force) return;
+
+        const uint32_t seq = (m_has_published && hash == m_last_hash) ? m_seq : m_seq + 1;
+        utils::PayloadWriter writer(m_buffer.data(), m_buffer.size(), BUS_SNAPSHOT_PAYLOAD_FORMAT);
+        if (!serialize(writer, seq, m_entries)) {
+            ESP_LOGE(TAG, "Bus snapshot does not fit %zu bytes", m_buffer.size());
+            return;
+        }
+
+        const std::string topic = ConfigManager::Instance().getMqttBaseTopic() + "/bus/state";
+        MQTTClient::Instance().publish(topic, writer.view(), 0, true);
+        m_seq = seq;
+        m_last_hash = hash;
+        m_has_published = true;
+        ESP_LOGD(TAG, "Published bus snapshot seq=%lu (%zu bytes)", static_cast<unsigned long>(seq), writer.view().size());
+    }
+
+    uint32_t MQTTBusSnapshot::hashEntries(const BusSnapshotEntries& entries) {
+        uint32_t hash = 2166136261u;
+        const auto mix = [&hash](const uint32_t value) {
+            for (int shift = 0; shift < 32; shift += 8) {
+                hash ^= (value >> shift) & 0xFF;
+                hash *= 16777619u;
+            }
+        };
+        for (const auto& entry : entries) {
+            mix((entry.present ? 1u : 0u) | (entry.available ? 2u : 0u) |
+                (static_cast<uint32_t>(entry.level) << 8) | (static_cast<uint32_t>(entry.status_byte) << 16));
+            mix(entry.color_temp.has_value() ? *entry.color_temp : 0x10000u);
+            mix(entry.rgb.has_value()
+                ? static_cast<uint32_t>((entry.rgb->r << 16) | (entry.rgb->g << 8) | entry.rgb->b)
+                : 0x1000000u);
+        }
+        return hash;
+    }
+} // daliMQTT
@@ -0,0 +1,71 @@
+#ifndef DALIMQTT_MQTTBUSSNAPSHOT_HXX
+#define DALIMQTT_MQTTBUSSNAPSHOT_HXX
+
+#include "dali/DaliСommon.hxx"
+#include "utils/PayloadWriter.hxx"
+
+namespace daliMQTT
+{
+    /** Compact runtime state of one control gear, indexed by short address. */
+    struct BusSnapshotEntry {
+        bool present{false};
+        bool available{false};
+        uint8_t level{0};
+        uint8_t status_byte{0};
+        std::optional<uint16_t> color_temp;
+        std::optional<DaliRGB> rgb;
+    };
+    using BusSnapshotEntries = std::array<BusSnapshotEntry, 64>;
+
+    /**
+     * @brief Retained whole-bus state on base/bus/state.
+     *
+     * Payload: {"v":1,"seq":N,"avail":"<64-bit hex bitmap>","d":[[sa,level,status,tc,rgb],...]},
+     * in JSON, CBOR or MessagePack depending on BUS_SNAPSHOT_PAYLOAD_FORMAT.
+     * tc is mireds, rgb is 0xRRGGBB, -1 when unknown. "seq" increments with every published
+     * change, so a client seeing a gap knows it missed an update.
+     */
+    class MQTTBusSnapshot {
+    public:
+        MQTTBusSnapshot(const MQTTBusSnapshot&) = delete;
+        MQTTBusSnapshot& operator=(const MQTTBusSnapshot&) = delete;
+
+        static MQTTBusSnapshot& Instance() {
+            static MQTTBusSnapshot instance;
+            return instance;
+        }
+
+        static constexpr uint8_t FORMAT_VERSION = 1;
+
+        /** Starts the publish task. No-op unless the snapshot topic is enabled. */
+        void init();
+
+        /** Schedules a publish; calls within one interval collapse into one message. */
+        void markDirty();
+
+        /** Forces the next snapshot out even if the bus state is unchanged, e.g. after a reconnect. */
+        void reset();
+
+        /** Serializes the snapshot. Returns false if the writer ran out of space. */
+        static bool serialize(utils::PayloadWriter& writer, uint32_t seq, const BusSnapshotEntries& entries);
+
+    private:
+        MQTTBusSnapshot() = default;
+
+        static constexpr size_t PAYLOAD_BUFFER_SIZE = 2048;
+
+        [[noreturn]] static void publishTask(void* arg);
+        void publishIfChanged();
+        static uint32_t hashEntries(const BusSnapshotEntries& entries);
+
+        std::array<char, PAYLOAD_BUFFER_SIZE> m_buffer{};
+        BusSnapshotEntries m_entries{};
+        uint32_t m_seq{0};
+        uint32_t m_last_hash{0};
+        bool m_has_published{false};
+        std::atomic<bool> m_force{false};
+        TaskHandle_t m_task_handle{nullptr};
+    };
+} // daliMQTT
+
+#endif //DALIMQTT_MQTTBUSSNAPSHOT_HXX
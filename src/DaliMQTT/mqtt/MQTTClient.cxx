@@ -1,8 +1,13 @@
 #include "mqtt/MQTTClient.hxx"
 #include "mqtt/MQTTCommandProcess.hxx"
+#include "mqtt/MQTTOutbox.hxx"
 namespace daliMQTT
 {
     static constexpr char  TAG[] = "MQTTClient";
+#ifdef CONFIG_DALI2MQTT_MQTT_PROTOCOL_V5
+    // MQTT 5 ends a session on disconnect unless an expiry is set
+    static constexpr uint32_t SESSION_EXPIRY_S = 24 * 3600;
+#endif
 
     void MQTTClient::init(const std::string& uri,
                           const std::string& client_id,
@@ -12,7 +17,11 @@ namespace daliMQTT
                           const std::string& ca_cert) {
         esp_mqtt_client_config_t mqtt_cfg = {};
 
+    #ifdef CONFIG_DALI2MQTT_MQTT_PROTOCOL_V5
+        mqtt_cfg.session.protocol_ver = MQTT_PROTOCOL_V_5;
+    #else
         mqtt_cfg.session.protocol_ver = MQTT_PROTOCOL_V_3_1_1;
+    #endif
         mqtt_cfg.broker.address.uri = uri.c_str();
         if (!ca_cert.empty()) {
             mqtt_cfg.broker.verification.certificate = ca_cert.c_str();
@@ -31,10 +40,21 @@ namespace daliMQTT
         mqtt_cfg.session.last_will.msg = CONFIG_DALI2MQTT_MQTT_PAYLOAD_OFFLINE;
         mqtt_cfg.session.last_will.qos = 1;
         mqtt_cfg.session.last_will.retain = true;
+        // Keep subscriptions across reconnects, so a short outage needs no resync
+        mqtt_cfg.session.disable_clean_session = true;
+
+        // Raw frame batches on cmd/send must arrive in one piece
+        mqtt_cfg.buffer.size = CONFIG_DALI2MQTT_MQTT_RX_BUFFER_SIZE;
 
         client_handle = esp_mqtt_client_init(&mqtt_cfg);
         esp_mqtt_client_register_event(client_handle, MQTT_EVENT_ANY, mqttEventHandler, this);
+    #ifdef CONFIG_DALI2MQTT_MQTT_PROTOCOL_V5
+        esp_mqtt5_connection_property_config_t connect_property = {};
+        connect_property.session_expiry_interval = SESSION_EXPIRY_S;
+        esp_mqtt5_client_set_connect_property(client_handle, &connect_property);
+    #endif
         status = MqttStatus::DISCONNECTED;
+        session_present = false;
     }
 
     void MQTTClient::connect()
@@ -57,11 +77,94 @@ namespace daliMQTT
         return status;
     }
 
-    void MQTTClient::publish(const std::string& topic, const std::string& payload, const int qos, const bool retain) const
+    bool MQTTClient::publish(const std::string& topic, const std::string_view payload, const int qos, const bool retain,
+                             const PublishProperties& properties) const
     {
-        if (!client_handle) return;
-        esp_mqtt_client_publish(client_handle, topic.c_str(), payload.c_str(), payload.length(), qos, retain);
+        return publish(topic.c_str(), payload, qos, retain, properties);
+    }
+
+    bool MQTTClient::publish(const char* topic, const std::string_view payload, const int qos, const bool retain,
+                             const PublishProperties& properties) const
+    {
+        if (auto& outbox = MQTTOutbox::Instance(); outbox.isRunning()) {
+            return outbox.enqueue(topic, payload, qos, retain, properties);
+        }
+        return publishDirect(topic, payload, qos, retain, properties);
+    }
+
+#ifdef CONFIG_DALI2MQTT_MQTT_PROTOCOL_V5
+    bool MQTTClient::publishDirect(const char* topic, const std::string_view payload, const int qos, const bool retain,
+                                   const PublishProperties& properties) const
+    {
+        if (!client_handle) return false;
+        std::lock_guard lock(m_publish_mutex);
+
+        esp_mqtt5_publish_property_config_t property = {};
+        property.message_expiry_interval = properties.message_expiry_s;
+        if (!properties.correlation_data.empty()) {
+            property.correlation_data = properties.correlation_data.data();
+            property.correlation_data_len = static_cast<uint16_t>(properties.correlation_data.size());
+        }
+        // QoS 1+ messages may be resent from the outbox in a later session, where the alias means nothing
+        bool established = false;
+        if (qos == 0 && status == MqttStatus::CONNECTED) {
+            property.topic_alias = topicAlias(topic, established);
+        }
+
+        esp_mqtt5_client_set_publish_property(client_handle, &property);
+        int msg_id = esp_mqtt_client_publish(client_handle, established ? "" : topic, payload.data(),
+                                             static_cast<int>(payload.length()), qos, retain);
+        if (msg_id < 0 && property.topic_alias != 0) {
+            // The broker allows fewer aliases than configured
+            ESP_LOGW(TAG, "Topic alias %u rejected, topic aliases disabled for this session", property.topic_alias);
+            m_aliases_enabled = false;
+            property.topic_alias = 0;
+            esp_mqtt5_client_set_publish_property(client_handle, &property);
+            msg_id = esp_mqtt_client_publish(client_handle, topic, payload.data(), static_cast<int>(payload.length()), qos, retain);
+        }
+        return msg_id >= 0;
+    }
+
+    uint16_t MQTTClient::topicAlias(const std::string_view topic, bool& established) const {
+        established = false;
+        if (!m_aliases_enabled || m_topic_aliases.empty()) return 0;
+
+        ++m_alias_clock;
+        size_t oldest = 0;
+        for (size_t i = 0; i < m_topic_aliases.size(); ++i) {
+            TopicAlias& alias = m_topic_aliases[i];
+            if (!alias.topic.empty() && alias.topic == topic) {
+                alias.last_used = m_alias_clock;
+                established = true;
+                return static_cast<uint16_t>(i + 1);
+            }
+            if (alias.last_used < m_topic_aliases[oldest].last_used) oldest = i;
+        }
+
+        // Unused slots have last_used 0 and are taken first
+        TopicAlias& alias = m_topic_aliases[oldest];
+        alias.topic.assign(topic);
+        alias.last_used = m_alias_clock;
+        return static_cast<uint16_t>(oldest + 1);
+    }
+
+    void MQTTClient::resetTopicAliases() const {
+        std::lock_guard lock(m_publish_mutex);
+        for (auto& alias : m_topic_aliases) {
+            alias.topic.clear();
+            alias.last_used = 0;
+        }
+        m_alias_clock = 0;
+        m_aliases_enabled = true;
+    }
+#else
+    bool MQTTClient::publishDirect(const char* topic, const std::string_view payload, const int qos, const bool retain,
+                                   [[maybe_unused]] const PublishProperties& properties) const
+    {
+        if (!client_handle) return false;
+        return esp_mqtt_client_publish(client_handle, topic, payload.data(), static_cast<int>(payload.length()), qos, retain) >= 0;
     }
+#endif
 
     void MQTTClient::subscribe(const std::string& topic, const int qos) const
     {
@@ -76,7 +179,12 @@ namespace daliMQTT
 
         switch (static_cast<esp_mqtt_event_id_t>(event_id)) {
             case MQTT_EVENT_CONNECTED:
-                ESP_LOGI(TAG, "MQTT_EVENT_CONNECTED");
+                ESP_LOGI(TAG, "MQTT_EVENT_CONNECTED, session_present=%d", event->session_present);
+                client->session_present = event->session_present != 0;
+            #ifdef CONFIG_DALI2MQTT_MQTT_PROTOCOL_V5
+                // Aliases are per connection
+                client->resetTopicAliases();
+            #endif
                 client->status = MqttStatus::CONNECTED;
                 if(client->onConnected) client->onConnected();
                 break;
@@ -93,12 +201,33 @@ namespace daliMQTT
                 break;
             case MQTT_EVENT_DATA:
                 ESP_LOGI(TAG, "MQTT_EVENT_DATA");
-                MQTTCommandProcess::Instance().enqueueMqttMessage(
-                   event->topic,
-                   event->topic_len,
-                   event->data,
-                   event->data_len
-               );
+                if (event->data_len != event->total_data_len) {
+                    // Larger than the receive buffer, delivered in chunks; only the first carries the topic
+                    if (event->current_data_offset == 0) {
+                        ESP_LOGW(TAG, "Dropped %d byte message, larger than the receive buffer", event->total_data_len);
+                    }
+                    break;
+                }
+                {
+                    MessageProperties properties;
+                #ifdef CONFIG_DALI2MQTT_MQTT_PROTOCOL_V5
+                    if (const auto* property = event->property) {
+                        if (property->response_topic && property->response_topic_len > 0) {
+                            properties.response_topic = {property->response_topic, static_cast<size_t>(property->response_topic_len)};
+                        }
+                        if (property->correlation_data && property->correlation_data_len > 0) {
+                            properties.correlation_data = {property->correlation_data, property->correlation_data_len};
+                        }
+                    }
+                #endif
+                    MQTTCommandProcess::Instance().enqueueMqttMessage(
+                       event->topic,
+                       event->topic_len,
+                       event->data,
+                       event->data_len,
+                       properties
+                   );
+                }
                 break;
             case MQTT_EVENT_ERROR:
                 ESP_LOGE(TAG, "MQTT_EVENT_ERROR");
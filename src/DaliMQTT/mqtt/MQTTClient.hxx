@@ -11,6 +11,18 @@ namespace daliMQTT
         CONNECTED
     };
 
+    #ifdef CONFIG_DALI2MQTT_MQTT5_MESSAGE_EXPIRY_S
+        inline constexpr uint32_t TRANSIENT_MESSAGE_EXPIRY_S = CONFIG_DALI2MQTT_MQTT5_MESSAGE_EXPIRY_S;
+    #else
+        inline constexpr uint32_t TRANSIENT_MESSAGE_EXPIRY_S = 0;
+    #endif
+
+    /** MQTT 5 properties of an outgoing message. Ignored when connected with MQTT 3.1.1. */
+    struct PublishProperties {
+        std::string_view correlation_data;
+        uint32_t message_expiry_s{0};   // 0 never expires
+    };
+
     class MQTTClient {
         public:
             MQTTClient(const MQTTClient&) = delete;
@@ -26,8 +38,24 @@ namespace daliMQTT
             void disconnect();
 
             [[nodiscard]] MqttStatus getStatus() const;
+            /** Whether the broker resumed the previous session (and its subscriptions) on the last connect. */
+            [[nodiscard]] bool isSessionPresent() const { return session_present; }
 
-            void publish(const std::string& topic, const std::string& payload, int qos = 0, bool retain = false) const;
+            /**
+             * @brief Queues a message in the MQTTOutbox; never blocks on the network.
+             * @return false if the message was dropped (outbox and offline cache full, or rejected by the client).
+             */
+            bool publish(const std::string& topic, std::string_view payload, int qos = 0, bool retain = false,
+                         const PublishProperties& properties = {}) const;
+            bool publish(const char* topic, std::string_view payload, int qos = 0, bool retain = false,
+                         const PublishProperties& properties = {}) const;
+            /**
+             * @brief Hands a message to the MQTT client right away; blocks on the network for QoS > 0.
+             * Only for the outbox sender, and for publish() before the outbox runs.
+             * @return false if the client rejected the message.
+             */
+            bool publishDirect(const char* topic, std::string_view payload, int qos, bool retain,
+                               const PublishProperties& properties = {}) const;
             void subscribe(const std::string& topic, int qos = 0) const;
             void reloadConfig(const std::string& uri, const std::string& client_id, const std::string& username, const std::string& password, const std::string& availability_topic,  const std::string& ca_cert);
             // Callbacks
@@ -41,6 +69,28 @@ namespace daliMQTT
 
             esp_mqtt_client_handle_t client_handle{nullptr};
             std::atomic<MqttStatus> status{MqttStatus::DISCONNECTED};
+            std::atomic<bool> session_present{false};
+
+        #ifdef CONFIG_DALI2MQTT_MQTT_PROTOCOL_V5
+            struct TopicAlias {
+                std::string topic;
+                uint32_t last_used{0};
+            };
+
+            /**
+             * @brief Alias for a topic, establishing a new one in the least recently used slot.
+             * @param established Set if the broker already knows the alias, so the topic can be left out.
+             * @return Alias number, 0 for none.
+             */
+            uint16_t topicAlias(std::string_view topic, bool& established) const;
+            void resetTopicAliases() const;
+
+            // The publish properties are per client, setting them and publishing must not interleave
+            mutable std::mutex m_publish_mutex;
+            mutable std::array<TopicAlias, CONFIG_DALI2MQTT_MQTT5_TOPIC_ALIASES> m_topic_aliases{};
+            mutable uint32_t m_alias_clock{0};
+            mutable bool m_aliases_enabled{true};
+        #endif
     };
 } // daliMQTT
 
@@ -7,14 +7,21 @@
 #include "dali/DaliGroupManagement.hxx"
 #include "dali/DaliSceneManagement.hxx"
 #include "utils/DaliLongAddrConversions.hxx"
+#include "mqtt/HADiscovery.hxx"
+#include "utils/JsonReader.hxx"
+#include "mqtt/MQTTPayloadFormats.hxx"
+#include <esp_timer.h>
+#include "mqtt/MQTTCommandProcess.hxx"
 
 namespace daliMQTT {
     static constexpr char TAG[] = "MQTTCommandHandler";
 
     static std::atomic<bool> g_mqtt_bus_busy{false};
+    // Route tag bit next to the CommandClass: never dropped to make room in a full queue
+    static constexpr uint8_t ROUTE_NOT_DROPPABLE = 0x80;
 
     void MQTTCommandHandler::publishLightState(dali_addressType_t addr_type, uint8_t target_id,
-                                               const std::string &state_str, const DaliPublishState& state_data) {
+                                               const std::string_view state_str, const DaliPublishState& state_data) {
         auto &device_controller = DaliDeviceController::Instance();
 
         auto update_device = [&](const DaliLongAddress_t long_addr) {
@@ -49,13 +56,7 @@ namespace daliMQTT {
                 break;
             }
             case DALI_ADDRESS_TYPE_GROUP: {
-                const auto &group_manager = DaliGroupManagement::Instance();
-                auto all_assignments = group_manager.getAllAssignments();
-                for (const auto &[long_addr, groups]: all_assignments) {
-                    if (groups.test(target_id)) {
-                        update_device(long_addr);
-                    }
-                }
+                DaliGroupManagement::Instance().forEachGroupMember(target_id, update_device);
                 break;
             }
             case DALI_ADDRESS_TYPE_BROADCAST: {
@@ -74,76 +75,76 @@ namespace daliMQTT {
     }
 
 
-    void MQTTCommandHandler::handleLightCommand(const std::vector<std::string_view> &parts, const std::string &data) {
-        // topic format: light/{long_addr_hex}/set OR light/group/{id}/set
-        if (parts.size() < 3 || parts[0] != "light" || parts.back() != "set") return;
-
-        dali_addressType_t addr_type = DALI_ADDRESS_TYPE_SHORT;
-        uint8_t target_id = 0;
+    std::optional<LightCommand> MQTTCommandHandler::parseLightCommand(const std::string_view data) {
+        LightCommand command;
+        utils::JsonReader reader(data);
+        std::string_view key;
+        utils::JsonReader::Value value;
 
-        if (parts[1] == "group") {
-            if (parts.size() < 4) return;
-            addr_type = DALI_ADDRESS_TYPE_GROUP;
-            int parsed_id = -1;
-            auto [ptr, ec] = std::from_chars(parts[2].data(), parts[2].data() + parts[2].size(), parsed_id);
-            if (ec != std::errc() || parsed_id < 0 || parsed_id > 15) {
-                ESP_LOGW(TAG, "Invalid group ID received");
-                return;
-            }
-            target_id = static_cast<uint8_t>(parsed_id);
-        } else if (parts[1] == "broadcast") {
-            addr_type = DALI_ADDRESS_TYPE_BROADCAST;
-            target_id = 0;
-        } else {
-            addr_type = DALI_ADDRESS_TYPE_SHORT;
-            const auto long_addr_opt = utils::stringToLongAddress(parts[1]);
-            if (!long_addr_opt) return;
-            const auto short_addr_opt = DaliDeviceController::Instance().getShortAddress(*long_addr_opt);
-            if (!short_addr_opt) {
-                ESP_LOGD(TAG, "Received command for unknown long address: %s", std::string(parts[1]).c_str());
-                return;
+        while (reader.next(key, value)) {
+            if (key == "state") {
+                if (value.isString("ON")) {
+                    command.on = true;
+                } else if (value.isString("OFF")) {
+                    command.on = false;
+                }
+            } else if (key == "brightness") {
+                if (const auto brightness = value.asInt<int>()) {
+                    command.level = static_cast<uint8_t>(std::clamp(*brightness, 0, 254));
+                }
+            } else if (key == "color_temp") {
+                if (const auto mireds = value.asInt<int>()) {
+                    command.color_temp = static_cast<uint16_t>(*mireds);
+                }
+            } else if (key == "color" && value.type == utils::JsonReader::Type::Object) {
+                std::optional<int> r, g, b;
+                utils::JsonReader color(value.raw);
+                std::string_view channel;
+                utils::JsonReader::Value channel_value;
+                while (color.next(channel, channel_value)) {
+                    if (channel == "r") r = channel_value.asInt<int>();
+                    else if (channel == "g") g = channel_value.asInt<int>();
+                    else if (channel == "b") b = channel_value.asInt<int>();
+                }
+                if (r && g && b) {
+                    command.rgb = DaliRGB{static_cast<uint8_t>(*r), static_cast<uint8_t>(*g), static_cast<uint8_t>(*b)};
+                }
+            } else if (key == "transition") {
+                if (const auto seconds = value.asFloat(); seconds && *seconds >= 0) {
+                    command.transition_ms = static_cast<uint32_t>(*seconds * 1000.0f);
+                }
             }
-            target_id = *short_addr_opt;
         }
 
-        cJSON *root = cJSON_Parse(data.c_str());
-        if (!root) return;
+        if (!reader.ok()) return std::nullopt;
+        return command;
+    }
+
+    void MQTTCommandHandler::handleLightCommand(const dali_addressType_t addr_type, const uint8_t target_id, const std::string_view data) {
+        const auto command = parseLightCommand(data);
+        if (!command) return;
+        // Executed once the queue is drained, merged with any later command for the same target
+        MQTTCommandProcess::Instance().queueLightCommand(addr_type, target_id, *command);
+    }
 
+    void MQTTCommandHandler::executeLightCommand(const dali_addressType_t addr_type, const uint8_t target_id, const LightCommand& command) {
         auto &dali = DaliAdapter::Instance();
         DaliPublishState targetState;
-        std::optional<bool> target_on_state;
-
-        cJSON *state_item = cJSON_GetObjectItem(root, "state");
-        if (state_item && cJSON_IsString(state_item)) {
-            if (strcmp(state_item->valuestring, "ON") == 0) {
-                target_on_state = true;
-            } else if (strcmp(state_item->valuestring, "OFF") == 0) {
-                target_on_state = false;
-            }
+        const std::optional<bool> target_on_state = command.on;
+        if (command.level.has_value()) {
+            // Groups and broadcast may mix curves; they are driven as standard-curve gear
+            const DimmingCurve curve = addr_type == DALI_ADDRESS_TYPE_SHORT
+                                       ? DaliDeviceController::Instance().getDimmingCurve(target_id)
+                                       : DimmingCurve::Logarithmic;
+            targetState.level = brightnessToLevel(*command.level, curve);
         }
-        cJSON *brightness_item = cJSON_GetObjectItem(root, "brightness");
-        if (brightness_item && cJSON_IsNumber(brightness_item)) {
-            targetState.level = static_cast<uint8_t>(std::clamp(brightness_item->valueint, 0, 254));
+        targetState.color_temp = command.color_temp;
+        targetState.rgb = command.rgb;
+        if (command.transition_ms.has_value()) {
+            // Fade time is a stored gear setting; changing it per command would wear the gear's memory
+            ESP_LOGD(TAG, "Ignoring transition of %lu ms, gear fade time applies", *command.transition_ms);
         }
 
-        cJSON *ct_item = cJSON_GetObjectItem(root, "color_temp");
-        if (ct_item && cJSON_IsNumber(ct_item)) {
-            targetState.color_temp = static_cast<uint16_t>(ct_item->valueint);
-        }
-
-        cJSON *color_item = cJSON_GetObjectItem(root, "color");
-        if (color_item && cJSON_IsObject(color_item)) {
-            cJSON *r = cJSON_GetObjectItem(color_item, "r");
-            cJSON *g = cJSON_GetObjectItem(color_item, "g");
-            cJSON *b = cJSON_GetObjectItem(color_item, "b");
-            if (cJSON_IsNumber(r) && cJSON_IsNumber(g) && cJSON_IsNumber(b)) {
-                targetState.rgb = DaliRGB{
-                    static_cast<uint8_t>(r->valueint),
-                    static_cast<uint8_t>(g->valueint),
-                    static_cast<uint8_t>(b->valueint)
-                };
-            }
-        }
         if (targetState.color_temp.has_value() || targetState.rgb.has_value()) {
             DaliPublishState stateUpdateForMode;
 
@@ -166,12 +167,9 @@ namespace daliMQTT {
                     }
                 }
                 else if (addr_type == DALI_ADDRESS_TYPE_GROUP) {
-                    auto all_assignments = DaliGroupManagement::Instance().getAllAssignments();
-                    for (const auto& [long_addr, groups] : all_assignments) {
-                        if (groups.test(target_id)) {
-                            controller.updateDeviceState(long_addr, stateUpdateForMode);
-                        }
-                    }
+                    DaliGroupManagement::Instance().forEachGroupMember(target_id, [&](const DaliLongAddress_t long_addr) {
+                        controller.updateDeviceState(long_addr, stateUpdateForMode);
+                    });
                 }
                 else if (addr_type == DALI_ADDRESS_TYPE_BROADCAST) {
                     auto devices = controller.getDevices();
@@ -238,12 +236,10 @@ namespace daliMQTT {
         } else if (targetState.color_temp.has_value() || targetState.rgb.has_value()) {
             publishLightState(addr_type, target_id, "ON", targetState);
         }
-
-        cJSON_Delete(root);
     }
 
-    void MQTTCommandHandler::handleGroupCommand(const std::string &data) {
-        cJSON *root = cJSON_Parse(data.c_str());
+    void MQTTCommandHandler::handleGroupCommand(const std::string_view data) {
+        cJSON *root = cJSON_ParseWithLength(data.data(), data.size());
         if (!root) {
             ESP_LOGE(TAG, "Failed to parse group command JSON");
             return;
@@ -267,9 +263,9 @@ namespace daliMQTT {
 
         DaliGroupManagement::Instance().setGroupMembership(*long_addr_opt, group, assign);
 
-        auto config = ConfigManager::Instance().getConfig();
+        const auto config = ConfigManager::Instance().getSnapshot();
         auto const &mqtt = MQTTClient::Instance();
-        std::string result_topic = utils::stringFormat("%s%s", config.mqtt_base_topic.c_str(),
+        std::string result_topic = utils::stringFormat("%s%s", config->mqtt_base_topic.c_str(),
                                                        CONFIG_DALI2MQTT_MQTT_GROUP_RES_SUBTOPIC);
         std::string payload = utils::stringFormat(R"({"status":"success","device":"%s","group":%d,"action":"%s"})",
                                                   addr_item->valuestring, group, (assign ? "added" : "removed"));
@@ -278,8 +274,8 @@ namespace daliMQTT {
         cJSON_Delete(root);
     }
 
-    void MQTTCommandHandler::handleSceneCommand(const std::string &data) {
-        cJSON *root = cJSON_Parse(data.c_str());
+    void MQTTCommandHandler::handleSceneCommand(const std::string_view data) {
+        cJSON *root = cJSON_ParseWithLength(data.data(), data.size());
         if (!root) {
             ESP_LOGE(TAG, "Failed to parse scene command JSON");
             return;
@@ -297,12 +293,161 @@ namespace daliMQTT {
         cJSON_Delete(root);
     }
 
-    void MQTTCommandHandler::processSendDALICommand(const std::string &data) {
-        cJSON *root = cJSON_Parse(data.c_str());
+    std::optional<RawFrame> MQTTCommandHandler::parseRawFrame(const cJSON* item) {
+        RawFrame frame;
+        if (cJSON_IsString(item) && item->valuestring != nullptr) {
+            // Compact form: the whole frame as 4 or 6 hex digits, e.g. "FF90"
+            const std::string_view hex(item->valuestring);
+            if (hex.size() != 4 && hex.size() != 6) return std::nullopt;
+            const auto [ptr, ec] = std::from_chars(hex.data(), hex.data() + hex.size(), frame.data, 16);
+            if (ec != std::errc() || ptr != hex.data() + hex.size()) return std::nullopt;
+            frame.bits = hex.size() == 6 ? 24 : 16;
+            return frame;
+        }
+        if (!cJSON_IsObject(item)) return std::nullopt;
+
+        const cJSON* addr_item = cJSON_GetObjectItem(item, "addr");
+        const cJSON* cmd_item = cJSON_GetObjectItem(item, "cmd");
+        if (!cJSON_IsNumber(addr_item) || !cJSON_IsNumber(cmd_item)) return std::nullopt;
+        const auto addr_val = static_cast<uint32_t>(addr_item->valueint);
+        const auto cmd_val = static_cast<uint32_t>(cmd_item->valueint);
+
+        const cJSON* bits_item = cJSON_GetObjectItem(item, "bits");
+        frame.bits = cJSON_IsNumber(bits_item) ? static_cast<uint8_t>(bits_item->valueint) : (addr_val > 0xFF ? 24 : 16);
+        if (frame.bits != 16 && frame.bits != 24) return std::nullopt;
+        frame.data = frame.bits == 24 ? ((addr_val & 0xFFFF) << 8) | (cmd_val & 0xFF)
+                                      : ((addr_val & 0xFF) << 8) | (cmd_val & 0xFF);
+
+        frame.twice = cJSON_IsTrue(cJSON_GetObjectItem(item, "twice"));
+        frame.reply = cJSON_IsTrue(cJSON_GetObjectItem(item, "reply"));
+        if (const cJSON* settle_item = cJSON_GetObjectItem(item, "settle_ms"); cJSON_IsNumber(settle_item)) {
+            frame.settle_ms = static_cast<uint16_t>(std::clamp(settle_item->valueint, 0, MAX_SETTLE_MS));
+        }
+        return frame;
+    }
+
+    void MQTTCommandHandler::publishCommandReply(const MessageProperties& properties, cJSON* response_root) {
+        char* payload = cJSON_PrintUnformatted(response_root);
+        cJSON_Delete(response_root);
+        if (!payload) return;
+
+        auto const &mqtt = MQTTClient::Instance();
+        const PublishProperties publish_properties{properties.correlation_data, TRANSIENT_MESSAGE_EXPIRY_S};
+        if (!properties.response_topic.empty()) {
+            mqtt.publish(std::string(properties.response_topic), payload, 0, false, publish_properties);
+        } else {
+            mqtt.publish(ConfigManager::Instance().getMqttBaseTopic() + "/cmd/res", payload, 0, false, publish_properties);
+        }
+        free(payload);
+    }
+
+    void MQTTCommandHandler::processSendDALIBatch(const cJSON* frames_item, const cJSON* tag_item,
+                                                  const MessageProperties& properties) {
+        const int count = cJSON_GetArraySize(frames_item);
+        const bool wants_reply = tag_item != nullptr || !properties.response_topic.empty();
+
+        const auto reply_error = [&](const char* status, const int index) {
+            ESP_LOGW(TAG, "Rejected raw frame batch: %s at frame %d", status, index);
+            if (!wants_reply) return;
+            cJSON* response_root = cJSON_CreateObject();
+            if (tag_item) cJSON_AddItemToObject(response_root, "tag", cJSON_Duplicate(tag_item, 1));
+            cJSON_AddStringToObject(response_root, "status", status);
+            cJSON_AddNumberToObject(response_root, "index", index);
+            publishCommandReply(properties, response_root);
+        };
+
+        if (count <= 0) {
+            reply_error("no_frames", 0);
+            return;
+        }
+        if (count > MAX_BATCH_FRAMES) {
+            reply_error("too_many_frames", count);
+            return;
+        }
+
+        // Validate everything first, so a bad frame never leaves the gear half configured
+        std::vector<RawFrame> frames;
+        frames.reserve(count);
+        int index = 0;
+        uint32_t worst_case_ms = 0;
+        const cJSON* frame_item = nullptr;
+        cJSON_ArrayForEach(frame_item, frames_item) {
+            const auto frame = parseRawFrame(frame_item);
+            if (!frame) {
+                reply_error("invalid_frame", index);
+                return;
+            }
+            worst_case_ms += frame->worstCaseBusMs();
+            if (worst_case_ms > MAX_BATCH_BUS_MS) {
+                reply_error("batch_too_long", index);
+                return;
+            }
+            frames.push_back(*frame);
+            ++index;
+        }
+
+        std::vector<RawFrameResult> results;
+        results.reserve(frames.size());
+
+        auto& dali = DaliAdapter::Instance();
+        const int64_t batch_start_us = esp_timer_get_time();
+        {
+            // One reservation for the whole batch: no light command or poll can slip in between frames
+            const auto reservation = dali.reserveBus();
+            for (const auto& frame : frames) {
+                const int64_t frame_start_us = esp_timer_get_time();
+                std::optional<uint8_t> response = dali.sendRaw(frame.data, frame.bits, frame.reply);
+                if (frame.twice) {
+                    if (auto second = dali.sendRaw(frame.data, frame.bits, frame.reply); second.has_value()) {
+                        response = second;
+                    }
+                }
+                if (frame.settle_ms > 0) {
+                    vTaskDelay(pdMS_TO_TICKS(frame.settle_ms));
+                }
+                results.push_back({response, frame.reply, static_cast<uint32_t>(esp_timer_get_time() - frame_start_us)});
+            }
+        }
+        const auto batch_us = static_cast<uint32_t>(esp_timer_get_time() - batch_start_us);
+        ESP_LOGD(TAG, "Raw frame batch: %u frames in %lu us", static_cast<unsigned>(frames.size()), batch_us);
+
+        if (!wants_reply) return;
+        publishCommandReply(properties, buildBatchReply(tag_item, results, batch_us));
+    }
+
+    cJSON* MQTTCommandHandler::buildBatchReply(const cJSON* tag_item, const std::vector<RawFrameResult>& results,
+                                               const uint32_t total_us) {
+        cJSON* response_root = cJSON_CreateObject();
+        if (tag_item) cJSON_AddItemToObject(response_root, "tag", cJSON_Duplicate(tag_item, 1));
+        cJSON_AddStringToObject(response_root, "status", "ok");
+        cJSON_AddNumberToObject(response_root, "count", static_cast<double>(results.size()));
+        cJSON_AddNumberToObject(response_root, "total_us", total_us);
+        // Parallel arrays: an object per frame would not fit the outbox for large batches
+        cJSON* us_array = cJSON_AddArrayToObject(response_root, "us");
+        cJSON* responses_array = cJSON_AddArrayToObject(response_root, "responses");
+        for (const auto& result : results) {
+            cJSON_AddItemToArray(us_array, cJSON_CreateNumber(std::min(result.duration_us, MAX_REPORTED_FRAME_US)));
+            if (!result.reply) {
+                cJSON_AddItemToArray(responses_array, cJSON_CreateNull());
+            } else {
+                cJSON_AddItemToArray(responses_array, cJSON_CreateNumber(result.response.has_value() ? *result.response : -1));
+            }
+        }
+        return response_root;
+    }
+
+    void MQTTCommandHandler::processSendDALICommand(const std::string_view data, const MessageProperties& properties) {
+        cJSON *root = cJSON_ParseWithLength(data.data(), data.size());
         if (!root) {
             return;
         }
 
+        if (const cJSON* frames_item = cJSON_GetObjectItem(root, "frames"); cJSON_IsArray(frames_item)) {
+            processSendDALIBatch(frames_item, cJSON_GetObjectItem(root, "tag"), properties);
+            cJSON_Delete(root);
+            return;
+        }
+
         cJSON *addr_item = cJSON_GetObjectItem(root, "addr");
         cJSON *cmd_item = cJSON_GetObjectItem(root, "cmd");
         cJSON *repeat_item = cJSON_GetObjectItem(root, "twice");
@@ -330,7 +475,7 @@ namespace daliMQTT {
             }
 
             const bool repeat = cJSON_IsTrue(repeat_item);
-            bool check_reply = (tag_item != nullptr);
+            const bool check_reply = tag_item != nullptr || !properties.response_topic.empty();
             std::optional<uint8_t> result;
 
             result = DaliAdapter::Instance().sendRaw(raw_data, bits, check_reply);
@@ -340,12 +485,8 @@ namespace daliMQTT {
             }
 
             if (check_reply) {
-                auto const &mqtt = MQTTClient::Instance();
-                auto config_base = ConfigManager::Instance().getMqttBaseTopic();
-                std::string reply_topic = utils::stringFormat("%s/cmd/res", config_base.c_str());
-
                 cJSON* response_root = cJSON_CreateObject();
-                cJSON_AddItemToObject(response_root, "tag", cJSON_Duplicate(tag_item, 1));
+                if (tag_item) cJSON_AddItemToObject(response_root, "tag", cJSON_Duplicate(tag_item, 1));
                 cJSON_AddNumberToObject(response_root, "addr", addr_val);
                 cJSON_AddNumberToObject(response_root, "cmd", cmd_val);
 
@@ -363,20 +504,14 @@ namespace daliMQTT {
                     cJSON_AddStringToObject(response_root, "status", "no_reply");
                     ESP_LOGD(TAG, "Command: No reply (timed out)");
                 }
-
-                char* payload = cJSON_PrintUnformatted(response_root);
-                if (payload) {
-                    mqtt.publish(reply_topic, payload, 0, false);
-                    free(payload);
-                }
-                cJSON_Delete(response_root);
+                publishCommandReply(properties, response_root);
             }
         }
         cJSON_Delete(root);
     }
 
-    void MQTTCommandHandler::handleSyncCommand(const std::string& data) {
-        cJSON* root = cJSON_Parse(data.c_str());
+    void MQTTCommandHandler::handleSyncCommand(const std::string_view data, const MessageProperties& properties) {
+        cJSON* root = cJSON_ParseWithLength(data.data(), data.size());
         if (!root) {
             ESP_LOGE(TAG, "Failed to parse sync command JSON");
             return;
@@ -400,6 +535,7 @@ namespace daliMQTT {
         }
 
         auto& controller = DaliDeviceController::Instance();
+        const char* status = "scheduled";
 
         if (is_broadcast) {
             uint32_t stagger = 100;
@@ -418,15 +554,25 @@ namespace daliMQTT {
                         controller.requestDeviceSync(*short_addr_opt, delay_ms);
                     } else {
                          ESP_LOGD(TAG, "Sync requested for unknown device long address: %s", addr_str.c_str());
+                         status = "unknown_device";
                     }
                 } else {
                     ESP_LOGD(TAG, "Invalid address format in sync command: %s", addr_str.c_str());
+                    status = "invalid_address";
                 }
             } else {
                 ESP_LOGD(TAG, "Sync command missing 'addr' field for device sync");
+                status = "invalid_address";
             }
         }
 
+        // Only MQTT 5 requesters get a reply; cmd/sync never answered on cmd/res
+        if (!properties.response_topic.empty()) {
+            cJSON* response_root = cJSON_CreateObject();
+            cJSON_AddStringToObject(response_root, "status", status);
+            publishCommandReply(properties, response_root);
+        }
+
         cJSON_Delete(root);
     }
 
@@ -443,8 +589,9 @@ namespace daliMQTT {
         cJSON_Delete(root);
     }
 
-    void MQTTCommandHandler::handleConfigSet(const std::string& data) {
-        ConfigUpdateResult result = ConfigManager::Instance().updateConfigFromJson(data.c_str());
+    void MQTTCommandHandler::handleConfigSet(const std::string_view data) {
+        const std::string json(data);
+        ConfigUpdateResult result = ConfigManager::Instance().updateConfigFromJson(json.c_str());
 
         auto const &mqtt = MQTTClient::Instance();
         std::string status_topic = ConfigManager::Instance().getMqttBaseTopic() + "/config/status";
@@ -478,8 +625,8 @@ namespace daliMQTT {
     void MQTTCommandHandler::backgroundScanTask(void* arg) {
         ESP_LOGI(TAG, "Starting MQTT-initiated DALI scan...");
         auto const& mqtt = MQTTClient::Instance();
-        auto config = ConfigManager::Instance().getConfig();
-        std::string status_topic = config.mqtt_base_topic + "/config/bus/sync_status";
+        const auto config = ConfigManager::Instance().getSnapshot();
+        std::string status_topic = config->mqtt_base_topic + "/config/bus/sync_status";
 
         mqtt.publish(status_topic, R"({"status":"scanning"})", 0, false);
 
@@ -496,8 +643,8 @@ namespace daliMQTT {
     void MQTTCommandHandler::backgroundInitTask(void* arg) {
         ESP_LOGI(TAG, "Starting MQTT-initiated DALI initialization...");
         auto const& mqtt = MQTTClient::Instance();
-        auto config = ConfigManager::Instance().getConfig();
-        std::string status_topic = config.mqtt_base_topic + "/config/bus/sync_status";
+        const auto config = ConfigManager::Instance().getSnapshot();
+        std::string status_topic = config->mqtt_base_topic + "/config/bus/sync_status";
 
         mqtt.publish(status_topic, R"({"status":"initializing"})", 0, false);
 
@@ -512,8 +659,8 @@ namespace daliMQTT {
     void MQTTCommandHandler::backgroundInputInitTask(void* arg) {
         ESP_LOGI(TAG, "Starting MQTT-initiated DALI Input Device initialization...");
         auto const& mqtt = MQTTClient::Instance();
-        auto config = ConfigManager::Instance().getConfig();
-        std::string status_topic = config.mqtt_base_topic + "/config/input_device/sync_status";
+        const auto config = ConfigManager::Instance().getSnapshot();
+        std::string status_topic = config->mqtt_base_topic + "/config/input_device/sync_status";
 
         mqtt.publish(status_topic, R"({"status":"initializing"})", 0, false);
 
@@ -535,6 +682,16 @@ namespace daliMQTT {
             g_mqtt_bus_busy = false;
         }
     }
+    void MQTTCommandHandler::handleInputInitializeCommand() {
+        if (g_mqtt_bus_busy.exchange(true)) {
+            ESP_LOGW(TAG, "Bus operation already in progress. Ignoring input init request.");
+            return;
+        }
+        if (xTaskCreate(backgroundInputInitTask, "mqtt_input_init", 4096, nullptr, 4, nullptr) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create input init task");
+            g_mqtt_bus_busy = false;
+        }
+    }
     void MQTTCommandHandler::handleInitializeCommand() {
         if (g_mqtt_bus_busy.exchange(true)) {
             ESP_LOGW(TAG, "Bus operation already in progress. Ignoring init request.");
@@ -545,74 +702,115 @@ namespace daliMQTT {
             g_mqtt_bus_busy = false;
         }
     }
-    void MQTTCommandHandler::handle(const std::string &topic, const std::string &data) {
-        ESP_LOGD(TAG, "MQTT Rx: %s -> %s", topic.c_str(), data.c_str());
+    void MQTTCommandHandler::handleSceneSet(const std::string_view data) {
+        // HASS Scene Select
+        if (data.starts_with("Scene ")) {
+            const std::string_view scene_str = data.substr(6); // "Scene "
+            int scene_id = -1;
+            const auto [ptr, ec] = std::from_chars(scene_str.data(), scene_str.data() + scene_str.size(), scene_id);
+            if (ec != std::errc() || scene_id < 0 || scene_id > 15) {
+                ESP_LOGW(TAG, "Invalid scene selection received");
+                return;
+            }
+            DaliSceneManagement::Instance().activateScene(scene_id);
+        } else {
+            handleSceneCommand(data);
+        }
+    }
 
-        const auto config = ConfigManager::Instance().getConfig();
-        std::string_view topic_sv(topic);
+    const MQTTTopicRouter& MQTTCommandHandler::router() {
+        static const MQTTTopicRouter instance = [] {
+            constexpr auto LIGHT = static_cast<uint8_t>(CommandClass::Light);
+            constexpr auto BUS = static_cast<uint8_t>(CommandClass::Bus);
+            constexpr auto CONTROL = static_cast<uint8_t>(CommandClass::Control);
+
+            MQTTTopicRouter r;
+            r.add("light/{long}/set", [](const RouteParams& params, const std::string_view data) {
+                const auto short_addr_opt = DaliDeviceController::Instance().getShortAddress(params.long_addr);
+                if (!short_addr_opt) {
+                    ESP_LOGD(TAG, "Received command for unknown long address: %s", utils::longAddressToString(params.long_addr).data());
+                    return;
+                }
+                handleLightCommand(DALI_ADDRESS_TYPE_SHORT, *short_addr_opt, data);
+            }, LIGHT);
+            r.add("light/group/{group}/set", [](const RouteParams& params, const std::string_view data) {
+                handleLightCommand(DALI_ADDRESS_TYPE_GROUP, params.group_id, data);
+            }, LIGHT);
+            r.add("light/broadcast/set", [](const RouteParams&, const std::string_view data) {
+                handleLightCommand(DALI_ADDRESS_TYPE_BROADCAST, 0, data);
+            }, LIGHT);
+            r.add(CONFIG_DALI2MQTT_MQTT_SCENE_CMD_SUBTOPIC, [](const RouteParams&, const std::string_view data) {
+                // Held light commands must not be overtaken by the scene
+                MQTTCommandProcess::Instance().flushLightCommands();
+                handleSceneSet(data);
+            }, static_cast<uint8_t>(LIGHT | ROUTE_NOT_DROPPABLE));
+
+            r.add(CONFIG_DALI2MQTT_MQTT_GROUP_SET_SUBTOPIC, [](const RouteParams&, const std::string_view data) {
+                handleGroupCommand(data);
+            }, BUS);
+            r.add("cmd/send", [](const RouteParams& params, const std::string_view data) {
+                processSendDALICommand(data, params.properties);
+            }, BUS);
+            r.add("config/bus/scan", [](const RouteParams&, std::string_view) { handleScanCommand(); }, BUS);
+            r.add("config/bus/initialize", [](const RouteParams&, std::string_view) { handleInitializeCommand(); }, BUS);
+            r.add("config/input_device/scan", [](const RouteParams&, std::string_view) { handleScanCommand(); }, BUS);
+            r.add("config/input_device/initialize", [](const RouteParams&, std::string_view) { handleInputInitializeCommand(); }, BUS);
+
+            r.add("cmd/sync", [](const RouteParams& params, const std::string_view data) {
+                handleSyncCommand(data, params.properties);
+            }, CONTROL);
+            r.add("config/get", [](const RouteParams&, std::string_view) { handleConfigGet(); }, CONTROL);
+            r.add("config/set", [](const RouteParams&, const std::string_view data) { handleConfigSet(data); }, CONTROL);
+            r.add("config/discovery/publish", [](const RouteParams&, std::string_view) {
+                AppController::Instance().publishHAMqttDiscovery(true);
+            }, CONTROL);
+            r.add("cmd/resync", [](const RouteParams&, std::string_view) {
+                AppController::Instance().resyncBroker(true);
+            }, CONTROL);
+            return r;
+        }();
+        return instance;
+    }
 
-        if (!topic_sv.starts_with(config.mqtt_base_topic)) return;
-        topic_sv.remove_prefix(config.mqtt_base_topic.length());
+    /** Part of the topic below the base topic, or nullopt if the topic is outside it. */
+    static std::optional<std::string_view> commandTopic(const std::string_view topic, const std::string_view base_topic) {
+        if (!topic.starts_with(base_topic)) return std::nullopt;
+        const std::string_view command_topic = topic.substr(base_topic.length());
+        // Levels must start right after the base topic, "base2/..." is not ours
+        if (!command_topic.empty() && command_topic.front() != '/') return std::nullopt;
+        return command_topic;
+    }
 
-        std::vector<std::string_view> parts;
-        for (const auto part: std::views::split(topic_sv, '/')) {
-            if (!part.empty()) parts.emplace_back(part.begin(), part.end());
-        }
+    std::optional<CommandRoute> MQTTCommandHandler::classify(const std::string_view topic) {
+        const auto config = ConfigManager::Instance().getSnapshot();
+        const auto command_topic = commandTopic(topic, config->mqtt_base_topic);
+        // Foreign topics such as homeassistant/status are handled on the control worker
+        if (!command_topic) return CommandRoute{CommandClass::Control};
+
+        const auto tag = router().tagOf(*command_topic);
+        if (!tag) return std::nullopt;
+        return CommandRoute{
+            .command_class = static_cast<CommandClass>(*tag & ~ROUTE_NOT_DROPPABLE),
+            .droppable = (*tag & ROUTE_NOT_DROPPABLE) == 0,
+        };
+    }
 
-        if (parts.empty()) return;
+    void MQTTCommandHandler::handle(const std::string_view topic, const std::string_view data,
+                                    const MessageProperties& properties) {
+        ESP_LOGD(TAG, "MQTT Rx: %.*s -> %.*s", static_cast<int>(topic.size()), topic.data(),
+                 static_cast<int>(data.size()), data.data());
 
-        if (parts[0] == "light") {
-            handleLightCommand(parts, data);
-        } else if (parts[0] == "config") {
-            if (parts.size() == 2) {
-                if (parts[1] == "get") {
-                    handleConfigGet();
-                } else if (parts[1] == "set") {
-                    handleConfigSet(data);
-                }
-            } else if (parts.size() > 2 && parts[1] == "group" && parts[2] == "set") {
-                handleGroupCommand(data);
-            }
-            else if (parts.size() > 2 && parts[1] == "bus") {
-                if (parts[2] == "scan") {
-                    handleScanCommand();
-                } else if (parts[2] == "initialize") {
-                    handleInitializeCommand();
-                }
-            }
-            else if (parts.size() > 2 && parts[1] == "input_device") {
-                if (parts[2] == "scan") {
-                    handleScanCommand();
-                } else if (parts[2] == "initialize") {
-                    if (g_mqtt_bus_busy.exchange(true)) {
-                        ESP_LOGW(TAG, "Bus operation already in progress. Ignoring input init request.");
-                        return;
-                    }
-                    if (xTaskCreate(backgroundInputInitTask, "mqtt_input_init", 4096, nullptr, 4, nullptr) != pdPASS) {
-                        ESP_LOGE(TAG, "Failed to create input init task");
-                        g_mqtt_bus_busy = false;
-                    }
-                }
-            } else if (parts[0] == "config" && parts.size() > 1 && parts[1] == "discovery") {
-                if (parts.size() > 2 && parts[2] == "publish") {
-                    AppController::Instance().publishHAMqttDiscovery();
-                }
-            }
-        } else if (parts[0] == "scene" && parts.size() > 1 && parts[1] == "set") {
-            std::string scene_str = data;
-            // HASS Scene Select
-            if (scene_str.starts_with("Scene ")) {
-                scene_str.erase(0, 6); // "Scene "
-                int scene_id = std::stoi(scene_str);
-                DaliSceneManagement::Instance().activateScene(scene_id);
-            } else {
-                handleSceneCommand(data);
+        const auto config = ConfigManager::Instance().getSnapshot();
+
+        if (topic == HA_STATUS_TOPIC) {
+            if (data == "online" && config->hass_discovery_enabled) {
+                AppController::Instance().publishHAMqttDiscovery(true);
             }
-        } else if (parts[0] == "cmd" && parts.size() > 1 && parts[1] == "send") {
-            processSendDALICommand(data);
-        } else if (parts[0] == "cmd" && parts.size() > 1 && parts[1] == "sync") {
-            handleSyncCommand(data);
+            return;
         }
 
+        if (const auto command_topic = commandTopic(topic, config->mqtt_base_topic)) {
+            router().dispatch(*command_topic, data, properties);
+        }
     }
 } // namespace daliMQTT
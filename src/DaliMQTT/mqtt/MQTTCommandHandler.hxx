@@ -2,36 +2,176 @@
 #define DALIMQTT_MQTTCOMMANDHANDLER_HXX
 
 #include "dali/DaliAdapter.hxx"
+#include "mqtt/MQTTTopicRouter.hxx"
 
 namespace daliMQTT {
 
+    /** Home Assistant JSON schema light command. */
+    struct LightCommand {
+        std::optional<bool> on;
+        std::optional<uint8_t> level;           // "brightness", mapped to an arc level per target on execution
+        std::optional<uint16_t> color_temp;
+        std::optional<DaliRGB> rgb;
+        std::optional<uint32_t> transition_ms;
+
+        /** Applies a newer command for the same target on top of this one, last write wins per field. */
+        void merge(const LightCommand& newer) {
+            if (newer.on.has_value()) {
+                on = newer.on;
+                // OFF drops any earlier level; ON alone keeps it
+                if (!*newer.on) level.reset();
+            }
+            if (newer.level.has_value()) {
+                level = newer.level;
+                // A bare level is a level change of its own, not a modifier of an earlier ON/OFF
+                if (!newer.on.has_value()) on.reset();
+            }
+            // Only the newest colour mode is applied
+            if (newer.color_temp.has_value()) {
+                color_temp = newer.color_temp;
+                rgb.reset();
+            }
+            if (newer.rgb.has_value()) {
+                rgb = newer.rgb;
+                color_temp.reset();
+            }
+            if (newer.transition_ms.has_value()) transition_ms = newer.transition_ms;
+        }
+
+        /**
+         * Drops the fields a newer command for a wider target (group or broadcast) overrides,
+         * using the same rules as merge(). Returns false when nothing is left to execute.
+         */
+        bool dropOverridden(const LightCommand& newer) {
+            if (newer.on.has_value()) {
+                on.reset();
+                if (!*newer.on) level.reset();
+            }
+            if (newer.level.has_value()) {
+                level.reset();
+                if (!newer.on.has_value()) on.reset();
+            }
+            if (newer.color_temp.has_value() || newer.rgb.has_value()) {
+                color_temp.reset();
+                rgb.reset();
+            }
+            return on.has_value() || level.has_value() || color_temp.has_value() || rgb.has_value();
+        }
+    };
+
+    /** One raw frame of a cmd/send batch. */
+    struct RawFrame {
+        uint32_t data{0};
+        uint8_t bits{16};
+        bool twice{false};
+        bool reply{false};
+        uint16_t settle_ms{0};      // Extra wait after the frame, e.g. for gear writing to memory
+
+        // Forward frame, reply window and inter-frame delay, rounded up
+        static constexpr uint32_t FRAME_WORST_CASE_MS = 50;
+
+        /** Longest time the frame can hold the bus, settle time included. */
+        [[nodiscard]] constexpr uint32_t worstCaseBusMs() const {
+            return (twice ? 2 : 1) * FRAME_WORST_CASE_MS + settle_ms;
+        }
+    };
+
+    /** Outcome of one frame of a cmd/send batch. */
+    struct RawFrameResult {
+        std::optional<uint8_t> response;
+        bool reply{false};          // A backward frame was waited for
+        uint32_t duration_us{0};
+    };
+
+    /** Which command worker runs a topic. */
+    enum class CommandClass : uint8_t {
+        Light,      // Real-time light control
+        Bus,        // Bus management and raw frames
+        Control     // Commands that do not touch the bus
+    };
+
+    /** Worker of a topic and whether a full queue may drop it. */
+    struct CommandRoute {
+        CommandClass command_class;
+        bool droppable{true};       // A later command supersedes it
+    };
+
     class MQTTCommandHandler {
     public:
         MQTTCommandHandler() = delete;
         /**
          * @brief Main handler for incoming MQTT messages.
+         * Topic and payload are views into the receive ring buffer and are only valid during the call.
          * @param topic
          * @param data
+         * @param properties MQTT 5 response topic and correlation data of the message, if any.
          */
-        static void handle(const std::string& topic, const std::string& data);
+        static void handle(std::string_view topic, std::string_view data, const MessageProperties& properties = {});
+
+        /**
+         * @brief Worker class of a topic, without handling it.
+         * @return nullopt for topics below the base topic that no command route matches.
+         */
+        static std::optional<CommandRoute> classify(std::string_view topic);
+
+        /** Subscription filters for all command topics. */
+        static std::vector<std::string> subscriptionFilters(std::string_view base_topic) {
+            return router().subscriptionFilters(base_topic);
+        }
+
+        /** Sends a (possibly merged) light command to the bus and publishes the resulting state. */
+        static void executeLightCommand(dali_addressType_t addr_type, uint8_t target_id, const LightCommand& command);
+
+        /** Parses a light command payload without allocating. Returns nullopt for malformed JSON. */
+        static std::optional<LightCommand> parseLightCommand(std::string_view data);
+
+        /** Parses one cmd/send batch frame, a hex string or an object. Returns nullopt if it is invalid. */
+        static std::optional<RawFrame> parseRawFrame(const cJSON* item);
+
+        /**
+         * @brief Builds the reply to an executed cmd/send batch, with per-frame results as parallel arrays.
+         * Durations are capped at 7 digits, so a full batch stays below MAX_BATCH_REPLY_SIZE.
+         */
+        static cJSON* buildBatchReply(const cJSON* tag_item, const std::vector<RawFrameResult>& results, uint32_t total_us);
+
+        static constexpr int MAX_BATCH_FRAMES = 256;
+        // A reply goes through the outbox, whose NOSPLIT items are limited to about half its size;
+        // the rest of that half is kept for the item header, topic and correlation data
+        static constexpr size_t MAX_BATCH_REPLY_SIZE = CONFIG_DALI2MQTT_MQTT_OUTBOX_SIZE / 2 - 256;
+        static constexpr uint32_t MAX_REPORTED_FRAME_US = 9999999;
+        static constexpr int MAX_SETTLE_MS = 1000;
+        // Worst-case time one batch may hold the bus; light commands and polls wait meanwhile
+        static constexpr uint32_t MAX_BATCH_BUS_MS = 15000;
     private:
+
+        /** Command routes below the base topic, built on first use. */
+        static const MQTTTopicRouter& router();
+
         /** MQTT command handlers */
-        static void handleLightCommand(const std::vector<std::string_view>& parts, const std::string& data);
-        static void handleGroupCommand(const std::string& data);
-        static void handleSceneCommand(const std::string& data);
-        static void processSendDALICommand(const std::string& data);
-        static void handleSyncCommand(const std::string& data);
+        static void handleLightCommand(dali_addressType_t addr_type, uint8_t target_id, std::string_view data);
+        static void handleGroupCommand(std::string_view data);
+        static void handleSceneCommand(std::string_view data);
+        static void handleSceneSet(std::string_view data);
+        static void processSendDALICommand(std::string_view data, const MessageProperties& properties);
+        static void processSendDALIBatch(const cJSON* frames_item, const cJSON* tag_item, const MessageProperties& properties);
+        static void handleSyncCommand(std::string_view data, const MessageProperties& properties);
+        /**
+         * @brief Publishes and frees the reply to a cmd/send or cmd/sync request.
+         * Goes to the request's MQTT 5 response topic with its correlation data, otherwise to base/cmd/res.
+         */
+        static void publishCommandReply(const MessageProperties& properties, cJSON* response_root);
         static void handleScanCommand();
         static void handleInitializeCommand();
+        static void handleInputInitializeCommand();
         static void handleConfigGet();
-        static void handleConfigSet(const std::string& data);
+        static void handleConfigSet(std::string_view data);
         // Background tasks
         static void backgroundScanTask(void* arg);
         static void backgroundInitTask(void* arg);
         static void backgroundInputInitTask(void* arg);
 
         // Publishing Light state
-        static void publishLightState(dali_addressType_t addr_type, uint8_t target_id, const std::string& state_str, const DaliPublishState& state_data);
+        static void publishLightState(dali_addressType_t addr_type, uint8_t target_id, std::string_view state_str, const DaliPublishState& state_data);
     };
 
 } // namespace daliMQTT
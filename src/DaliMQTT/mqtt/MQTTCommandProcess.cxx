@@ -1,71 +1,340 @@
 #include "mqtt/MQTTCommandProcess.hxx"
 #include "mqtt/MQTTCommandHandler.hxx"
+#include "mqtt/MQTTClient.hxx"
+#include "dali/DaliGroupManagement.hxx"
+#include "system/ConfigManager.hxx"
+#include "utils/JsonWriter.hxx"
+#include <esp_timer.h>
 
 namespace daliMQTT {
     static constexpr char TAG[] = "MQTTCommandProcess";
-    static constexpr size_t RING_BUFFER_SIZE = 12 * 1024;
+    static constexpr uint32_t COMMAND_DEADLINE_MS = CONFIG_DALI2MQTT_MQTT_COMMAND_DEADLINE_MS;
+    static constexpr char QUEUES_SUBTOPIC[] = "/bridge/queues";
+    static constexpr std::array<const char*, 3> QUEUE_NAMES = {"light", "bus", "control"};
 
     struct RingBufHeader {
+        uint32_t received_ms;
         uint16_t topic_len;
         uint16_t payload_len;
+        // MQTT 5 request properties, stored after the payload
+        uint16_t response_topic_len;
+        uint16_t correlation_len;
+        uint32_t sequence;          // Enqueue order within the queue
+        bool droppable;
+
+        [[nodiscard]] size_t itemSize() const {
+            return sizeof(RingBufHeader) + topic_len + payload_len + response_topic_len + correlation_len;
+        }
     };
 
     void MQTTCommandProcess::init() {
-        if (m_ringbuf) return;
-        m_ringbuf = xRingbufferCreate(RING_BUFFER_SIZE, RINGBUF_TYPE_NOSPLIT);
-        if (m_ringbuf == nullptr) {
-            ESP_LOGE(TAG, "Failed to create Ring Buffer.");
-            return;
+        for (auto& queue : m_queues) {
+            if (queue.ringbuf) continue;
+            queue.ringbuf = xRingbufferCreate(queue.size, RINGBUF_TYPE_NOSPLIT);
+            if (queue.ringbuf == nullptr) {
+                ESP_LOGE(TAG, "Failed to create Ring Buffer for %s.", queue.task_name);
+                continue;
+            }
+            xTaskCreate(WorkerTask, queue.task_name, 6144, &queue, queue.priority, nullptr);
         }
-        xTaskCreate(CommandProcessTask, "mqtt_cmd_task", 6144, this, 5, nullptr);
         ESP_LOGI(TAG, "DALI Command Processor started");
     }
 
-    bool MQTTCommandProcess::enqueueMqttMessage(const char* topic, const int topic_len, const char* data, const int data_len) const {
-        if (!m_ringbuf) return false;
+    bool MQTTCommandProcess::enqueueMqttMessage(const char* topic, const int topic_len, const char* data, const int data_len,
+                                                const MessageProperties& properties) {
+        const auto route = MQTTCommandHandler::classify(std::string_view(topic, topic_len));
+        if (!route) {
+            // E.g. our own state topics echoed back by a wildcard subscription
+            return false;
+        }
+
+        auto& queue = queueFor(route->command_class);
+        if (!queue.ringbuf) return false;
         constexpr size_t header_size = sizeof(RingBufHeader);
-        const size_t total_size = header_size + topic_len + data_len;
+        const size_t total_size = header_size + topic_len + data_len +
+                                  properties.response_topic.size() + properties.correlation_data.size();
         void* item_ptr = nullptr;
-        const esp_err_t sent = xRingbufferSendAcquire(m_ringbuf, &item_ptr, total_size, pdMS_TO_TICKS(10));
 
-        if (sent != ESP_OK) {
-            ESP_LOGW(TAG, "Ring Buffer busy/full, dropped message");
+        const TickType_t wait = queue.policy == DropPolicy::RejectNew ? pdMS_TO_TICKS(10) : 0;
+        BaseType_t sent = xRingbufferSendAcquire(queue.ringbuf, &item_ptr, total_size, wait);
+        // Only reached while one light command holds the bus, as the worker drains the queue between
+        // commands; make room by discarding the oldest messages, newer ones mostly supersede them
+        while (sent != pdTRUE && queue.policy == DropPolicy::DropOldest && total_size <= xRingbufferGetMaxItemSize(queue.ringbuf)) {
+            if (!evictOldest(queue)) break;
+            sent = xRingbufferSendAcquire(queue.ringbuf, &item_ptr, total_size, 0);
+        }
+
+        if (sent != pdTRUE) {
+            ++queue.dropped;
+            ESP_LOGW(TAG, "%s queue busy/full, dropped message", queue.task_name);
             return false;
         }
 
         auto* header = reinterpret_cast<RingBufHeader*>(item_ptr);
+        header->received_ms = static_cast<uint32_t>(esp_timer_get_time() / 1000);
         header->topic_len = static_cast<uint16_t>(topic_len);
         header->payload_len = static_cast<uint16_t>(data_len);
+        header->response_topic_len = static_cast<uint16_t>(properties.response_topic.size());
+        header->correlation_len = static_cast<uint16_t>(properties.correlation_data.size());
+        header->sequence = queue.next_sequence++;
+        header->droppable = route->droppable;
 
         char* data_start = static_cast<char*>(item_ptr) + header_size;
         memcpy(data_start, topic, topic_len);
-        memcpy(data_start + topic_len, data, data_len);
+        data_start += topic_len;
+        memcpy(data_start, data, data_len);
+        data_start += data_len;
+        memcpy(data_start, properties.response_topic.data(), properties.response_topic.size());
+        data_start += properties.response_topic.size();
+        memcpy(data_start, properties.correlation_data.data(), properties.correlation_data.size());
 
-        xRingbufferSendComplete(m_ringbuf, item_ptr);
+        xRingbufferSendComplete(queue.ringbuf, item_ptr);
 
         return true;
     }
 
-    [[noreturn]] void MQTTCommandProcess::CommandProcessTask(void* arg) {
-        const auto* self = static_cast<MQTTCommandProcess*>(arg);
+    CommandQueueStats MQTTCommandProcess::getStats(const CommandClass command_class) const {
+        const auto& queue = m_queues[static_cast<size_t>(command_class)];
+        CommandQueueStats stats;
+        stats.dropped = queue.dropped.load();
+        if (queue.ringbuf) {
+            const size_t free_size = xRingbufferGetCurFreeSize(queue.ringbuf);
+            stats.used_percent = static_cast<uint8_t>(100 - std::min<size_t>(free_size * 100 / queue.size, 100));
+        }
+        return stats;
+    }
+
+    void MQTTCommandProcess::publishStatsIfChanged() {
+        std::array<CommandQueueStats, 3> stats{};
+        bool congested = false;
+        bool changed = !m_stats_published;
+        for (size_t i = 0; i < stats.size(); ++i) {
+            stats[i] = getStats(static_cast<CommandClass>(i));
+            congested = congested || stats[i].used_percent >= CONGESTED_PERCENT;
+            changed = changed || stats[i].dropped != m_published_stats[i].dropped;
+        }
+        changed = changed || congested != m_published_congested;
+        if (!changed || MQTTClient::Instance().getStatus() != MqttStatus::CONNECTED) return;
+
+        utils::StaticJsonWriter<256> json;
+        json.beginObject().add("congested", congested);
+        for (size_t i = 0; i < stats.size(); ++i) {
+            json.beginObject(QUEUE_NAMES[i])
+                .add("used", stats[i].used_percent)
+                .add("dropped", stats[i].dropped)
+                .endObject();
+        }
+        json.endObject();
+        if (!json.ok()) return;
+
+        const auto config = ConfigManager::Instance().getSnapshot();
+        MQTTClient::Instance().publish(config->mqtt_base_topic + QUEUES_SUBTOPIC, json.view(), 0, true);
+        m_published_stats = stats;
+        m_published_congested = congested;
+        m_stats_published = true;
+    }
+
+    size_t MQTTCommandProcess::targetSlot(const dali_addressType_t addr_type, const uint8_t target_id) {
+        switch (addr_type) {
+            case DALI_ADDRESS_TYPE_SHORT: return target_id & 0x3F;
+            case DALI_ADDRESS_TYPE_GROUP: return 64 + (target_id & 0x0F);
+            default: return LIGHT_TARGETS - 1;
+        }
+    }
+
+    uint64_t MQTTCommandProcess::slotMembers(const size_t slot) {
+        if (slot < 64) return uint64_t{1} << slot;
+        if (slot < 64 + 16) return DaliGroupManagement::Instance().getGroupMembers(static_cast<uint8_t>(slot - 64));
+        return ~uint64_t{0};
+    }
+
+    void MQTTCommandProcess::queueLightCommand(const dali_addressType_t addr_type, const uint8_t target_id, const LightCommand& command) {
+        const size_t target = targetSlot(addr_type, target_id);
+        auto& pending = m_pending_lights[target];
+        const uint64_t members = slotMembers(target);
+
+        if (pending.used && target >= 64) {
+            // Merging moves the held command past everything queued since; if any of that reaches
+            // the same gear, its older fields would win, so execute what is held first
+            for (size_t slot = 0; slot < LIGHT_TARGETS; ++slot) {
+                const auto& other = m_pending_lights[slot];
+                if (slot != target && other.used && other.sequence > pending.sequence && (slotMembers(slot) & members) != 0) {
+                    flushLightCommands();
+                    break;
+                }
+            }
+        }
+
+        if (target >= 64) {
+            // Held commands of narrower targets inside this one run earlier; drop what this one overrides,
+            // so a later merge into their slot cannot bring the overridden values back
+            const size_t narrower_end = target == LIGHT_TARGETS - 1 ? LIGHT_TARGETS - 1 : 64;
+            for (size_t slot = 0; slot < narrower_end; ++slot) {
+                auto& other = m_pending_lights[slot];
+                if (!other.used || (slotMembers(slot) & ~members) != 0) continue;
+                if (!other.command.dropOverridden(command)) {
+                    other.used = false;
+                    --m_pending_count;
+                }
+            }
+        }
+
+        if (pending.used) {
+            pending.command.merge(command);
+            ESP_LOGD(TAG, "Merged superseded light command for target %u (type %d)", target_id, addr_type);
+        } else {
+            pending.command = command;
+            pending.used = true;
+            ++m_pending_count;
+        }
+        pending.received_ms = m_current_received_ms;
+        // Position of the newest message, so a merged command still runs after commands it overrode
+        pending.sequence = ++m_sequence;
+    }
+
+    bool MQTTCommandProcess::evictOldest(CommandQueue& queue) {
+        // Held from before the receive, so the worker cannot handle a newer message before seeing this one
+        std::lock_guard<std::mutex> lock(m_kept_mutex);
+        size_t item_size = 0;
+        void* oldest = xRingbufferReceive(queue.ringbuf, &item_size, 0);
+        if (!oldest) return false;
+        if (static_cast<const RingBufHeader*>(oldest)->droppable || m_kept_lights.size() >= MAX_KEPT_LIGHTS) {
+            ++queue.dropped;
+        } else {
+            const auto* bytes = static_cast<const uint8_t*>(oldest);
+            m_kept_lights.emplace_back(bytes, bytes + item_size);
+        }
+        vRingbufferReturnItem(queue.ringbuf, oldest);
+        return true;
+    }
+
+    void MQTTCommandProcess::handleKeptLights(const std::optional<uint32_t> before_sequence) {
+        while (true) {
+            std::vector<uint8_t> item;
+            {
+                std::lock_guard<std::mutex> lock(m_kept_mutex);
+                if (m_kept_lights.empty()) return;
+                const auto* header = reinterpret_cast<const RingBufHeader*>(m_kept_lights.front().data());
+                if (before_sequence && static_cast<int32_t>(header->sequence - *before_sequence) >= 0) return;
+                item = std::move(m_kept_lights.front());
+                m_kept_lights.erase(m_kept_lights.begin());
+            }
+            handleMessage(item.data(), item.size(), true);
+        }
+    }
+
+    void MQTTCommandProcess::drainLightQueue() {
+        auto& queue = queueFor(CommandClass::Light);
+        if (!queue.ringbuf) return;
+        size_t item_size = 0;
+        while (void* item = xRingbufferReceive(queue.ringbuf, &item_size, 0)) {
+            handleItem(queue, item, item_size);
+        }
+        // Set aside messages are older than anything still to come
+        handleKeptLights(std::nullopt);
+    }
+
+    void MQTTCommandProcess::drainAndFlushLightCommands() {
+        while (true) {
+            // Take what arrived during the previous bus command, so it merges instead of piling up in the queue
+            drainLightQueue();
+            if (m_pending_count == 0) break;
+            executeNextLightCommand();
+        }
+    }
+
+    void MQTTCommandProcess::flushLightCommands() {
+        while (m_pending_count > 0) {
+            executeNextLightCommand();
+        }
+    }
+
+    void MQTTCommandProcess::executeNextLightCommand() {
+        size_t next = LIGHT_TARGETS;
+        for (size_t slot = 0; slot < LIGHT_TARGETS; ++slot) {
+            if (m_pending_lights[slot].used && (next == LIGHT_TARGETS || m_pending_lights[slot].sequence < m_pending_lights[next].sequence)) {
+                next = slot;
+            }
+        }
+        auto& pending = m_pending_lights[next];
+        pending.used = false;
+        --m_pending_count;
+
+        dali_addressType_t addr_type = DALI_ADDRESS_TYPE_BROADCAST;
+        uint8_t target_id = 0;
+        if (next < 64) {
+            addr_type = DALI_ADDRESS_TYPE_SHORT;
+            target_id = static_cast<uint8_t>(next);
+        } else if (next < 64 + 16) {
+            addr_type = DALI_ADDRESS_TYPE_GROUP;
+            target_id = static_cast<uint8_t>(next - 64);
+        }
+
+        const uint32_t age_ms = static_cast<uint32_t>(esp_timer_get_time() / 1000) - pending.received_ms;
+        if (COMMAND_DEADLINE_MS > 0 && age_ms > COMMAND_DEADLINE_MS) {
+            ESP_LOGW(TAG, "Dropping light command for target %u (type %d), %lu ms old", target_id, addr_type, age_ms);
+            return;
+        }
+        MQTTCommandHandler::executeLightCommand(addr_type, target_id, pending.command);
+    }
+
+    void MQTTCommandProcess::handleItem(const CommandQueue& queue, void* item, const size_t item_size) {
+        const bool is_light = &queue == &queueFor(CommandClass::Light);
+        // Light messages set aside while the queue was full were ahead of this one
+        if (is_light) handleKeptLights(static_cast<const RingBufHeader*>(item)->sequence);
+        // Handled in place; the item goes back to the ring buffer only afterwards
+        handleMessage(item, item_size, is_light);
+        vRingbufferReturnItem(queue.ringbuf, item);
+    }
+
+    void MQTTCommandProcess::handleMessage(const void* item, const size_t item_size, const bool is_light) {
+        const auto* header = static_cast<const RingBufHeader*>(item);
+        const char* data_ptr = static_cast<const char*>(item) + sizeof(RingBufHeader);
+        if (item_size == header->itemSize()) {
+            const std::string_view topic(data_ptr, header->topic_len);
+            data_ptr += header->topic_len;
+            const std::string_view payload(data_ptr, header->payload_len);
+            data_ptr += header->payload_len;
+            const MessageProperties properties{
+                {data_ptr, header->response_topic_len},
+                {data_ptr + header->response_topic_len, header->correlation_len}
+            };
+            if (is_light) m_current_received_ms = header->received_ms;
+            MQTTCommandHandler::handle(topic, payload, properties);
+        } else {
+            ESP_LOGE(TAG, "RingBuffer item size mismatch! Expected %u, got %u", header->itemSize(), item_size);
+        }
+    }
+
+    [[noreturn]] void MQTTCommandProcess::WorkerTask(void* arg) {
+        auto& self = Instance();
+        auto& queue = *static_cast<CommandQueue*>(arg);
+        const bool is_light = &queue == &self.queueFor(CommandClass::Light);
+        const bool is_control = &queue == &self.queueFor(CommandClass::Control);
+        uint32_t last_stats_ms = 0;
         size_t item_size = 0;
 
         while (true) {
-            void* item = xRingbufferReceive(self->m_ringbuf, &item_size, portMAX_DELAY);
+            TickType_t wait = portMAX_DELAY;
+            // While light commands are held, only take what is already queued, then execute them
+            if (is_light && self.m_pending_count > 0) wait = 0;
+            // The control worker also reports queue pressure, including that of the stalled workers
+            if (is_control) wait = pdMS_TO_TICKS(STATS_INTERVAL_MS);
+
+            void* item = xRingbufferReceive(queue.ringbuf, &item_size, wait);
             if (item != nullptr) {
-                const auto* header = static_cast<RingBufHeader*>(item);
-                const char* data_ptr = static_cast<char*>(item) + sizeof(RingBufHeader);
-                if (item_size == sizeof(RingBufHeader) + header->topic_len + header->payload_len) {
-                    std::string topic_str(data_ptr, header->topic_len);
-                    std::string payload_str(data_ptr + header->topic_len, header->payload_len);
-                    MQTTCommandHandler::handle(topic_str, payload_str);
-                } else {
-                    ESP_LOGE(TAG, "RingBuffer item size mismatch! Expected %u, got %u",
-                        (sizeof(RingBufHeader) + header->topic_len + header->payload_len),
-                        item_size);
+                self.handleItem(queue, item, item_size);
+            } else if (is_light) {
+                self.drainAndFlushLightCommands();
+            }
+
+            if (is_control) {
+                const auto now_ms = static_cast<uint32_t>(esp_timer_get_time() / 1000);
+                if (now_ms - last_stats_ms >= STATS_INTERVAL_MS) {
+                    last_stats_ms = now_ms;
+                    self.publishStatsIfChanged();
                 }
-                vRingbufferReturnItem(self->m_ringbuf, item);
             }
         }
     }
-} // daliMQTT
\ No newline at end of file
+} // daliMQTT
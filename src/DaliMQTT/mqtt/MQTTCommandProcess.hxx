@@ -1,9 +1,27 @@
 #ifndef DALIMQTT_DALICOMMANDPROCESSOR_HXX
 #define DALIMQTT_DALICOMMANDPROCESSOR_HXX
 
+#include "mqtt/MQTTCommandHandler.hxx"
+
 namespace daliMQTT {
     struct __attribute__((packed)) RingBufHeader;
 
+    /** Per-queue counters, published on base/bridge/queues. */
+    struct CommandQueueStats {
+        uint8_t used_percent{0};
+        uint32_t dropped{0};
+    };
+
+    /**
+     * @brief Receives MQTT messages into one queue per CommandClass, each drained by its own worker.
+     *
+     * Light control never waits behind raw frames or bus scans, and config requests never wait
+     * behind the bus at all. The light worker moves queued messages into per-target slots between
+     * bus frames, so its queue only fills while a single command executes; then it drops its oldest
+     * message, except one no later command supersedes (a scene), which is set aside and still handled
+     * in order. The bus and control queues reject the new message instead. Each worker keeps the order
+     * of its own queue only; a raw frame may run before a light command that arrived earlier.
+     */
     class MQTTCommandProcess {
         public:
             MQTTCommandProcess(const MQTTCommandProcess&) = delete;
@@ -14,15 +32,92 @@ namespace daliMQTT {
             }
 
             void init();
-            bool enqueueMqttMessage(const char* topic, int topic_len, const char* data, int data_len) const;
+            bool enqueueMqttMessage(const char* topic, int topic_len, const char* data, int data_len,
+                                    const MessageProperties& properties = {});
+
+            /**
+             * @brief Holds a light command until the light queue is drained.
+             * A later command for the same target (short address, group or broadcast) is merged into it.
+             * A group or broadcast command clears the fields it overrides from the held commands of
+             * its members. Only called from the light worker.
+             */
+            void queueLightCommand(dali_addressType_t addr_type, uint8_t target_id, const LightCommand& command);
+
+            /**
+             * @brief Executes the held light commands in arrival order, dropping those past the deadline.
+             * Messages still queued are not taken, so nothing that arrived later runs first.
+             */
+            void flushLightCommands();
+
+            [[nodiscard]] CommandQueueStats getStats(CommandClass command_class) const;
 
         private:
             MQTTCommandProcess() = default;
 
-            [[noreturn]] static void CommandProcessTask(void* arg);
+            enum class DropPolicy : uint8_t {
+                DropOldest,
+                RejectNew
+            };
+
+            struct CommandQueue {
+                const char* task_name;
+                size_t size;
+                UBaseType_t priority;
+                DropPolicy policy;
+                RingbufHandle_t ringbuf{nullptr};
+                std::atomic<uint32_t> dropped{0};
+                uint32_t next_sequence{0};      // Only used by the MQTT task that enqueues
+            };
+
+            // 64 short addresses, 16 groups, broadcast
+            static constexpr size_t LIGHT_TARGETS = 64 + 16 + 1;
+            static constexpr uint8_t CONGESTED_PERCENT = 75;
+            static constexpr uint32_t STATS_INTERVAL_MS = 1000;
+            static constexpr size_t MAX_KEPT_LIGHTS = 8;
+
+            struct PendingLightCommand {
+                LightCommand command;
+                uint32_t received_ms{0};    // Receive time of the newest merged message
+                uint32_t sequence{0};
+                bool used{false};
+            };
+
+            [[noreturn]] static void WorkerTask(void* arg);
+            static size_t targetSlot(dali_addressType_t addr_type, uint8_t target_id);
+            static uint64_t slotMembers(size_t slot);
+            CommandQueue& queueFor(CommandClass command_class) { return m_queues[static_cast<size_t>(command_class)]; }
+            void handleItem(const CommandQueue& queue, void* item, size_t item_size);
+            void handleMessage(const void* item, size_t item_size, bool is_light);
+            /**
+             * @brief Removes the oldest message of a full DropOldest queue; a non-droppable one is set aside.
+             * @return false if the queue is empty.
+             */
+            bool evictOldest(CommandQueue& queue);
+            /** Handles set-aside light messages enqueued before before_sequence, or all of them. */
+            void handleKeptLights(std::optional<uint32_t> before_sequence);
+            void drainLightQueue();
+            void drainAndFlushLightCommands();
+            void executeNextLightCommand();
+            void publishStatsIfChanged();
+
+            std::array<CommandQueue, 3> m_queues{{
+                {"mqtt_light_cmd", 4 * 1024, 6, DropPolicy::DropOldest},
+                {"mqtt_bus_cmd", 6 * 1024, 5, DropPolicy::RejectNew},
+                {"mqtt_ctl_cmd", 4 * 1024, 4, DropPolicy::RejectNew},
+            }};
+
+            std::array<PendingLightCommand, LIGHT_TARGETS> m_pending_lights{};
+            size_t m_pending_count{0};
+            uint32_t m_sequence{0};
+            uint32_t m_current_received_ms{0};
+            // Non-droppable light messages evicted from the full queue, oldest first; guarded by m_kept_mutex
+            std::vector<std::vector<uint8_t>> m_kept_lights{};
+            std::mutex m_kept_mutex{};
 
-            RingbufHandle_t m_ringbuf{nullptr};
+            std::array<CommandQueueStats, 3> m_published_stats{};
+            bool m_published_congested{false};
+            bool m_stats_published{false};
     };
 } // daliMQTT
 
-#endif //DALIMQTT_DALICOMMANDPROCESSOR_HXX
\ No newline at end of file
+#endif //DALIMQTT_DALICOMMANDPROCESSOR_HXX
@@ -0,0 +1,198 @@
+#include "mqtt/MQTTOutbox.hxx"
+#include "utils/Hash.hxx"
+
+namespace daliMQTT
+{
+    static constexpr char TAG[] = "MQTTOutbox";
+
+    struct OutboxHeader {
+        uint32_t sequence;
+        uint32_t message_expiry_s;
+        uint16_t topic_len;         // Without the terminating null, which is stored too
+        uint16_t payload_len;
+        uint16_t correlation_len;
+        uint8_t qos;
+        bool retain;
+
+        [[nodiscard]] size_t itemSize() const {
+            return sizeof(OutboxHeader) + topic_len + 1 + payload_len + correlation_len;
+        }
+    };
+
+    std::vector<MQTTLastValueCache::Entry>::iterator MQTTLastValueCache::find(const std::string_view topic) {
+        const uint32_t topic_hash = utils::fnv1a(topic);
+        return std::ranges::find_if(m_entries, [&](const Entry& entry) {
+            return entry.topic_hash == topic_hash && entry.topic == topic;
+        });
+    }
+
+    bool MQTTLastValueCache::put(const std::string_view topic, const std::string_view payload, const uint8_t qos,
+                                 const uint32_t sequence) {
+        if (const auto it = find(topic); it != m_entries.end()) {
+            if (isNewer(it->sequence, sequence)) return true;
+            it->payload.assign(payload);
+            it->qos = qos;
+            it->sequence = sequence;
+            return true;
+        }
+        if (m_entries.size() >= m_capacity) return false;
+        m_entries.push_back({utils::fnv1a(topic), sequence, std::string(topic), std::string(payload), qos});
+        return true;
+    }
+
+    void MQTTLastValueCache::eraseOlder(const std::string_view topic, const uint32_t sequence) {
+        if (const auto it = find(topic); it != m_entries.end() && isNewer(sequence, it->sequence)) {
+            m_entries.erase(it);
+        }
+    }
+
+    std::optional<MQTTLastValueCache::Entry> MQTTLastValueCache::pop() {
+        if (m_entries.empty()) return std::nullopt;
+        Entry entry = std::move(m_entries.front());
+        m_entries.erase(m_entries.begin());
+        if (m_entries.empty()) m_entries.shrink_to_fit();
+        return entry;
+    }
+
+    void MQTTOutbox::init() {
+        if (m_task_handle) return;
+        m_ringbuf = xRingbufferCreate(CONFIG_DALI2MQTT_MQTT_OUTBOX_SIZE, RINGBUF_TYPE_NOSPLIT);
+        if (m_ringbuf == nullptr) {
+            ESP_LOGE(TAG, "Failed to create outbox, publishing directly");
+            return;
+        }
+        if (xTaskCreate(senderTask, "mqtt_outbox", 4096, this, 3, &m_task_handle) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create sender task, publishing directly");
+            vRingbufferDelete(m_ringbuf);
+            m_ringbuf = nullptr;
+            m_task_handle = nullptr;
+            return;
+        }
+        ESP_LOGI(TAG, "Outbox started (%d bytes, %d cached topics)",
+                 CONFIG_DALI2MQTT_MQTT_OUTBOX_SIZE, CONFIG_DALI2MQTT_MQTT_OFFLINE_CACHE_TOPICS);
+    }
+
+    bool MQTTOutbox::enqueue(const std::string_view topic, const std::string_view payload, const int qos,
+                             const bool retain, const PublishProperties& properties) {
+        const uint32_t sequence = m_sequence.fetch_add(1);
+        const size_t total_size = sizeof(OutboxHeader) + topic.size() + 1 + payload.size() +
+                                  properties.correlation_data.size();
+
+        void* item_ptr = nullptr;
+        if (xRingbufferSendAcquire(m_ringbuf, &item_ptr, total_size, 0) != pdTRUE) {
+            // Never wait for room; a retained value is kept for later instead
+            if (retain && cacheRetained(topic, payload, qos, sequence)) return true;
+            ++m_dropped;
+            ESP_LOGW(TAG, "Outbox full, dropped message for %.*s", static_cast<int>(topic.size()), topic.data());
+            return false;
+        }
+
+        auto* header = static_cast<OutboxHeader*>(item_ptr);
+        header->sequence = sequence;
+        header->message_expiry_s = properties.message_expiry_s;
+        header->topic_len = static_cast<uint16_t>(topic.size());
+        header->payload_len = static_cast<uint16_t>(payload.size());
+        header->correlation_len = static_cast<uint16_t>(properties.correlation_data.size());
+        header->qos = static_cast<uint8_t>(qos);
+        header->retain = retain;
+
+        char* data = static_cast<char*>(item_ptr) + sizeof(OutboxHeader);
+        memcpy(data, topic.data(), topic.size());
+        data[topic.size()] = '\0';
+        data += topic.size() + 1;
+        memcpy(data, payload.data(), payload.size());
+        data += payload.size();
+        memcpy(data, properties.correlation_data.data(), properties.correlation_data.size());
+
+        xRingbufferSendComplete(m_ringbuf, item_ptr);
+        return true;
+    }
+
+    bool MQTTOutbox::cacheRetained(const std::string_view topic, const std::string_view payload, const int qos,
+                                   const uint32_t sequence) {
+        std::lock_guard lock(m_cache_mutex);
+        const bool stored = m_cache.put(topic, payload, static_cast<uint8_t>(qos), sequence);
+        m_cached = m_cache.size();
+        if (!stored) {
+            ESP_LOGW(TAG, "Offline cache full, dropped %.*s", static_cast<int>(topic.size()), topic.data());
+        }
+        return stored;
+    }
+
+    void MQTTOutbox::senderTask(void* arg) {
+        auto* self = static_cast<MQTTOutbox*>(arg);
+        auto const& mqtt = MQTTClient::Instance();
+        bool flush_stalled = false;
+        while (true) {
+            TickType_t wait = portMAX_DELAY;
+            if (self->m_cached > 0) {
+                // Cached topics go out once the queue is empty, so queued older values cannot overwrite them.
+                // A client that accepts nothing (full esp-mqtt outbox, dead socket) is retried at the poll pace.
+                const bool connected = mqtt.getStatus() == MqttStatus::CONNECTED;
+                wait = connected && !flush_stalled ? 0 : OFFLINE_POLL_TICKS;
+            }
+
+            size_t item_size = 0;
+            if (void* item = xRingbufferReceive(self->m_ringbuf, &item_size, wait)) {
+                self->sendItem(item, item_size);
+                vRingbufferReturnItem(self->m_ringbuf, item);
+            } else if (self->m_cached > 0 && mqtt.getStatus() == MqttStatus::CONNECTED) {
+                flush_stalled = self->flushCache();
+            }
+        }
+    }
+
+    void MQTTOutbox::sendItem(const void* item, const size_t item_size) {
+        const auto* header = static_cast<const OutboxHeader*>(item);
+        if (item_size != header->itemSize()) {
+            ESP_LOGE(TAG, "Outbox item size mismatch! Expected %u, got %u", header->itemSize(), item_size);
+            return;
+        }
+
+        const char* topic = static_cast<const char*>(item) + sizeof(OutboxHeader);
+        const std::string_view topic_view(topic, header->topic_len);
+        const std::string_view payload(topic + header->topic_len + 1, header->payload_len);
+        const PublishProperties properties{
+            {payload.data() + payload.size(), header->correlation_len},
+            header->message_expiry_s
+        };
+
+        auto const& mqtt = MQTTClient::Instance();
+        if (mqtt.getStatus() == MqttStatus::CONNECTED &&
+            mqtt.publishDirect(topic, payload, header->qos, header->retain, properties)) {
+            if (header->retain && m_cached > 0) {
+                std::lock_guard lock(m_cache_mutex);
+                m_cache.eraseOlder(topic_view, header->sequence);
+                m_cached = m_cache.size();
+            }
+            return;
+        }
+
+        // Events and command replies are worthless once late
+        if (header->retain && cacheRetained(topic_view, payload, header->qos, header->sequence)) return;
+        ++m_dropped;
+    }
+
+    bool MQTTOutbox::flushCache() {
+        auto const& mqtt = MQTTClient::Instance();
+        size_t sent = 0;
+        while (mqtt.getStatus() == MqttStatus::CONNECTED) {
+            std::optional<MQTTLastValueCache::Entry> entry;
+            {
+                std::lock_guard lock(m_cache_mutex);
+                entry = m_cache.pop();
+                m_cached = m_cache.size();
+            }
+            if (!entry) break;
+
+            if (!mqtt.publishDirect(entry->topic.c_str(), entry->payload, entry->qos, true)) {
+                cacheRetained(entry->topic, entry->payload, entry->qos, entry->sequence);
+                if (sent > 0) ESP_LOGI(TAG, "Sent %zu topics changed while offline", sent);
+                return sent == 0;
+            }
+            ++sent;
+        }
+        if (sent > 0) ESP_LOGI(TAG, "Sent %zu topics changed while offline", sent);
+        return false;
+    }
+} // daliMQTT
@@ -0,0 +1,110 @@
+#ifndef DALIMQTT_MQTTOUTBOX_HXX
+#define DALIMQTT_MQTTOUTBOX_HXX
+
+#include "mqtt/MQTTClient.hxx"
+
+namespace daliMQTT
+{
+    /**
+     * @brief Latest retained payload per topic, kept while it cannot be sent.
+     * Not thread safe; MQTTOutbox guards it.
+     */
+    class MQTTLastValueCache {
+    public:
+        struct Entry {
+            uint32_t topic_hash{0};
+            uint32_t sequence{0};
+            std::string topic;
+            std::string payload;
+            uint8_t qos{0};
+        };
+
+        explicit MQTTLastValueCache(const size_t capacity) : m_capacity(capacity) {}
+
+        /**
+         * @brief Stores the payload for a topic unless a newer one is cached.
+         * @param sequence Publish order of the payload; a cached payload with a later sequence is kept.
+         * @return false if the topic is new and the cache is full.
+         */
+        bool put(std::string_view topic, std::string_view payload, uint8_t qos, uint32_t sequence);
+
+        /** Drops the cached payload of a topic if it is older than sequence. */
+        void eraseOlder(std::string_view topic, uint32_t sequence);
+
+        /** Removes and returns the oldest cached topic. */
+        std::optional<Entry> pop();
+
+        [[nodiscard]] size_t size() const { return m_entries.size(); }
+        [[nodiscard]] bool empty() const { return m_entries.empty(); }
+
+    private:
+        [[nodiscard]] std::vector<Entry>::iterator find(std::string_view topic);
+        /** Sequence numbers wrap, compare by distance. */
+        static bool isNewer(const uint32_t a, const uint32_t b) { return static_cast<int32_t>(a - b) > 0; }
+
+        size_t m_capacity;
+        std::vector<Entry> m_entries;
+    };
+
+    /**
+     * @brief Bounded outbox between the publishing tasks and the network.
+     *
+     * MQTTClient::publish only copies the message into a ring buffer; a low priority task sends
+     * it, so DALI tasks never wait for Wi-Fi or the broker. Retained messages that cannot be sent,
+     * because the broker is unreachable or the outbox is full, go to a last-value cache and are
+     * sent after the outbox drains: on reconnect, only topics changed while offline go out.
+     * Other messages (events, command replies) are dropped while offline.
+     *
+     * Every message gets a sequence number. A cached value never replaces a newer one, and a
+     * queued value that is sent drops an older cached one, so per-topic order holds even though
+     * the cache is flushed after the ring buffer.
+     */
+    class MQTTOutbox {
+    public:
+        MQTTOutbox(const MQTTOutbox&) = delete;
+        MQTTOutbox& operator=(const MQTTOutbox&) = delete;
+
+        static MQTTOutbox& Instance() {
+            static MQTTOutbox instance;
+            return instance;
+        }
+
+        /** Creates the ring buffer and the sender task. Until then MQTTClient publishes directly. */
+        void init();
+        [[nodiscard]] bool isRunning() const { return m_task_handle != nullptr; }
+
+        /**
+         * @brief Queues a message without blocking.
+         * @return false if the message was dropped.
+         */
+        bool enqueue(std::string_view topic, std::string_view payload, int qos, bool retain,
+                     const PublishProperties& properties);
+
+        [[nodiscard]] uint32_t droppedCount() const { return m_dropped; }
+
+    private:
+        MQTTOutbox() = default;
+
+        // How often the sender checks for a reconnect while topics are cached
+        static constexpr TickType_t OFFLINE_POLL_TICKS = pdMS_TO_TICKS(250);
+
+        [[noreturn]] static void senderTask(void* arg);
+        void sendItem(const void* item, size_t item_size);
+        /**
+         * Sends cached topics until the cache is empty, the connection drops or a publish fails.
+         * @return true if it stopped on a failed publish without sending anything.
+         */
+        bool flushCache();
+        bool cacheRetained(std::string_view topic, std::string_view payload, int qos, uint32_t sequence);
+
+        RingbufHandle_t m_ringbuf{nullptr};
+        TaskHandle_t m_task_handle{nullptr};
+        std::mutex m_cache_mutex;
+        MQTTLastValueCache m_cache{CONFIG_DALI2MQTT_MQTT_OFFLINE_CACHE_TOPICS};
+        std::atomic<size_t> m_cached{0};
+        std::atomic<uint32_t> m_sequence{0};
+        std::atomic<uint32_t> m_dropped{0};
+    };
+} // daliMQTT
+
+#endif //DALIMQTT_MQTTOUTBOX_HXX
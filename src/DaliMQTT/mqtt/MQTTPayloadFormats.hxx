@@ -0,0 +1,59 @@
+#ifndef DALIMQTT_MQTTPAYLOADFORMATS_HXX
+#define DALIMQTT_MQTTPAYLOADFORMATS_HXX
+
+#include "utils/PayloadWriter.hxx"
+#include "dali/DaliArcPower.hxx"
+
+namespace daliMQTT
+{
+    // Payload encoding per topic class, selected in menuconfig.
+
+    inline constexpr utils::PayloadFormat STATE_PAYLOAD_FORMAT =
+#if defined(CONFIG_DALI2MQTT_MQTT_STATE_FORMAT_CBOR)
+        utils::PayloadFormat::Cbor;
+#elif defined(CONFIG_DALI2MQTT_MQTT_STATE_FORMAT_MSGPACK)
+        utils::PayloadFormat::MsgPack;
+#else
+        utils::PayloadFormat::Json;
+#endif
+
+    inline constexpr utils::PayloadFormat EVENT_PAYLOAD_FORMAT =
+#if defined(CONFIG_DALI2MQTT_MQTT_EVENT_FORMAT_CBOR)
+        utils::PayloadFormat::Cbor;
+#elif defined(CONFIG_DALI2MQTT_MQTT_EVENT_FORMAT_MSGPACK)
+        utils::PayloadFormat::MsgPack;
+#else
+        utils::PayloadFormat::Json;
+#endif
+
+    inline constexpr utils::PayloadFormat BUS_SNAPSHOT_PAYLOAD_FORMAT =
+#if defined(CONFIG_DALI2MQTT_MQTT_BUS_SNAPSHOT_FORMAT_CBOR)
+        utils::PayloadFormat::Cbor;
+#elif defined(CONFIG_DALI2MQTT_MQTT_BUS_SNAPSHOT_FORMAT_MSGPACK)
+        utils::PayloadFormat::MsgPack;
+#else
+        utils::PayloadFormat::Json;
+#endif
+
+    /** Arc power level of gear on `curve` to the "brightness" field of light payloads. */
+    constexpr uint8_t levelToBrightness(const uint8_t level, const DimmingCurve curve = DimmingCurve::Logarithmic) {
+#ifdef CONFIG_DALI2MQTT_MQTT_BRIGHTNESS_LINEAR
+        return DaliArcPower::convert(level, curve, DimmingCurve::Linear);
+#else
+        (void)curve;
+        return level;
+#endif
+    }
+
+    /** "brightness" field of a light command (0..254) to an arc power level for gear on `curve`. */
+    constexpr uint8_t brightnessToLevel(const uint8_t brightness, const DimmingCurve curve = DimmingCurve::Logarithmic) {
+#ifdef CONFIG_DALI2MQTT_MQTT_BRIGHTNESS_LINEAR
+        return DaliArcPower::convert(brightness, DimmingCurve::Linear, curve);
+#else
+        (void)curve;
+        return brightness;
+#endif
+    }
+} // daliMQTT
+
+#endif //DALIMQTT_MQTTPAYLOADFORMATS_HXX
@@ -0,0 +1,161 @@
+#include "mqtt/MQTTPublishCoalescer.hxx"
+#include "mqtt/MQTTClient.hxx"
+#include "utils/Hash.hxx"
+#include <esp_timer.h>
+
+namespace daliMQTT
+{
+    static constexpr char TAG[] = "MQTTPublishCoalescer";
+    static constexpr int64_t MIN_INTERVAL_MS = CONFIG_DALI2MQTT_MQTT_PUBLISH_MIN_INTERVAL_MS;
+    static constexpr uint32_t FLUSH_PERIOD_MS = std::max<uint32_t>(10, CONFIG_DALI2MQTT_MQTT_PUBLISH_MIN_INTERVAL_MS / 4);
+
+    void MQTTPublishCoalescer::init() {
+        if (m_task_handle) return;
+        if constexpr (MIN_INTERVAL_MS == 0) {
+            ESP_LOGI(TAG, "Publish interval is 0, only unchanged payloads are suppressed");
+            return;
+        }
+        if (xTaskCreate(flushTask, "mqtt_coalesce", 3072, this, 4, &m_task_handle) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create flush task, publishing without coalescing");
+            m_task_handle = nullptr;
+            return;
+        }
+        ESP_LOGI(TAG, "Publish coalescing started (%lld ms, %zu topics, %zu pending slots)",
+                 MIN_INTERVAL_MS, m_entries.size(), m_slots.size());
+    }
+
+    void MQTTPublishCoalescer::submit(const std::string& topic, const std::string_view payload, const int qos, const bool retain) {
+        const uint32_t topic_hash = utils::fnv1a(topic);
+        const uint32_t payload_hash = utils::fnv1a(payload);
+        const int64_t now_ms = esp_timer_get_time() / 1000;
+        const bool can_defer = m_task_handle != nullptr && topic.size() < MAX_TOPIC_LEN && payload.size() <= MAX_PAYLOAD_LEN;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (auto* entry = findOrAllocateEntry(topic_hash)) {
+                const bool same_as_sent = entry->sent &&
+                                          entry->payload_hash == payload_hash && entry->payload_len == payload.size();
+
+                if (entry->pending_slot != NO_SLOT) {
+                    auto& slot = m_slots[entry->pending_slot];
+                    if (same_as_sent || !can_defer) {
+                        // Either the value returned to what the broker already holds, or it does not fit a slot
+                        slot.used = false;
+                        entry->pending_slot = NO_SLOT;
+                    }
+                }
+                if (entry->pending_slot != NO_SLOT) {
+                    auto& slot = m_slots[entry->pending_slot];
+                    std::memcpy(slot.payload.data(), payload.data(), payload.size());
+                    slot.payload_len = static_cast<uint16_t>(payload.size());
+                    slot.qos = static_cast<uint8_t>(qos);
+                    slot.retain = retain;
+                    return;
+                }
+
+                if (same_as_sent) return;
+
+                const bool interval_elapsed = (now_ms - entry->last_publish_ms) >= MIN_INTERVAL_MS;
+                if (can_defer && !interval_elapsed) {
+                    if (const int8_t slot_idx = allocatePendingSlot(); slot_idx != NO_SLOT) {
+                        auto& slot = m_slots[slot_idx];
+                        std::memcpy(slot.topic.data(), topic.data(), topic.size());
+                        slot.topic[topic.size()] = '\0';
+                        std::memcpy(slot.payload.data(), payload.data(), payload.size());
+                        slot.payload_len = static_cast<uint16_t>(payload.size());
+                        slot.qos = static_cast<uint8_t>(qos);
+                        slot.retain = retain;
+                        entry->pending_slot = slot_idx;
+                        return;
+                    }
+                    ESP_LOGD(TAG, "No free pending slot, publishing directly");
+                }
+
+                entry->payload_hash = payload_hash;
+                entry->payload_len = static_cast<uint16_t>(payload.size());
+                entry->last_publish_ms = now_ms;
+                entry->sent = true;
+            }
+        }
+
+        MQTTClient::Instance().publish(topic.c_str(), payload, qos, retain);
+    }
+
+    void MQTTPublishCoalescer::reset() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_entries.fill(TopicEntry{});
+        for (auto& slot : m_slots) {
+            slot.used = false;
+        }
+    }
+
+    void MQTTPublishCoalescer::flushTask(void* arg) {
+        auto* self = static_cast<MQTTPublishCoalescer*>(arg);
+        const TickType_t period = pdMS_TO_TICKS(FLUSH_PERIOD_MS);
+        while (true) {
+            vTaskDelay(period);
+            self->flushDue(esp_timer_get_time() / 1000);
+        }
+    }
+
+    void MQTTPublishCoalescer::flushDue(const int64_t now_ms) {
+        OutgoingMessage msg;
+        for (size_t i = 0; i < m_entries.size(); ++i) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                auto& entry = m_entries[i];
+                if (!entry.used || entry.pending_slot == NO_SLOT) continue;
+                if ((now_ms - entry.last_publish_ms) < MIN_INTERVAL_MS) continue;
+
+                auto& slot = m_slots[entry.pending_slot];
+                msg.topic = slot.topic;
+                std::memcpy(msg.payload.data(), slot.payload.data(), slot.payload_len);
+                msg.payload_len = slot.payload_len;
+                msg.qos = slot.qos;
+                msg.retain = slot.retain;
+
+                slot.used = false;
+                entry.pending_slot = NO_SLOT;
+                entry.payload_hash = utils::fnv1a({msg.payload.data(), msg.payload_len});
+                entry.payload_len = msg.payload_len;
+                entry.last_publish_ms = now_ms;
+                entry.sent = true;
+            }
+            MQTTClient::Instance().publish(msg.topic.data(), {msg.payload.data(), msg.payload_len}, msg.qos, msg.retain);
+        }
+    }
+
+    MQTTPublishCoalescer::TopicEntry* MQTTPublishCoalescer::findOrAllocateEntry(const uint32_t topic_hash) {
+        TopicEntry* free_entry = nullptr;
+        TopicEntry* oldest_idle = nullptr;
+        for (auto& entry : m_entries) {
+            if (!entry.used) {
+                if (!free_entry) free_entry = &entry;
+                continue;
+            }
+            if (entry.topic_hash == topic_hash) return &entry;
+            if (entry.pending_slot == NO_SLOT &&
+                (!oldest_idle || entry.last_publish_ms < oldest_idle->last_publish_ms)) {
+                oldest_idle = &entry;
+            }
+        }
+
+        // Evicting only forgets the last-sent hash, so the topic is at worst published once more
+        TopicEntry* target = free_entry ? free_entry : oldest_idle;
+        if (!target) return nullptr;
+        *target = TopicEntry{};
+        target->used = true;
+        target->topic_hash = topic_hash;
+        return target;
+    }
+
+    int8_t MQTTPublishCoalescer::allocatePendingSlot() {
+        for (size_t i = 0; i < m_slots.size(); ++i) {
+            if (!m_slots[i].used) {
+                m_slots[i].used = true;
+                return static_cast<int8_t>(i);
+            }
+        }
+        return NO_SLOT;
+    }
+} // daliMQTT
@@ -0,0 +1,80 @@
+#ifndef DALIMQTT_MQTTPUBLISHCOALESCER_HXX
+#define DALIMQTT_MQTTPUBLISHCOALESCER_HXX
+
+namespace daliMQTT
+{
+    /**
+     * @brief Outbound coalescing stage for retained state topics.
+     *
+     * Every topic gets at most one publish per CONFIG_DALI2MQTT_MQTT_PUBLISH_MIN_INTERVAL_MS.
+     * Updates arriving inside the window overwrite a pending slot (last value wins) and are
+     * flushed by a background task. Payloads identical to the last one sent are dropped.
+     * Memory is fixed: a table of per-topic hashes and a small pool of pending payload slots.
+     */
+    class MQTTPublishCoalescer {
+    public:
+        MQTTPublishCoalescer(const MQTTPublishCoalescer&) = delete;
+        MQTTPublishCoalescer& operator=(const MQTTPublishCoalescer&) = delete;
+
+        static MQTTPublishCoalescer& Instance() {
+            static MQTTPublishCoalescer instance;
+            return instance;
+        }
+
+        /** Starts the flush task. Until then submit() publishes directly. */
+        void init();
+
+        /** Publishes now, defers until the topic's interval has elapsed, or drops an unchanged payload. */
+        void submit(const std::string& topic, std::string_view payload, int qos = 0, bool retain = true);
+
+        /** Forgets what was sent and drops pending payloads, e.g. after a broker reconnect. */
+        void reset();
+
+    private:
+        MQTTPublishCoalescer() = default;
+
+        static constexpr size_t MAX_TOPIC_LEN = 96;
+        static constexpr size_t MAX_PAYLOAD_LEN = 256;
+        static constexpr int8_t NO_SLOT = -1;
+
+        struct TopicEntry {
+            uint32_t topic_hash{0};
+            uint32_t payload_hash{0};
+            uint16_t payload_len{0};
+            int64_t last_publish_ms{0};
+            int8_t pending_slot{NO_SLOT};
+            bool used{false};
+            bool sent{false};
+        };
+
+        struct PendingSlot {
+            std::array<char, MAX_TOPIC_LEN> topic{};
+            std::array<char, MAX_PAYLOAD_LEN> payload{};
+            uint16_t payload_len{0};
+            uint8_t qos{0};
+            bool retain{false};
+            bool used{false};
+        };
+
+        struct OutgoingMessage {
+            std::array<char, MAX_TOPIC_LEN> topic{};
+            std::array<char, MAX_PAYLOAD_LEN> payload{};
+            uint16_t payload_len{0};
+            uint8_t qos{0};
+            bool retain{false};
+        };
+
+        [[noreturn]] static void flushTask(void* arg);
+        void flushDue(int64_t now_ms);
+
+        TopicEntry* findOrAllocateEntry(uint32_t topic_hash);
+        int8_t allocatePendingSlot();
+
+        std::array<TopicEntry, CONFIG_DALI2MQTT_MQTT_COALESCE_TOPICS> m_entries{};
+        std::array<PendingSlot, CONFIG_DALI2MQTT_MQTT_COALESCE_PENDING_SLOTS> m_slots{};
+        std::mutex m_mutex{};
+        TaskHandle_t m_task_handle{nullptr};
+    };
+} // daliMQTT
+
+#endif //DALIMQTT_MQTTPUBLISHCOALESCER_HXX
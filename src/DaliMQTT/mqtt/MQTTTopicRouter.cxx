@@ -0,0 +1,147 @@
+#include "mqtt/MQTTTopicRouter.hxx"
+#include "utils/DaliLongAddrConversions.hxx"
+
+namespace daliMQTT
+{
+    static constexpr char TAG[] = "MQTTTopicRouter";
+    static constexpr std::string_view CAPTURE_LONG = "{long}";
+    static constexpr std::string_view CAPTURE_GROUP = "{group}";
+
+    /** Splits off the next non-empty level of the topic; returns false when none is left. */
+    static bool nextLevel(std::string_view& rest, std::string_view& level) {
+        while (rest.starts_with('/')) rest.remove_prefix(1);
+        if (rest.empty()) return false;
+        const size_t end = rest.find('/');
+        level = rest.substr(0, end);
+        rest.remove_prefix(end == std::string_view::npos ? rest.size() : end);
+        return true;
+    }
+
+    bool MQTTTopicRouter::add(const std::string_view pattern, const RouteHandler handler, const uint8_t tag) {
+        if (!handler || m_route_count >= MAX_ROUTES) {
+            ESP_LOGE(TAG, "Cannot register route %.*s", static_cast<int>(pattern.size()), pattern.data());
+            return false;
+        }
+
+        uint8_t node = 0;
+        std::string_view rest = pattern;
+        std::string_view level;
+        while (nextLevel(rest, level)) {
+            Capture capture = Capture::None;
+            if (level == CAPTURE_LONG) capture = Capture::LongAddress;
+            else if (level == CAPTURE_GROUP) capture = Capture::GroupId;
+
+            node = findOrAddChild(node, capture == Capture::None ? level : std::string_view{}, capture);
+            if (node == NO_NODE) {
+                ESP_LOGE(TAG, "Route table full at %.*s", static_cast<int>(pattern.size()), pattern.data());
+                return false;
+            }
+        }
+        if (node == 0 || m_nodes[node].handler != nullptr) {
+            ESP_LOGE(TAG, "Empty or duplicate route %.*s", static_cast<int>(pattern.size()), pattern.data());
+            return false;
+        }
+
+        m_nodes[node].handler = handler;
+        m_nodes[node].tag = tag;
+        m_patterns[m_route_count++] = pattern;
+        return true;
+    }
+
+    uint8_t MQTTTopicRouter::findOrAddChild(const uint8_t parent, const std::string_view level, const Capture capture) {
+        uint8_t* link = &m_nodes[parent].first_child;
+        while (*link != NO_NODE) {
+            const Node& child = m_nodes[*link];
+            if (child.capture == capture && child.level == level) return *link;
+            link = &m_nodes[*link].next_sibling;
+        }
+        if (m_node_count >= MAX_NODES) return NO_NODE;
+
+        // Literal children go to the front so they are tried before captures
+        const uint8_t index = m_node_count++;
+        m_nodes[index] = Node{level, capture};
+        if (capture == Capture::None) {
+            m_nodes[index].next_sibling = m_nodes[parent].first_child;
+            m_nodes[parent].first_child = index;
+        } else {
+            *link = index;
+        }
+        return index;
+    }
+
+    bool MQTTTopicRouter::captureLevel(const Capture capture, const std::string_view level, RouteParams& params) {
+        switch (capture) {
+            case Capture::LongAddress: {
+                const auto long_addr = utils::stringToLongAddress(level);
+                if (!long_addr) return false;
+                params.long_addr = *long_addr;
+                return true;
+            }
+            case Capture::GroupId: {
+                uint8_t group_id = 0;
+                const auto [ptr, ec] = std::from_chars(level.data(), level.data() + level.size(), group_id);
+                if (ec != std::errc() || ptr != level.data() + level.size() || group_id > 15) return false;
+                params.group_id = group_id;
+                return true;
+            }
+            case Capture::None:
+            default:
+                return false;
+        }
+    }
+
+    uint8_t MQTTTopicRouter::match(const std::string_view topic, RouteParams& params) const {
+        uint8_t node = 0;
+        std::string_view rest = topic;
+        std::string_view level;
+        while (nextLevel(rest, level)) {
+            uint8_t matched = NO_NODE;
+            for (uint8_t child = m_nodes[node].first_child; child != NO_NODE; child = m_nodes[child].next_sibling) {
+                const Node& candidate = m_nodes[child];
+                if (candidate.capture == Capture::None ? candidate.level == level
+                                                       : captureLevel(candidate.capture, level, params)) {
+                    matched = child;
+                    break;
+                }
+            }
+            if (matched == NO_NODE) return NO_NODE;
+            node = matched;
+        }
+
+        if (node == 0 || m_nodes[node].handler == nullptr) return NO_NODE;
+        return node;
+    }
+
+    bool MQTTTopicRouter::dispatch(const std::string_view topic, const std::string_view payload,
+                                   const MessageProperties& properties) const {
+        RouteParams params;
+        params.properties = properties;
+        const uint8_t node = match(topic, params);
+        if (node == NO_NODE) return false;
+        m_nodes[node].handler(params, payload);
+        return true;
+    }
+
+    std::optional<uint8_t> MQTTTopicRouter::tagOf(const std::string_view topic) const {
+        RouteParams params;
+        const uint8_t node = match(topic, params);
+        if (node == NO_NODE) return std::nullopt;
+        return m_nodes[node].tag;
+    }
+
+    std::vector<std::string> MQTTTopicRouter::subscriptionFilters(const std::string_view base_topic) const {
+        std::vector<std::string> filters;
+        filters.reserve(m_route_count);
+        for (uint8_t i = 0; i < m_route_count; ++i) {
+            std::string filter(base_topic);
+            std::string_view rest = m_patterns[i];
+            std::string_view level;
+            while (nextLevel(rest, level)) {
+                filter += '/';
+                filter += (level == CAPTURE_LONG || level == CAPTURE_GROUP) ? std::string_view("+") : level;
+            }
+            filters.push_back(std::move(filter));
+        }
+        return filters;
+    }
+} // daliMQTT
@@ -0,0 +1,86 @@
+#ifndef DALIMQTT_MQTTTOPICROUTER_HXX
+#define DALIMQTT_MQTTTOPICROUTER_HXX
+
+#include "dali/DaliСommon.hxx"
+
+namespace daliMQTT
+{
+    /** MQTT 5 request properties of an incoming message, empty under MQTT 3.1.1. */
+    struct MessageProperties {
+        std::string_view response_topic;
+        std::string_view correlation_data;
+    };
+
+    /** Values captured from a matched topic. Only the fields named in the route's pattern are set. */
+    struct RouteParams {
+        DaliLongAddress_t long_addr{0};
+        uint8_t group_id{0};
+        MessageProperties properties;
+    };
+
+    using RouteHandler = void (*)(const RouteParams& params, std::string_view payload);
+
+    /**
+     * @brief Dispatches command topics through a trie of topic levels.
+     *
+     * Patterns are relative to the base topic, e.g. "light/{long}/set" or "light/group/{group}/set".
+     * "{long}" captures a hex long address, "{group}" a group id 0..15. Literal levels win over
+     * captures. Patterns must have static storage duration; the trie keeps views into them.
+     * Matching walks the topic once and never allocates.
+     */
+    class MQTTTopicRouter {
+    public:
+        /**
+         * @brief Registers a route.
+         * @param tag Caller-defined class of the route, see tagOf().
+         * @return false if the pattern is invalid, duplicate or the trie is full.
+         */
+        bool add(std::string_view pattern, RouteHandler handler, uint8_t tag = 0);
+
+        /**
+         * @brief Runs the handler registered for the topic.
+         * @param topic Topic below the base topic, leading '/' optional.
+         * @param properties Passed on to the handler in RouteParams.
+         * @return false if no route matched or a captured level did not parse.
+         */
+        bool dispatch(std::string_view topic, std::string_view payload, const MessageProperties& properties = {}) const;
+
+        /** Tag of the route matching the topic, without running its handler. */
+        [[nodiscard]] std::optional<uint8_t> tagOf(std::string_view topic) const;
+
+        /** Subscription filters for every route, captures replaced by '+'. */
+        [[nodiscard]] std::vector<std::string> subscriptionFilters(std::string_view base_topic) const;
+
+    private:
+        enum class Capture : uint8_t {
+            None,
+            LongAddress,
+            GroupId
+        };
+
+        static constexpr uint8_t MAX_NODES = 48;
+        static constexpr uint8_t MAX_ROUTES = 24;
+        static constexpr uint8_t NO_NODE = 0xFF;
+
+        struct Node {
+            std::string_view level;     // Literal level, empty for captures
+            Capture capture{Capture::None};
+            uint8_t first_child{NO_NODE};
+            uint8_t next_sibling{NO_NODE};
+            RouteHandler handler{nullptr};
+            uint8_t tag{0};
+        };
+
+        uint8_t findOrAddChild(uint8_t parent, std::string_view level, Capture capture);
+        /** Node of the route matching the topic, or NO_NODE. */
+        uint8_t match(std::string_view topic, RouteParams& params) const;
+        static bool captureLevel(Capture capture, std::string_view level, RouteParams& params);
+
+        std::array<Node, MAX_NODES> m_nodes{Node{}};
+        uint8_t m_node_count{1};    // Node 0 is the root
+        std::array<std::string_view, MAX_ROUTES> m_patterns{};
+        uint8_t m_route_count{0};
+    };
+} // daliMQTT
+
+#endif //DALIMQTT_MQTTTOPICROUTER_HXX
@@ -0,0 +1,32 @@
+#ifndef DALIMQTT_MQTTTOPICS_HXX
+#define DALIMQTT_MQTTTOPICS_HXX
+
+#include "dali/DaliСommon.hxx"
+#include "utils/DaliLongAddrConversions.hxx"
+
+namespace daliMQTT
+{
+    /** Per-device topics, built once when the device is mapped. */
+    struct DeviceTopics {
+        std::string state;       // base/light/{LONG_ADDRESS}/state
+        std::string status;      // base/light/{LONG_ADDRESS}/status
+        std::string attributes;  // base/light/{LONG_ADDRESS}/attributes
+        std::string groups;      // base/light/{LONG_ADDRESS}/groups
+        std::string event;       // base/event/long/{LONG_ADDRESS}
+    };
+
+    inline std::shared_ptr<const DeviceTopics> makeDeviceTopics(const std::string_view base_topic, const DaliLongAddress_t long_addr) {
+        const auto addr_str = utils::longAddressToString(long_addr);
+        const std::string light_prefix = std::string(base_topic) + "/light/" + addr_str.data();
+
+        auto topics = std::make_shared<DeviceTopics>();
+        topics->state = light_prefix + "/state";
+        topics->status = light_prefix + "/status";
+        topics->attributes = light_prefix + "/attributes";
+        topics->groups = light_prefix + "/groups";
+        topics->event = std::string(base_topic) + "/event/long/" + addr_str.data();
+        return topics;
+    }
+} // daliMQTT
+
+#endif //DALIMQTT_MQTTTOPICS_HXX
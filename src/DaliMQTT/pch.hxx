@@ -6,6 +6,7 @@
 #include <array>
 #include <set>
 #include <atomic>
+#include <bit>
 #include <bitset>
 #include <charconv>
 #include <cstdarg>
@@ -14,6 +15,7 @@
 #include <variant>
 #include <functional>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <ranges>
@@ -1,6 +1,10 @@
 #include "system/ConfigManager.hxx"
 #include "dali/DaliAdapter.hxx"
 #include "mqtt/MQTTCommandProcess.hxx"
+#include "mqtt/MQTTCommandHandler.hxx"
+#include "mqtt/MQTTPublishCoalescer.hxx"
+#include "mqtt/MQTTOutbox.hxx"
+#include "mqtt/MQTTBusSnapshot.hxx"
 #include "system/SystemHardwareControls.hxx"
 #include "dali/DaliGroupManagement.hxx"
 #include "dali/DaliSceneManagement.hxx"
@@ -34,6 +38,9 @@ namespace daliMQTT
 
         SystemHardwareControls::checkOtaValidation();
         SystemHardwareControls::startResetConfigurationButtonMonitor();
+        MQTTOutbox::Instance().init();
+        MQTTPublishCoalescer::Instance().init();
+        MQTTBusSnapshot::Instance().init();
         initDaliSubsystem();
         MQTTCommandProcess::Instance().init();
         WebUI::Instance().start();
@@ -54,7 +61,7 @@ namespace daliMQTT
     }
 
     void AppController::initNetworkSubsystem() {
-        const auto config = ConfigManager::Instance().getConfig();
+        const auto config = ConfigManager::Instance().getSnapshot();
         auto& wifi = Wifi::Instance();
 
         wifi.init();
@@ -62,28 +69,28 @@ namespace daliMQTT
         wifi.onConnected = [this]() { this->onNetworkConnected(); };
         wifi.onDisconnected = [this]() { this->onNetworkDisconnected(); };
 
-        wifi.connectToAP(config.wifi_ssid, config.wifi_password);
+        wifi.connectToAP(config->wifi_ssid, config->wifi_password);
     }
 
     void AppController::onNetworkConnected() {
         ESP_LOGI(TAG, "Network Connected. IP: %s", Wifi::Instance().getIpAddress().c_str());
         m_network_connected = true;
 
-        const auto config = ConfigManager::Instance().getConfig();
+        const auto config = ConfigManager::Instance().getSnapshot();
 
-        if (config.syslog_enabled && !config.syslog_server.empty()) {
-            SyslogConfig::Instance().init(config.syslog_server);
+        if (config->syslog_enabled && !config->syslog_server.empty()) {
+            SyslogConfig::Instance().init(config->syslog_server);
         }
 
         auto& mqtt = MQTTClient::Instance();
-        const std::string availability_topic = utils::stringFormat("%s%s", config.mqtt_base_topic.c_str(), CONFIG_DALI2MQTT_MQTT_AVAILABILITY_TOPIC);
+        const std::string availability_topic = utils::stringFormat("%s%s", config->mqtt_base_topic.c_str(), CONFIG_DALI2MQTT_MQTT_AVAILABILITY_TOPIC);
 
-        mqtt.init(config.mqtt_uri,
-                      config.client_id,
+        mqtt.init(config->mqtt_uri,
+                      config->client_id,
                       availability_topic,
-                      config.mqtt_user,
-                      config.mqtt_pass,
-                      config.mqtt_ca_cert);
+                      config->mqtt_user,
+                      config->mqtt_pass,
+                      config->mqtt_ca_cert);
         mqtt.onConnected = [this]() { this->onMqttConnected(); };
         mqtt.onDisconnected = [this]() { this->onMqttDisconnected(); };
         mqtt.connect();
@@ -97,77 +104,81 @@ namespace daliMQTT
     void AppController::onMqttConnected() {
         ESP_LOGI(TAG, "MQTT connected successfully.");
         m_mqtt_connected = true;
-        auto config = ConfigManager::Instance().getConfig();
+        const auto config = ConfigManager::Instance().getSnapshot();
         auto const& mqtt = MQTTClient::Instance();
 
-        std::string availability_topic = utils::stringFormat("%s%s", config.mqtt_base_topic.c_str(), CONFIG_DALI2MQTT_MQTT_AVAILABILITY_TOPIC);
+        // The last will may have replaced it while we were away
+        std::string availability_topic = utils::stringFormat("%s%s", config->mqtt_base_topic.c_str(), CONFIG_DALI2MQTT_MQTT_AVAILABILITY_TOPIC);
         mqtt.publish(availability_topic, CONFIG_DALI2MQTT_MQTT_PAYLOAD_ONLINE, 1, true);
 
-        std::string ip_topic = utils::stringFormat("%s/ip_addr", config.mqtt_base_topic.c_str());
-        std::string ip_addr = Wifi::Instance().getIpAddress();
-        mqtt.publish(ip_topic, ip_addr, 1, true);
+        if (m_broker_synced && mqtt.isSessionPresent()) {
+            // Subscriptions survived, and state that changed while offline is flushed by the outbox
+            ESP_LOGI(TAG, "MQTT session resumed, skipping full resync.");
+            publishBridgeInfo(false);
+            return;
+        }
+        resyncBroker(false);
+    }
 
-        std::string version_topic = utils::stringFormat("%s/version", config.mqtt_base_topic.c_str());
-        mqtt.publish(version_topic, DALIMQTT_VERSION, 1, true);
+    void AppController::resyncBroker(const bool force_discovery) {
+        if (!m_mqtt_connected) {
+            ESP_LOGW(TAG, "Cannot resync: MQTT not connected.");
+            return;
+        }
+        ESP_LOGI(TAG, "Full broker resync%s...", force_discovery ? " (forced discovery)" : "");
+        // Broker state is unknown; everything below must really go out
+        MQTTPublishCoalescer::Instance().reset();
+        MQTTBusSnapshot::Instance().reset();
 
-        // base/light/LONG_ADDR/set
-        std::string light_single_topic = utils::stringFormat("%s/light/+/set", config.mqtt_base_topic.c_str());
-        mqtt.subscribe(light_single_topic);
-        ESP_LOGI(TAG, "Subscribed to lights: %s", light_single_topic.c_str());
-
-        // base/light/group/GROUP_ID/set
-        std::string light_group_topic = utils::stringFormat("%s/light/group/+/set", config.mqtt_base_topic.c_str());
-        mqtt.subscribe(light_group_topic);
-        ESP_LOGI(TAG, "Subscribed to light groups: %s", light_group_topic.c_str());
-
-        // base/light/broadcast/set
-        std::string light_broadcast_topic = utils::stringFormat("%s/light/broadcast/set", config.mqtt_base_topic.c_str());
-        mqtt.subscribe(light_broadcast_topic);
-        ESP_LOGI(TAG, "Subscribed to broadcast: %s", light_broadcast_topic.c_str());
-
-        // base/config/group/set
-        std::string config_group_topic = utils::stringFormat("%s%s", config.mqtt_base_topic.c_str(), CONFIG_DALI2MQTT_MQTT_GROUP_SET_SUBTOPIC);
-        mqtt.subscribe(config_group_topic);
-        ESP_LOGI(TAG, "Subscribed to group config: %s", config_group_topic.c_str());
-
-        // base/scene/set
-        std::string scene_cmd_topic = utils::stringFormat("%s%s", config.mqtt_base_topic.c_str(), CONFIG_DALI2MQTT_MQTT_SCENE_CMD_SUBTOPIC);
-        mqtt.subscribe(scene_cmd_topic);
-        ESP_LOGI(TAG, "Subscribed to scenes: %s", scene_cmd_topic.c_str());
-
-        // base/cmd/send
-        std::string cmd_topic = utils::stringFormat("%s/cmd/send", config.mqtt_base_topic.c_str());
-        mqtt.subscribe(cmd_topic);
-        ESP_LOGW(TAG, "DEBUG INTERFACE ENABLED. Subscribed to: %s", cmd_topic.c_str());
-
-        // base/cmd/sync
-        std::string sync_topic = utils::stringFormat("%s/cmd/sync", config.mqtt_base_topic.c_str());
-        mqtt.subscribe(sync_topic);
-        ESP_LOGI(TAG, "Subscribed to sync: %s", sync_topic.c_str());
-
-        // base/config/bus/scan
-        std::string bus_scan_topic = utils::stringFormat("%s/config/bus/scan", config.mqtt_base_topic.c_str());
-        mqtt.subscribe(bus_scan_topic);
-
-        // base/config/bus/initialize
-        std::string bus_init_topic = utils::stringFormat("%s/config/bus/initialize", config.mqtt_base_topic.c_str());
-        mqtt.subscribe(bus_init_topic);
-        ESP_LOGI(TAG, "Subscribed to bus management: %s, %s", bus_scan_topic.c_str(), bus_init_topic.c_str());
-
-        // base/config/get
-        std::string config_get_topic = utils::stringFormat("%s/config/get", config.mqtt_base_topic.c_str());
-        mqtt.subscribe(config_get_topic);
-
-        // base/config/set
-        std::string config_set_topic = utils::stringFormat("%s/config/set", config.mqtt_base_topic.c_str());
-        mqtt.subscribe(config_set_topic);
-        ESP_LOGI(TAG, "Subscribed to system config management: %s, %s", config_get_topic.c_str(), config_set_topic.c_str());
-
-        if (config.hass_discovery_enabled) {
-            publishHAMqttDiscovery();
+        subscribeCommands();
+        publishBridgeInfo(true);
+
+        if (ConfigManager::Instance().getSnapshot()->hass_discovery_enabled) {
+            publishHAMqttDiscovery(force_discovery);
         }
 
         DaliGroupManagement::Instance().publishAllGroups();
+        DaliDeviceController::Instance().publishAllStates();
+        m_broker_synced = true;
+    }
+
+    void AppController::subscribeCommands() const {
+        const auto config = ConfigManager::Instance().getSnapshot();
+        auto const& mqtt = MQTTClient::Instance();
+
+#ifdef CONFIG_DALI2MQTT_MQTT_WILDCARD_SUBSCRIPTION
+        const std::string command_filter = config->mqtt_base_topic + "/#";
+        mqtt.subscribe(command_filter);
+        ESP_LOGI(TAG, "Subscribed to commands: %s", command_filter.c_str());
+#else
+        // One subscription per command route, e.g. base/light/+/set
+        for (const auto& filter : MQTTCommandHandler::subscriptionFilters(config->mqtt_base_topic)) {
+            mqtt.subscribe(filter);
+            ESP_LOGI(TAG, "Subscribed to: %s", filter.c_str());
+        }
+#endif
+
+        if (config->hass_discovery_enabled) {
+            // Home Assistant announces its restarts here; it then needs every config again
+            mqtt.subscribe(HA_STATUS_TOPIC);
+        }
+    }
+
+    void AppController::publishBridgeInfo(const bool force) {
+        const auto config = ConfigManager::Instance().getSnapshot();
+        auto const& mqtt = MQTTClient::Instance();
+        std::string ip_addr = Wifi::Instance().getIpAddress();
+        {
+            std::lock_guard<std::mutex> lock(m_resync_mutex);
+            if (!force && ip_addr == m_published_ip) return;
+            m_published_ip = ip_addr;
+        }
+
+        std::string ip_topic = utils::stringFormat("%s/ip_addr", config->mqtt_base_topic.c_str());
+        mqtt.publish(ip_topic, ip_addr, 1, true);
+
+        std::string version_topic = utils::stringFormat("%s/version", config->mqtt_base_topic.c_str());
+        mqtt.publish(version_topic, DALIMQTT_VERSION, 1, true);
     }
 
     void AppController::onMqttDisconnected() {
@@ -175,29 +186,33 @@ namespace daliMQTT
         m_mqtt_connected = false;
     }
 
-    void AppController::publishHAMqttDiscovery() const
+    void AppController::publishHAMqttDiscovery(const bool force) const
     {
         if (!m_mqtt_connected) {
             ESP_LOGW(TAG, "Cannot publish discovery: MQTT not connected.");
             return;
         }
-        ESP_LOGI(TAG, "Publishing HA Discovery...");
-        MQTTHomeAssistantDiscovery hass_discovery;
-        hass_discovery.publishAllDevices();
+        ESP_LOGI(TAG, "Publishing HA Discovery%s...", force ? " (forced)" : "");
+        MQTTHomeAssistantDiscovery::Instance().requestPublish(force);
     }
 
     void AppController::onConfigReloadRequest() {
         ESP_LOGI(TAG, "Hot-reloading MQTT Configuration...");
-        const auto config = ConfigManager::Instance().getConfig();
-        const std::string availability_topic = utils::stringFormat("%s%s", config.mqtt_base_topic.c_str(), CONFIG_DALI2MQTT_MQTT_AVAILABILITY_TOPIC);
+        const auto config = ConfigManager::Instance().getSnapshot();
+        const std::string availability_topic = utils::stringFormat("%s%s", config->mqtt_base_topic.c_str(), CONFIG_DALI2MQTT_MQTT_AVAILABILITY_TOPIC);
+
+        // Base topic may have changed; the new session starts with a full resync
+        m_broker_synced = false;
+        DaliDeviceController::Instance().rebuildTopics();
+        DaliGroupManagement::Instance().rebuildTopics();
 
         MQTTClient::Instance().reloadConfig(
-            config.mqtt_uri,
-            config.client_id,
-            config.mqtt_user,
-            config.mqtt_pass,
+            config->mqtt_uri,
+            config->client_id,
+            config->mqtt_user,
+            config->mqtt_pass,
             availability_topic,
-            config.mqtt_ca_cert
+            config->mqtt_ca_cert
         );
     }
 } // daliMQTT
\ No newline at end of file
@@ -17,7 +17,18 @@ namespace daliMQTT
             void startNormalMode();
 
             void onConfigReloadRequest();
-            void publishHAMqttDiscovery() const;
+            /**
+             * @brief Publishes Home Assistant discovery in the background.
+             * @param force Republish configs that are unchanged since the last run.
+             */
+            void publishHAMqttDiscovery(bool force = false) const;
+
+            /**
+             * @brief Republishes everything the broker should hold and resubscribes to all commands.
+             * Reconnects that resume the broker session skip this; it runs on a fresh session and on request.
+             * @param force_discovery Also republish Home Assistant configs that did not change.
+             */
+            void resyncBroker(bool force_discovery);
 
 
         private:
@@ -32,8 +43,16 @@ namespace daliMQTT
             void onMqttConnected();
             void onMqttDisconnected();
 
+            void subscribeCommands() const;
+            /** Publishes IP and version; unless forced, only if the IP changed since the last time. */
+            void publishBridgeInfo(bool force);
+
             std::atomic<bool> m_network_connected{false};
             std::atomic<bool> m_mqtt_connected{false};
+            // Set once a full resync went out in the current broker session
+            std::atomic<bool> m_broker_synced{false};
+            std::mutex m_resync_mutex;
+            std::string m_published_ip;
     };
 } // daliMQTT
 
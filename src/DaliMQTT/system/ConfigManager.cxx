@@ -112,6 +112,7 @@ namespace daliMQTT
         ESP_LOGI(TAG, "Configured flag value: %d", configured_flag);
         config_cache.configured = (configured_flag == 1);
 
+        publishSnapshot();
         ESP_LOGI(TAG, "Configuration loaded successfully.");
         return ESP_OK;
     }
@@ -122,10 +123,17 @@ namespace daliMQTT
         const NvsHandle nvs_handle(NVS_NAMESPACE, NVS_READWRITE);
         if (!nvs_handle) return ESP_FAIL;
 
-        const esp_err_t err = write_action(nvs_handle.get());
-        if (err != ESP_OK) return err;
+        esp_err_t err = write_action(nvs_handle.get());
+        if (err == ESP_OK) {
+            err = ensureConfiguredAndCommit(nvs_handle.get());
+        }
+        // The cache may have changed even if writing failed
+        publishSnapshot();
+        return err;
+    }
 
-        return ensureConfiguredAndCommit(nvs_handle.get());
+    void ConfigManager::publishSnapshot() {
+        config_snapshot.store(std::make_shared<const AppConfig>(config_cache), std::memory_order_release);
     }
 
     esp_err_t ConfigManager::writeBasicSettings(const nvs_handle_t handle, const AppConfig& cfg) {
@@ -214,15 +222,19 @@ namespace daliMQTT
         return config_cache;
     }
 
+    ConfigSnapshot ConfigManager::getSnapshot() const {
+        return config_snapshot.load(std::memory_order_acquire);
+    }
+
     void ConfigManager::setConfig(const AppConfig& new_config) {
         std::lock_guard<std::mutex> lock(config_mutex);
         config_cache = new_config;
+        publishSnapshot();
     }
 
 
     bool ConfigManager::isConfigured() const {
-        std::lock_guard<std::mutex> lock(config_mutex);
-        return config_cache.configured;
+        return getSnapshot()->configured;
     }
 
     esp_err_t ConfigManager::getString(nvs_handle_t handle, const char* key, std::string& out_value, const char* default_value) {
@@ -271,12 +283,12 @@ namespace daliMQTT
     }
 
     std::string ConfigManager::getMqttBaseTopic() const {
-        std::lock_guard<std::mutex> lock(config_mutex);
-        return config_cache.mqtt_base_topic;
+        return getSnapshot()->mqtt_base_topic;
     }
 
     cJSON* ConfigManager::getSerializedConfig(const bool mask_passwords) const {
-        const AppConfig cfg = getConfig();
+        const auto snapshot = getSnapshot();
+        const AppConfig& cfg = *snapshot;
         cJSON* root = cJSON_CreateObject();
 
         cJSON_AddStringToObject(root, "wifi_ssid", cfg.wifi_ssid.c_str());
@@ -40,6 +40,9 @@ namespace daliMQTT
 
         bool configured{false};
     };
+    /** Immutable configuration snapshot; holders keep it alive across config updates. */
+    using ConfigSnapshot = std::shared_ptr<const AppConfig>;
+
     enum class ConfigUpdateResult {
         NoUpdate,
         MQTTUpdate,
@@ -67,8 +70,15 @@ namespace daliMQTT
 
             esp_err_t resetConfiguredFlag();
 
+            /** Returns a mutable copy of the configuration, meant for editing and saving. */
             [[nodiscard]] AppConfig getConfig() const;
 
+            /**
+             * @brief Returns the current immutable configuration snapshot.
+             * Does not take config_mutex and does not copy AppConfig, use it on every read-only path.
+             */
+            [[nodiscard]] ConfigSnapshot getSnapshot() const;
+
             [[nodiscard]] std::string getMqttBaseTopic() const;
 
             void setConfig(const AppConfig& new_config);
@@ -88,8 +98,10 @@ namespace daliMQTT
             static esp_err_t getString(nvs_handle_t handle, const char* key, std::string& out_value, const char* default_value);
             static esp_err_t getU32(nvs_handle_t handle, const char* key, uint32_t& out_value, uint32_t default_value);
             static esp_err_t setString(nvs_handle_t handle, const char* key, const std::string& value);
+            void publishSnapshot();
 
             AppConfig config_cache{};
+            std::atomic<ConfigSnapshot> config_snapshot{std::make_shared<const AppConfig>()};
             mutable std::mutex config_mutex{};
             bool initialized{false};
     };
@@ -151,9 +151,9 @@ namespace daliMQTT {
 
     esp_err_t WebUI::api::DaliGetNamesHandler(httpd_req_t *req) {
         if (checkAuth(req) != ESP_OK) return ESP_FAIL;
-        const auto cfg = ConfigManager::Instance().getConfig();
+        const auto cfg = ConfigManager::Instance().getSnapshot();
         httpd_resp_set_type(req, "application/json");
-        httpd_resp_send(req, cfg.dali_device_identificators.c_str(), HTTPD_RESP_USE_STRLEN);
+        httpd_resp_send(req, cfg->dali_device_identificators.c_str(), HTTPD_RESP_USE_STRLEN);
         return ESP_OK;
     }
 
@@ -2,6 +2,12 @@
 #include "dali/DaliAdapter.hxx"
 #include "utils/DaliLongAddrConversions.hxx"
 #include "dali/DaliDeviceController.hxx"
+#include "dali/DaliQueryPlanner.hxx"
+#include "dali/DaliGearModel.hxx"
+#include "dali/DaliGroupPlanner.hxx"
+#include "dali/DaliArcPower.hxx"
+#include "dali/DaliSceneManagement.hxx"
+#include "dali/DaliStateJournal.hxx"
 
 using namespace daliMQTT;
 
@@ -44,9 +50,260 @@ static void test_dali_controller_singleton() {
     (void)devices;
 }
 
+static void test_query_planner_minimal_plan() {
+    DevicePollPlan plan;
+
+    // Lamp off: status alone implies level 0
+    auto decision = DaliQueryPlanner::decide(plan, 0x00, false, false);
+    TEST_ASSERT_TRUE(decision.level_is_off);
+    TEST_ASSERT_FALSE(decision.query_level);
+    TEST_ASSERT_FALSE(decision.query_color);
+    DaliQueryPlanner::record(plan, 0x00, decision, false);
+
+    // Lamp turned on: escalate to level and colour
+    decision = DaliQueryPlanner::decide(plan, DaliStatusBits::LAMP_ON, false, false);
+    TEST_ASSERT_TRUE(decision.query_level);
+    TEST_ASSERT_TRUE(decision.query_color);
+    DaliQueryPlanner::record(plan, DaliStatusBits::LAMP_ON, decision, true);
+
+    // Unchanged status: STATUS only
+    decision = DaliQueryPlanner::decide(plan, DaliStatusBits::LAMP_ON, false, false);
+    TEST_ASSERT_FALSE(decision.query_level);
+    TEST_ASSERT_FALSE(decision.query_color);
+
+    // Fade running or forced poll: escalate
+    TEST_ASSERT_TRUE(DaliQueryPlanner::decide(plan, DaliStatusBits::LAMP_ON | DaliStatusBits::FADE_RUNNING, false, false).query_level);
+    TEST_ASSERT_TRUE(DaliQueryPlanner::decide(plan, DaliStatusBits::LAMP_ON, true, false).query_level);
+}
+
+static void test_query_planner_periodic_verify() {
+    DevicePollPlan plan{ .last_status = DaliStatusBits::LAMP_ON };
+    uint8_t level_queries = 0;
+    for (uint8_t i = 0; i < DaliQueryPlanner::LEVEL_VERIFY_EVERY; ++i) {
+        const auto decision = DaliQueryPlanner::decide(plan, DaliStatusBits::LAMP_ON, false, false);
+        if (decision.query_level) ++level_queries;
+        DaliQueryPlanner::record(plan, DaliStatusBits::LAMP_ON, decision, true);
+    }
+    TEST_ASSERT_EQUAL_UINT8(1, level_queries);
+}
+
+static void test_gear_model_predictions() {
+    GearModelInput gear{ .current_level = 0, .last_level = 180, .min_level = 40, .max_level = 200 };
+
+    auto p = DaliGearModel::predictCommand(gear, DALI_COMMAND_RECALL_MAX_LEVEL);
+    TEST_ASSERT_TRUE(p.kind == PredictionKind::Exact);
+    TEST_ASSERT_EQUAL_UINT8(200, p.level);
+
+    p = DaliGearModel::predictCommand(gear, DALI_COMMAND_ON_AND_STEP_UP);
+    TEST_ASSERT_EQUAL_UINT8(40, p.level);
+
+    p = DaliGearModel::predictCommand(gear, DALI_COMMAND_STEP_UP);
+    TEST_ASSERT_TRUE(p.kind == PredictionKind::NoChange);
+
+    p = DaliGearModel::predictArcPower(gear, 10);
+    TEST_ASSERT_EQUAL_UINT8(40, p.level);
+
+    gear.current_level = 40;
+    p = DaliGearModel::predictCommand(gear, DALI_COMMAND_STEP_DOWN_AND_OFF);
+    TEST_ASSERT_EQUAL_UINT8(0, p.level);
+
+    p = DaliGearModel::predictCommand(gear, DALI_COMMAND_GO_TO_SCENE_3);
+    TEST_ASSERT_TRUE(p.kind == PredictionKind::Unknown);
+
+    std::array<uint8_t, 16> scenes{};
+    scenes.fill(255);
+    scenes[3] = 250;
+    gear.scene_levels = scenes;
+    p = DaliGearModel::predictCommand(gear, DALI_COMMAND_GO_TO_SCENE_3);
+    TEST_ASSERT_TRUE(p.kind == PredictionKind::Exact);
+    TEST_ASSERT_EQUAL_UINT8(200, p.level);
+    TEST_ASSERT_TRUE(DaliGearModel::predictCommand(gear, DALI_COMMAND_GO_TO_SCENE_4).kind == PredictionKind::NoChange);
+}
+
+static void test_gear_model_fade_timing() {
+    GearModelInput gear{ .current_level = 100 };
+    TEST_ASSERT_FALSE(DaliGearModel::transitionMs(gear, 200, true).has_value());
+
+    gear.fade_time = 4;    // 2.0 s
+    gear.fade_rate = 7;
+    TEST_ASSERT_EQUAL_UINT32(2000, DaliGearModel::transitionMs(gear, 200, true).value());
+    TEST_ASSERT_EQUAL_UINT32(2000, DaliGearModel::transitionMs(gear, DALI_COMMAND_GO_TO_SCENE_1, false).value());
+    TEST_ASSERT_EQUAL_UINT32(0, DaliGearModel::transitionMs(gear, DALI_COMMAND_RECALL_MAX_LEVEL, false).value());
+    TEST_ASSERT_EQUAL_UINT32(200, DaliGearModel::transitionMs(gear, DALI_COMMAND_UP, false).value());
+
+    gear.fade_time = 0;
+    gear.extended_fade_time = 0x24; // 5 x 1 s
+    TEST_ASSERT_EQUAL_UINT32(5000, DaliGearModel::fadeTimeMs(gear).value());
+}
+
+static void test_group_planner_minimal_commands() {
+    const uint64_t floor = (uint64_t{1} << 30) - 1;     // Short addresses 0-29
+    const uint64_t present = floor | (uint64_t{1} << 40);
+    DaliGroupPlanner::MemberMasks current{};
+    current[0] = 0x3FF;                                 // Devices 0-9, unchanged
+    current[1] = floor;
+    DaliGroupPlanner::MemberMasks target = current;
+    target[1] = 0;
+    target[2] = floor;
+    target[3] = 0x3FF | (uint64_t{1} << 40);
+
+    const auto commands = DaliGroupPlanner::plan(present, current, target, true);
+    // Broadcast remove from 1; broadcast add to 2, then remove device 40; group 0 and device 40 into 3
+    TEST_ASSERT_EQUAL_UINT32(5, commands.size());
+    TEST_ASSERT_TRUE(commands.front().addr_type == DALI_ADDRESS_TYPE_BROADCAST);
+    TEST_ASSERT_FALSE(commands.front().add);
+
+    DaliGroupPlanner::MemberMasks result = current;
+    for (const auto& command : commands) DaliGroupPlanner::apply(result, present, command);
+    TEST_ASSERT_TRUE(result == target);
+
+    TEST_ASSERT_EQUAL_UINT32(0, DaliGroupPlanner::plan(present, target, target, true).size());
+
+    // Without a complete address map only group and per-device commands are used
+    const auto no_broadcast = DaliGroupPlanner::plan(present, current, target, false);
+    result = current;
+    for (const auto& command : no_broadcast) {
+        TEST_ASSERT_TRUE(command.addr_type != DALI_ADDRESS_TYPE_BROADCAST);
+        DaliGroupPlanner::apply(result, present, command);
+    }
+    TEST_ASSERT_TRUE(result == target);
+}
+
+static void test_arc_power_curve() {
+    TEST_ASSERT_EQUAL_UINT16(10, DaliArcPower::outputBasisPoints(1));        // 0.1 %
+    TEST_ASSERT_EQUAL_UINT16(10000, DaliArcPower::outputBasisPoints(254));
+    TEST_ASSERT_EQUAL_UINT8(128, DaliArcPower::logToLinear(229));            // ~50 % output
+    TEST_ASSERT_EQUAL_UINT8(1, DaliArcPower::logToLinear(1));                // Lit stays lit
+    TEST_ASSERT_EQUAL_UINT8(0, DaliArcPower::linearToLog(0));
+
+    for (int level = 1; level < 255; ++level) {
+        const auto linear = DaliArcPower::logToLinear(static_cast<uint8_t>(level));
+        TEST_ASSERT_TRUE(linear >= DaliArcPower::logToLinear(static_cast<uint8_t>(level - 1)));
+    }
+    for (int linear = 1; linear < 255; ++linear) {
+        // Adjacent arc levels are ~2.8 % apart, so the round trip lands within half of that
+        const int back = DaliArcPower::logToLinear(DaliArcPower::linearToLog(static_cast<uint8_t>(linear)));
+        TEST_ASSERT_TRUE(std::abs(back - linear) <= linear * 15 / 1000 + 1);
+    }
+
+    TEST_ASSERT_EQUAL_UINT8(9, DaliArcPower::stepsPerUpDown(DaliArcPower::DEFAULT_FADE_RATE));
+    TEST_ASSERT_EQUAL_UINT8(0, DaliArcPower::stepsPerUpDown(0));
+}
+
+static void test_scene_write_plan() {
+    const SceneDeviceLevels requested = {{1, 200}, {2, 200}, {3, 100}, {4, 255}, {5, 200}};
+    const SceneDeviceLevels cached = {{1, 200}, {3, 50}, {4, 255}};   // 2 and 5 have no cached table
+
+    const auto batches = DaliSceneManagement::planWrites(requested, cached);
+    TEST_ASSERT_EQUAL_UINT32(2, batches.size());
+    TEST_ASSERT_TRUE(batches.at(200) == std::vector<uint8_t>({2, 5}));
+    TEST_ASSERT_TRUE(batches.at(100) == std::vector<uint8_t>({3}));
+    TEST_ASSERT_TRUE(DaliSceneManagement::planWrites(cached, cached).empty());
+}
+
+static bool stateJournalKeyExists(const char* key) {
+    nvs_handle_t handle;
+    if (nvs_open("dali_state", NVS_READONLY, &handle) != ESP_OK) return false;
+    size_t size = 0;
+    const bool found = nvs_get_blob(handle, key, nullptr, &size) == ESP_OK;
+    nvs_close(handle);
+    return found;
+}
+
+static void resetStateJournal() {
+    nvs_handle_t handle;
+    TEST_ASSERT_EQUAL(ESP_OK, nvs_open("dali_state", NVS_READWRITE, &handle));
+    TEST_ASSERT_EQUAL(ESP_OK, nvs_erase_all(handle));
+    TEST_ASSERT_EQUAL(ESP_OK, nvs_commit(handle));
+    nvs_close(handle);
+    std::map<DaliLongAddress_t, DaliDevice> no_devices;
+    TEST_ASSERT_EQUAL_UINT32(0, DaliStateJournal::Instance().load(no_devices));
+}
+
+static void test_state_journal_record_encoding() {
+    ControlGear gear;
+    gear.long_address = 0x123456;
+    gear.current_level = 120;
+    gear.last_level = 200;
+    gear.status_byte = 0x04;
+
+    auto record = DaliStateJournal::makeRecord(gear);
+    TEST_ASSERT_EQUAL_HEX32(0x123456, record.long_address);
+    TEST_ASSERT_EQUAL_UINT8(120, record.current_level);
+    TEST_ASSERT_EQUAL_UINT8(200, record.last_level);
+    TEST_ASSERT_EQUAL_HEX8(0x04, record.status_byte);
+    TEST_ASSERT_EQUAL_HEX8(0x00, record.flags);
+    TEST_ASSERT_EQUAL_UINT16(0, record.color_temp);
+
+    gear.color = ColorFeatures();
+    gear.color->current_tc = 250;
+    gear.color->current_rgb = DaliRGB{10, 20, 30};
+    gear.color->active_mode = DaliColorMode::Rgb;
+    record = DaliStateJournal::makeRecord(gear);
+    TEST_ASSERT_EQUAL_HEX8(0x07, record.flags);   // has TC | has RGB | RGB mode
+    TEST_ASSERT_EQUAL_UINT16(250, record.color_temp);
+    TEST_ASSERT_EQUAL_UINT8(10, record.r);
+    TEST_ASSERT_EQUAL_UINT8(20, record.g);
+    TEST_ASSERT_EQUAL_UINT8(30, record.b);
+}
+
+static void test_state_journal_rotation_and_compaction() {
+    resetStateJournal();
+    auto& journal = DaliStateJournal::Instance();
+    ControlGear gear;
+    gear.long_address = 0x0A0B0C;
+
+    // Eight changes fill the delta ring rtJ1..rtJ7, rtJ0 without touching the base.
+    std::array<char, 8> key{};
+    for (uint8_t seq = 1; seq <= 8; ++seq) {
+        gear.current_level = seq;
+        const auto record = DaliStateJournal::makeRecord(gear);
+        TEST_ASSERT_EQUAL(ESP_OK, journal.commit({record}, {record}));
+        snprintf(key.data(), key.size(), "rtJ%u", seq % 8);
+        TEST_ASSERT_TRUE(stateJournalKeyExists(key.data()));
+        TEST_ASSERT_FALSE(stateJournalKeyExists("rtBase"));
+    }
+
+    // An unchanged record is not written and does not use up a sequence number.
+    auto record = DaliStateJournal::makeRecord(gear);
+    TEST_ASSERT_EQUAL(ESP_OK, journal.commit({record}, {record}));
+    TEST_ASSERT_FALSE(stateJournalKeyExists("rtBase"));
+
+    // The ninth change no longer fits the ring and is compacted into the base.
+    gear.current_level = 9;
+    record = DaliStateJournal::makeRecord(gear);
+    TEST_ASSERT_EQUAL(ESP_OK, journal.commit({record}, {record}));
+    TEST_ASSERT_TRUE(stateJournalKeyExists("rtBase"));
+
+    std::map<DaliLongAddress_t, DaliDevice> devices{{gear.long_address, ControlGear{}}};
+    std::get<ControlGear>(devices.at(gear.long_address)).long_address = gear.long_address;
+    TEST_ASSERT_EQUAL_UINT32(1, journal.load(devices));
+    TEST_ASSERT_EQUAL_UINT8(9, std::get<ControlGear>(devices.at(gear.long_address)).current_level);
+
+    // Segments older than the base are ignored on replay, newer ones win over it.
+    gear.current_level = 10;
+    record = DaliStateJournal::makeRecord(gear);
+    TEST_ASSERT_EQUAL(ESP_OK, journal.commit({record}, {record}));
+    TEST_ASSERT_EQUAL_UINT32(1, journal.load(devices));
+    const auto& restored = std::get<ControlGear>(devices.at(gear.long_address));
+    TEST_ASSERT_EQUAL_UINT8(10, restored.current_level);
+    TEST_ASSERT_TRUE(restored.state_restored);
+
+    resetStateJournal();
+}
+
 void run_dali_logic_tests() {
     RUN_TEST(test_long_addr_conversion);
     RUN_TEST(test_string_to_long_addr);
     RUN_TEST(test_dali_driver_init);
     RUN_TEST(test_dali_controller_singleton);
+    RUN_TEST(test_query_planner_minimal_plan);
+    RUN_TEST(test_query_planner_periodic_verify);
+    RUN_TEST(test_gear_model_predictions);
+    RUN_TEST(test_gear_model_fade_timing);
+    RUN_TEST(test_group_planner_minimal_commands);
+    RUN_TEST(test_arc_power_curve);
+    RUN_TEST(test_scene_write_plan);
+    RUN_TEST(test_state_journal_record_encoding);
+    RUN_TEST(test_state_journal_rotation_and_compaction);
 }
\ No newline at end of file
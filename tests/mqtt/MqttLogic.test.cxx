@@ -1,7 +1,14 @@
 #include "unity.h"
 #include "mqtt/MQTTClient.hxx"
 #include "mqtt/MQTTCommandProcess.hxx"
+#include "mqtt/MQTTCommandHandler.hxx"
+#include "mqtt/MQTTTopicRouter.hxx"
+#include "mqtt/MQTTOutbox.hxx"
 #include "system/ConfigManager.hxx"
+#include "mqtt/MQTTBusSnapshot.hxx"
+#include "utils/JsonWriter.hxx"
+#include "utils/PayloadWriter.hxx"
+#include "utils/TokenBucket.hxx"
 
 using namespace daliMQTT;
 
@@ -26,7 +33,305 @@ static void test_command_processor_queue() {
     TEST_ASSERT_TRUE(result);
 }
 
+static void test_json_writer_payloads() {
+    utils::StaticJsonWriter<96> json;
+    json.beginObject()
+        .add("state", "ON")
+        .add("brightness", static_cast<uint8_t>(254))
+        .beginObject("color").add("r", 1).add("g", 2).add("b", 3).endObject()
+        .beginArray("groups").element(0).element(15).endArray()
+        .add("gtin", "a\"b")
+        .endObject();
+    TEST_ASSERT_TRUE(json.ok());
+    TEST_ASSERT_EQUAL_STRING(R"({"state":"ON","brightness":254,"color":{"r":1,"g":2,"b":3},"groups":[0,15],"gtin":"a\"b"})", json.c_str());
+
+    utils::StaticJsonWriter<8> small;
+    small.beginObject().add("brightness", 254).endObject();
+    TEST_ASSERT_FALSE(small.ok());
+    TEST_ASSERT_TRUE(small.view().size() < 8);
+}
+
+static void test_bus_snapshot_payload() {
+    BusSnapshotEntries entries{};
+    entries[0] = {.present = true, .available = true, .level = 254, .status_byte = 0x04};
+    entries[5] = {.present = true, .available = false, .level = 0, .status_byte = 0x02,
+                  .color_temp = 370, .rgb = DaliRGB{255, 0, 16}};
+
+    utils::StaticPayloadWriter<256> writer(utils::PayloadFormat::Json);
+    TEST_ASSERT_TRUE(MQTTBusSnapshot::serialize(writer, 7, entries));
+    TEST_ASSERT_EQUAL_STRING(R"({"v":1,"seq":7,"avail":"0000000000000001","d":[[0,254,4,-1,-1],[5,0,2,370,16711696]]})",
+                             std::string(writer.view()).c_str());
+}
+
+static void test_binary_payload_encodings() {
+    const auto encode = [](const utils::PayloadFormat format) {
+        utils::StaticPayloadWriter<64> writer(format);
+        writer.beginObject()
+            .add("a", 5)
+            .add("n", -200)
+            .add("on", true)
+            .beginArray("l").element(300).endArray()
+            .endObject();
+        TEST_ASSERT_TRUE(writer.ok());
+        return std::string(writer.view());
+    };
+
+    const std::string cbor = encode(utils::PayloadFormat::Cbor);
+    const uint8_t cbor_expected[] = {0xA4, 0x61, 'a', 0x05, 0x61, 'n', 0x38, 0xC7,
+                                     0x62, 'o', 'n', 0xF5, 0x61, 'l', 0x81, 0x19, 0x01, 0x2C};
+    TEST_ASSERT_EQUAL(sizeof(cbor_expected), cbor.size());
+    TEST_ASSERT_EQUAL_MEMORY(cbor_expected, cbor.data(), sizeof(cbor_expected));
+
+    const std::string msgpack = encode(utils::PayloadFormat::MsgPack);
+    const uint8_t msgpack_expected[] = {0x84, 0xA1, 'a', 0x05, 0xA1, 'n', 0xD1, 0xFF, 0x38,
+                                        0xA2, 'o', 'n', 0xC3, 0xA1, 'l', 0x91, 0xCD, 0x01, 0x2C};
+    TEST_ASSERT_EQUAL(sizeof(msgpack_expected), msgpack.size());
+    TEST_ASSERT_EQUAL_MEMORY(msgpack_expected, msgpack.data(), sizeof(msgpack_expected));
+
+    // More entries than the one-byte header can count: the header is widened in place
+    utils::StaticPayloadWriter<64> wide(utils::PayloadFormat::MsgPack);
+    wide.beginArray();
+    for (int i = 0; i < 20; ++i) wide.element(i);
+    wide.endArray();
+    TEST_ASSERT_TRUE(wide.ok());
+    TEST_ASSERT_EQUAL(23, wide.view().size());
+    TEST_ASSERT_EQUAL_HEX8(0xDC, static_cast<uint8_t>(wide.view()[0]));
+    TEST_ASSERT_EQUAL_HEX8(19, static_cast<uint8_t>(wide.view()[22]));
+}
+
+static void test_token_bucket_pacing() {
+    utils::TokenBucket bucket(2, 10);
+
+    // Burst passes, then one token per 100 ms
+    TEST_ASSERT_EQUAL(0, bucket.tryAcquire(1000));
+    TEST_ASSERT_EQUAL(0, bucket.tryAcquire(1000));
+    TEST_ASSERT_EQUAL(100, bucket.tryAcquire(1000));
+    TEST_ASSERT_EQUAL(50, bucket.tryAcquire(1050));
+    TEST_ASSERT_EQUAL(0, bucket.tryAcquire(1100));
+
+    // Refill is capped at the burst size
+    TEST_ASSERT_EQUAL(0, bucket.tryAcquire(10000));
+    TEST_ASSERT_EQUAL(0, bucket.tryAcquire(10000));
+    TEST_ASSERT_TRUE(bucket.tryAcquire(10000) > 0);
+}
+
+static void test_light_command_parser() {
+    // Not null-terminated: the handler reads straight from the ring buffer
+    const char raw[] = R"({"state":"ON", "brightness": 300, "color":{"r":255,"g":10,"b":0},"effect":[1,{"x":"}"}],"transition":1.5}garbage)";
+    const std::string_view payload(raw, sizeof(raw) - 1 - 7);
+
+    const auto command = MQTTCommandHandler::parseLightCommand(payload);
+    TEST_ASSERT_TRUE(command.has_value());
+    TEST_ASSERT_TRUE(command->on.value_or(false));
+    TEST_ASSERT_EQUAL(254, command->level.value_or(0));
+    TEST_ASSERT_FALSE(command->color_temp.has_value());
+    TEST_ASSERT_TRUE(command->rgb.has_value());
+    TEST_ASSERT_EQUAL(255, command->rgb->r);
+    TEST_ASSERT_EQUAL(10, command->rgb->g);
+    TEST_ASSERT_EQUAL(0, command->rgb->b);
+    TEST_ASSERT_EQUAL(1500, command->transition_ms.value_or(0));
+
+    const auto off = MQTTCommandHandler::parseLightCommand(R"({"state":"OFF","color_temp":370})");
+    TEST_ASSERT_TRUE(off.has_value());
+    TEST_ASSERT_FALSE(off->on.value_or(true));
+    TEST_ASSERT_EQUAL(370, off->color_temp.value_or(0));
+
+    TEST_ASSERT_FALSE(MQTTCommandHandler::parseLightCommand(R"({"state":"ON")").has_value());
+    TEST_ASSERT_FALSE(MQTTCommandHandler::parseLightCommand("ON").has_value());
+}
+
+static void test_light_command_merge() {
+    // Slider history collapses to the final level
+    LightCommand pending{.on = true, .level = 20};
+    pending.merge({.on = true, .level = 120});
+    pending.merge({.on = true, .level = 200});
+    TEST_ASSERT_TRUE(pending.on.value_or(false));
+    TEST_ASSERT_EQUAL(200, pending.level.value_or(0));
+
+    // OFF drops the earlier level, a bare level afterwards is a level change again
+    pending.merge({.on = false});
+    TEST_ASSERT_FALSE(pending.level.has_value());
+    pending.merge({.level = 80});
+    TEST_ASSERT_FALSE(pending.on.has_value());
+    TEST_ASSERT_EQUAL(80, pending.level.value_or(0));
+
+    // Newest colour mode wins
+    pending.merge({.color_temp = 300});
+    pending.merge({.rgb = DaliRGB{1, 2, 3}});
+    TEST_ASSERT_FALSE(pending.color_temp.has_value());
+    TEST_ASSERT_TRUE(pending.rgb.has_value());
+    TEST_ASSERT_EQUAL(80, pending.level.value_or(0));
+}
+
+static void test_light_command_group_override() {
+    // short 5 level 100, then group 0 level 50: the held short command has nothing left of its own
+    LightCommand short_five{.level = 100};
+    TEST_ASSERT_FALSE(short_five.dropOverridden({.level = 50}));
+
+    // A later color_temp for short 5 then starts from scratch and cannot restore level 100
+    LightCommand after{.level = 100, .color_temp = 300};
+    TEST_ASSERT_TRUE(after.dropOverridden({.on = true, .level = 50}));
+    TEST_ASSERT_FALSE(after.level.has_value());
+    TEST_ASSERT_FALSE(after.on.has_value());
+    TEST_ASSERT_EQUAL(300, after.color_temp.value_or(0));
+
+    // Fields the wider command leaves alone stay; a colour of either mode overrides both
+    LightCommand colour{.on = true, .level = 80, .rgb = DaliRGB{1, 2, 3}};
+    TEST_ASSERT_TRUE(colour.dropOverridden({.color_temp = 370}));
+    TEST_ASSERT_FALSE(colour.rgb.has_value());
+    TEST_ASSERT_EQUAL(80, colour.level.value_or(0));
+    TEST_ASSERT_TRUE(colour.dropOverridden({.on = true}));
+    TEST_ASSERT_EQUAL(80, colour.level.value_or(0));
+    TEST_ASSERT_FALSE(colour.dropOverridden({.on = false}));
+}
+
+static void test_raw_frame_parser() {
+    cJSON* hex = cJSON_CreateString("FF90");
+    const auto compact = MQTTCommandHandler::parseRawFrame(hex);
+    TEST_ASSERT_TRUE(compact.has_value());
+    TEST_ASSERT_EQUAL_HEX32(0xFF90, compact->data);
+    TEST_ASSERT_EQUAL(16, compact->bits);
+    TEST_ASSERT_FALSE(compact->reply);
+    cJSON_Delete(hex);
+
+    cJSON* hex24 = cJSON_CreateString("FFFE05");
+    TEST_ASSERT_EQUAL(24, MQTTCommandHandler::parseRawFrame(hex24).value_or(RawFrame{}).bits);
+    cJSON_Delete(hex24);
+    for (const char* bad : {"FF9", "GG90", "FF90FF90"}) {
+        cJSON* item = cJSON_CreateString(bad);
+        TEST_ASSERT_FALSE(MQTTCommandHandler::parseRawFrame(item).has_value());
+        cJSON_Delete(item);
+    }
+
+    cJSON* object = cJSON_Parse(R"({"addr":11,"cmd":46,"twice":true,"reply":true,"settle_ms":5000})");
+    const auto frame = MQTTCommandHandler::parseRawFrame(object);
+    TEST_ASSERT_TRUE(frame.has_value());
+    TEST_ASSERT_EQUAL_HEX32(0x0B2E, frame->data);
+    TEST_ASSERT_TRUE(frame->twice);
+    TEST_ASSERT_TRUE(frame->reply);
+    TEST_ASSERT_EQUAL(1000, frame->settle_ms);      // Clamped to MAX_SETTLE_MS
+    TEST_ASSERT_EQUAL_UINT32(2 * RawFrame::FRAME_WORST_CASE_MS + 1000, frame->worstCaseBusMs());
+    cJSON_Delete(object);
+
+    cJSON* input_device = cJSON_Parse(R"({"addr":511,"cmd":1})");
+    const auto frame24 = MQTTCommandHandler::parseRawFrame(input_device);
+    TEST_ASSERT_EQUAL(24, frame24.value_or(RawFrame{}).bits);
+    TEST_ASSERT_EQUAL_HEX32(0x01FF01, frame24.value_or(RawFrame{}).data);
+    cJSON_Delete(input_device);
+
+    for (const char* bad : {R"({"addr":5})", R"({"addr":5,"cmd":144,"bits":17})", "[1,2]"}) {
+        cJSON* item = cJSON_Parse(bad);
+        TEST_ASSERT_FALSE(MQTTCommandHandler::parseRawFrame(item).has_value());
+        cJSON_Delete(item);
+    }
+
+    // A full batch of plain frames fits the bus time limit
+    TEST_ASSERT_TRUE(MQTTCommandHandler::MAX_BATCH_FRAMES * RawFrame{}.worstCaseBusMs() <= MQTTCommandHandler::MAX_BATCH_BUS_MS);
+}
+
+static void test_batch_reply_fits_outbox() {
+    const std::vector<RawFrameResult> small{{std::nullopt, false, 21000}, {std::nullopt, true, 49000}, {40, true, 30000}};
+    cJSON* reply = MQTTCommandHandler::buildBatchReply(nullptr, small, 100000);
+    char* printed = cJSON_PrintUnformatted(reply);
+    TEST_ASSERT_EQUAL_STRING(R"({"status":"ok","count":3,"total_us":100000,"us":[21000,49000,30000],"responses":[null,-1,40]})", printed);
+    free(printed);
+    cJSON_Delete(reply);
+
+    // Largest batch, longest durations, a tag as long as the receive buffer leaves room for
+    const std::vector<RawFrameResult> full(MQTTCommandHandler::MAX_BATCH_FRAMES, RawFrameResult{std::nullopt, false, UINT32_MAX});
+    cJSON* tag = cJSON_CreateString(std::string(240, 't').c_str());
+    reply = MQTTCommandHandler::buildBatchReply(tag, full, UINT32_MAX);
+    printed = cJSON_PrintUnformatted(reply);
+    TEST_ASSERT_NOT_NULL(printed);
+    TEST_ASSERT_TRUE(strlen(printed) <= MQTTCommandHandler::MAX_BATCH_REPLY_SIZE);
+    free(printed);
+    cJSON_Delete(reply);
+    cJSON_Delete(tag);
+}
+
+static int s_route_hits = 0;
+static RouteParams s_route_params;
+
+static void test_topic_router_dispatch() {
+    MQTTTopicRouter router;
+    const RouteHandler record = [](const RouteParams& params, std::string_view) {
+        ++s_route_hits;
+        s_route_params = params;
+    };
+    TEST_ASSERT_TRUE(router.add("light/{long}/set", record));
+    TEST_ASSERT_TRUE(router.add("light/group/{group}/set", record));
+    TEST_ASSERT_TRUE(router.add("/config/group/set", record));
+    TEST_ASSERT_FALSE(router.add("light/{long}/set", record));
+
+    s_route_hits = 0;
+    TEST_ASSERT_TRUE(router.dispatch("/light/00AB12/set", "{}"));
+    TEST_ASSERT_EQUAL_HEX32(0x00AB12, s_route_params.long_addr);
+    TEST_ASSERT_TRUE(router.dispatch("/light/group/15/set", "{}"));
+    TEST_ASSERT_EQUAL(15, s_route_params.group_id);
+    TEST_ASSERT_TRUE(router.dispatch("config/group/set", "{}"));
+    TEST_ASSERT_EQUAL(3, s_route_hits);
+    TEST_ASSERT_TRUE(s_route_params.properties.response_topic.empty());
+
+    // MQTT 5 request properties reach the handler
+    const MessageProperties properties{"client/reply", "\x01\x02"};
+    TEST_ASSERT_TRUE(router.dispatch("config/group/set", "{}", properties));
+    TEST_ASSERT_EQUAL_STRING_LEN("client/reply", s_route_params.properties.response_topic.data(), 12);
+    TEST_ASSERT_EQUAL(2, s_route_params.properties.correlation_data.size());
+    TEST_ASSERT_EQUAL(4, s_route_hits);
+
+    TEST_ASSERT_FALSE(router.dispatch("/light/group/16/set", "{}"));
+    TEST_ASSERT_FALSE(router.dispatch("/light/XYZ/set", "{}"));
+    TEST_ASSERT_FALSE(router.dispatch("/light/00AB12/state", "{}"));
+    TEST_ASSERT_FALSE(router.dispatch("/light/00AB12", "{}"));
+    TEST_ASSERT_EQUAL(4, s_route_hits);
+
+    const auto filters = router.subscriptionFilters("dali");
+    TEST_ASSERT_EQUAL(3, filters.size());
+    TEST_ASSERT_EQUAL_STRING("dali/light/+/set", filters[0].c_str());
+    TEST_ASSERT_EQUAL_STRING("dali/light/group/+/set", filters[1].c_str());
+}
+
+static void test_last_value_cache() {
+    MQTTLastValueCache cache(2);
+
+    TEST_ASSERT_TRUE(cache.put("dali/light/A/state", "{\"state\":\"ON\"}", 0, 10));
+    // A newer value replaces the cached one, an older one does not
+    TEST_ASSERT_TRUE(cache.put("dali/light/A/state", "{\"state\":\"OFF\"}", 0, 12));
+    TEST_ASSERT_TRUE(cache.put("dali/light/A/state", "{\"state\":\"ON\"}", 0, 11));
+    TEST_ASSERT_TRUE(cache.put("dali/light/B/state", "{}", 1, 13));
+    TEST_ASSERT_FALSE(cache.put("dali/light/C/state", "{}", 0, 14));
+    TEST_ASSERT_EQUAL(2, cache.size());
+
+    // Sending a newer value directly makes the cached one obsolete
+    cache.eraseOlder("dali/light/B/state", 12);
+    TEST_ASSERT_EQUAL(2, cache.size());
+    cache.eraseOlder("dali/light/B/state", 15);
+    TEST_ASSERT_EQUAL(1, cache.size());
+
+    const auto entry = cache.pop();
+    TEST_ASSERT_TRUE(entry.has_value());
+    TEST_ASSERT_EQUAL_STRING("dali/light/A/state", entry->topic.c_str());
+    TEST_ASSERT_EQUAL_STRING("{\"state\":\"OFF\"}", entry->payload.c_str());
+    TEST_ASSERT_FALSE(cache.pop().has_value());
+
+    // Sequence numbers wrap around
+    TEST_ASSERT_TRUE(cache.put("dali/light/A/state", "old", 0, 0xFFFFFFFF));
+    TEST_ASSERT_TRUE(cache.put("dali/light/A/state", "new", 0, 1));
+    TEST_ASSERT_EQUAL_STRING("new", cache.pop()->payload.c_str());
+}
+
 void run_mqtt_logic_tests() {
     RUN_TEST(test_mqtt_client_init_state);
     RUN_TEST(test_command_processor_queue);
+    RUN_TEST(test_json_writer_payloads);
+    RUN_TEST(test_bus_snapshot_payload);
+    RUN_TEST(test_binary_payload_encodings);
+    RUN_TEST(test_token_bucket_pacing);
+    RUN_TEST(test_light_command_parser);
+    RUN_TEST(test_raw_frame_parser);
+    RUN_TEST(test_batch_reply_fits_outbox);
+    RUN_TEST(test_topic_router_dispatch);
+    RUN_TEST(test_light_command_merge);
+    RUN_TEST(test_light_command_group_override);
+    RUN_TEST(test_last_value_cache);
 }
\ No newline at end of file